@@ -0,0 +1,119 @@
+#include <bench/bench.h>
+
+#include <omnicore/dbtradelist.h>
+#include <omnicore/mdex.h>
+#include <omnicore/omnicore.h>
+#include <omnicore/tally.h>
+#include <omnicore/tx.h>
+
+#include <arith_uint256.h>
+#include <sync.h>
+#include <uint256.h>
+#include <util/system.h>
+
+#include <assert.h>
+#include <stdint.h>
+#include <string>
+
+using namespace mastercore;
+
+//! Property offered by the resting orders; trades with property 1 pay no fees
+static const uint32_t BENCH_PROPERTY_FORSALE = 3;
+static const uint32_t BENCH_PROPERTY_DESIRED = 1;
+//! Number of price levels of the order book
+static const int BENCH_PRICE_LEVELS = 1000;
+//! Number of orders filled by a single order
+static const int BENCH_SWEEP_ORDERS = 20;
+
+static uint256 BenchTxid(uint64_t n)
+{
+    return ArithToUint256(arith_uint256(n));
+}
+
+// Inserts orders at distinct price levels into an empty order book.
+static void MetaDExInsert(benchmark::State& state)
+{
+    LOCK(cs_tally);
+    uint64_t nTx = 0;
+    while (state.KeepRunning()) {
+        for (int i = 0; i < BENCH_PRICE_LEVELS; ++i) {
+            CMPMetaDEx order("seller", 1, BENCH_PROPERTY_FORSALE, 1000 + i, BENCH_PROPERTY_DESIRED, 1000, BenchTxid(++nTx), i, CMPTransaction::ADD);
+            MetaDEx_INSERT(order);
+        }
+        metadex.clear();
+    }
+}
+
+// Adds an order, which is filled completely by the next order on the other
+// side of the market, while the order book holds orders at higher prices.
+static void MetaDExMatch(benchmark::State& state)
+{
+    // trades are recorded in the database opened by the testing setup
+    assert(pDbTradeList != nullptr);
+    {
+        LOCK(cs_tally);
+        const std::string seller = "seller";
+        const std::string buyer = "buyer";
+        const int64_t nBalance = 100000000000000000LL;
+        bool fUpdated = update_tally_map(seller, BENCH_PROPERTY_FORSALE, nBalance, BALANCE);
+        fUpdated &= update_tally_map(buyer, BENCH_PROPERTY_DESIRED, nBalance, BALANCE);
+        assert(fUpdated);
+
+        int block = 1;
+        uint64_t nTx = 0;
+        for (int i = 0; i < BENCH_PRICE_LEVELS; ++i) {
+            MetaDEx_ADD(seller, BENCH_PROPERTY_FORSALE, 1000, block, BENCH_PROPERTY_DESIRED, 1001 + i, BenchTxid(++nTx), i);
+        }
+
+        while (state.KeepRunning()) {
+            ++block;
+            MetaDEx_ADD(seller, BENCH_PROPERTY_FORSALE, 1000, block, BENCH_PROPERTY_DESIRED, 1000, BenchTxid(++nTx), 0);
+            MetaDEx_ADD(buyer, BENCH_PROPERTY_DESIRED, 1000, block, BENCH_PROPERTY_FORSALE, 1000, BenchTxid(++nTx), 1);
+        }
+
+        metadex.clear();
+        ClearTallyMap();
+    }
+    // remove the recorded trades, so the database is left as it was
+    pDbTradeList->deleteAboveBlock(0);
+}
+
+// Adds an order, which fills several orders at the best price, while the order
+// book holds orders at higher prices.
+static void MetaDExSweep(benchmark::State& state)
+{
+    // trades are recorded in the database opened by the testing setup
+    assert(pDbTradeList != nullptr);
+    {
+        LOCK(cs_tally);
+        const std::string seller = "seller";
+        const std::string buyer = "buyer";
+        const int64_t nBalance = 100000000000000000LL;
+        bool fUpdated = update_tally_map(seller, BENCH_PROPERTY_FORSALE, nBalance, BALANCE);
+        fUpdated &= update_tally_map(buyer, BENCH_PROPERTY_DESIRED, nBalance, BALANCE);
+        assert(fUpdated);
+
+        int block = 1;
+        uint64_t nTx = 0;
+        for (int i = 0; i < BENCH_PRICE_LEVELS; ++i) {
+            MetaDEx_ADD(seller, BENCH_PROPERTY_FORSALE, 1000, block, BENCH_PROPERTY_DESIRED, 1001 + i, BenchTxid(++nTx), i);
+        }
+
+        while (state.KeepRunning()) {
+            ++block;
+            for (int i = 0; i < BENCH_SWEEP_ORDERS; ++i) {
+                MetaDEx_ADD(seller, BENCH_PROPERTY_FORSALE, 1000, block, BENCH_PROPERTY_DESIRED, 1000, BenchTxid(++nTx), i);
+            }
+            MetaDEx_ADD(buyer, BENCH_PROPERTY_DESIRED, 1000 * BENCH_SWEEP_ORDERS, block, BENCH_PROPERTY_FORSALE, 1000 * BENCH_SWEEP_ORDERS, BenchTxid(++nTx), BENCH_SWEEP_ORDERS);
+        }
+
+        metadex.clear();
+        ClearTallyMap();
+    }
+    // remove the recorded trades, so the database is left as it was
+    pDbTradeList->deleteAboveBlock(0);
+}
+
+BENCHMARK(MetaDExInsert, 50);
+BENCHMARK(MetaDExMatch, 5000);
+BENCHMARK(MetaDExSweep, 500);
@@ -0,0 +1,43 @@
+#include <bench/bench.h>
+
+#include <omnicore/nftdb.h>
+
+#include <util/system.h>
+
+#include <assert.h>
+#include <stdint.h>
+#include <string>
+
+//! Non-fungible property used by the benchmark
+static const uint32_t BENCH_PROPERTY = 50;
+//! Number of token ranges
+static const int BENCH_RANGES = 10000;
+//! Number of tokens per range
+static const int64_t BENCH_RANGE_SIZE = 10;
+
+// Moves a single token out of a range, which is split, and back, which merges the ranges again.
+static void OmniMoveNonFungibleTokens(benchmark::State& state)
+{
+    CMPNonFungibleTokensDB* pNftDb = new CMPNonFungibleTokensDB(GetDataDir() / "OMNI_nftdb_bench", true);
+
+    // ranges of alternating owners, so they are not merged
+    const std::string owners[2] = {"alice", "bob"};
+    for (int n = 0; n < BENCH_RANGES; ++n) {
+        pNftDb->CreateNonFungibleTokens(BENCH_PROPERTY, BENCH_RANGE_SIZE, owners[n % 2], "");
+    }
+
+    uint64_t nMove = 0;
+    while (state.KeepRunning()) {
+        const int nRange = (nMove++ * 7919) % BENCH_RANGES;
+        const int64_t tokenId = nRange * BENCH_RANGE_SIZE + BENCH_RANGE_SIZE / 2;
+        const std::string& owner = owners[nRange % 2];
+
+        bool fMoved = pNftDb->MoveNonFungibleTokens(BENCH_PROPERTY, tokenId, tokenId, owner, "carol");
+        fMoved &= pNftDb->MoveNonFungibleTokens(BENCH_PROPERTY, tokenId, tokenId, "carol", owner);
+        assert(fMoved);
+    }
+
+    delete pNftDb;
+}
+
+BENCHMARK(OmniMoveNonFungibleTokens, 5000);
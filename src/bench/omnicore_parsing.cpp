@@ -0,0 +1,140 @@
+#include <bench/bench.h>
+
+#include <omnicore/createpayload.h>
+#include <omnicore/dbspinfo.h>
+#include <omnicore/encoding.h>
+#include <omnicore/omnicore.h>
+#include <omnicore/parsing.h>
+#include <omnicore/sp.h>
+#include <omnicore/tx.h>
+
+#include <arith_uint256.h>
+#include <coins.h>
+#include <key.h>
+#include <key_io.h>
+#include <primitives/transaction.h>
+#include <pubkey.h>
+#include <script/script.h>
+#include <script/standard.h>
+#include <sync.h>
+#include <uint256.h>
+#include <util/system.h>
+
+#include <assert.h>
+#include <stdint.h>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace mastercore;
+
+/** Creates a transaction with the given outputs, spending a coin of the sender, which is added to the coins view. */
+static CTransaction BenchOmniTx(const std::string& sender, const std::vector<std::pair<CScript, int64_t> >& vecOutputs)
+{
+    CMutableTransaction inputTx;
+    inputTx.vout.push_back(CTxOut(100000000, GetScriptForDestination(DecodeDestination(sender))));
+    const CTransaction txPrev(inputTx);
+
+    Coin coin;
+    coin.out = txPrev.vout[0];
+    coin.nHeight = 1;
+    {
+        LOCK(cs_tx_cache);
+        view.AddCoin(COutPoint(txPrev.GetHash(), 0), std::move(coin), true);
+    }
+
+    CMutableTransaction mutableTx;
+    mutableTx.vin.push_back(CTxIn(txPrev.GetHash(), 0));
+    for (const auto& output : vecOutputs) {
+        mutableTx.vout.push_back(CTxOut(output.second, output.first));
+    }
+    mutableTx.vout.push_back(CTxOut(50000, GetScriptForDestination(DecodeDestination(sender))));
+
+    return CTransaction(mutableTx);
+}
+
+/** Returns a new address and its public key. */
+static std::string BenchAddress(CPubKey& pubKey)
+{
+    CKey key;
+    key.MakeNewKey(true);
+    pubKey = key.GetPubKey();
+    return EncodeDestination(PKHash(pubKey));
+}
+
+// Prepares the hashes, which are used to deobfuscate the packets of a class B transaction.
+//
+// ParseTransaction() can't be measured for class B: the Exodus marker address of
+// neither network decodes with the address prefixes of this chain, so no class B
+// transaction is detected, and parsing stops before the packets are deobfuscated.
+static void OmniDeobfuscateClassB(benchmark::State& state)
+{
+    CPubKey pubKey;
+    const std::string sender = BenchAddress(pubKey);
+
+    // a create crowdsale payload spans several multisig packets
+    std::vector<unsigned char> vchPayload = CreatePayload_IssuanceVariable(1, 1, 0, "Companies", "Bitcoin Mining", "Quantum Miner", "tokens.xep.net", "Tokens for the benchmark", 1, 100, 1483228800, 30, 0);
+    const int nPackets = (vchPayload.size() + PACKET_SIZE - 1) / PACKET_SIZE;
+
+    while (state.KeepRunning()) {
+        std::string strObfuscatedHashes[1+MAX_SHA256_OBFUSCATION_TIMES];
+        PrepareObfuscatedHashes(sender, 1+nPackets, strObfuscatedHashes);
+    }
+}
+
+// Identifies the sender and extracts the payload of a class C transaction.
+static void OmniParseClassC(benchmark::State& state)
+{
+    CPubKey pubKey;
+    const std::string sender = BenchAddress(pubKey);
+    const std::string receiver = BenchAddress(pubKey);
+
+    std::vector<unsigned char> vchPayload = CreatePayload_SimpleSend(OMNI_PROPERTY_MSC, 100000000);
+    std::vector<std::pair<CScript, int64_t> > vecOutputs;
+    bool fEncoded = OmniCore_Encode_ClassC(vchPayload, vecOutputs);
+    assert(fEncoded);
+    vecOutputs.push_back(std::make_pair(GetScriptForDestination(DecodeDestination(receiver)), 546));
+    const CTransaction tx = BenchOmniTx(sender, vecOutputs);
+
+    while (state.KeepRunning()) {
+        CMPTransaction mp_obj;
+        int nResult = ParseTransaction(tx, 0, 1, mp_obj);
+        assert(nResult == 0);
+        assert(mp_obj.getEncodingClass() == OMNI_CLASS_C);
+    }
+}
+
+// Interprets and executes simple sends, which move tokens back and forth.
+static void OmniInterpretPacket(benchmark::State& state)
+{
+    // properties are looked up in the database opened by the testing setup
+    assert(pDbSpInfo != nullptr);
+    {
+        LOCK(cs_tally);
+        bool fUpdated = update_tally_map("sender", OMNI_PROPERTY_MSC, 100000000, BALANCE);
+        assert(fUpdated);
+    }
+
+    std::vector<unsigned char> vchPayload = CreatePayload_SimpleSend(OMNI_PROPERTY_MSC, 100000000);
+    const std::string addresses[2] = {"sender", "receiver"};
+
+    uint64_t nTx = 0;
+    while (state.KeepRunning()) {
+        const uint256 txid = ArithToUint256(arith_uint256(nTx + 1));
+        CMPTransaction mp_obj;
+        mp_obj.Set(addresses[nTx % 2], addresses[(nTx + 1) % 2], 0, txid, 0, 1, vchPayload.data(), vchPayload.size(), OMNI_CLASS_C, 0);
+        mp_obj.unlockLogic();
+        int nResult = mp_obj.interpretPacket();
+        assert(nResult == 0);
+        ++nTx;
+    }
+
+    {
+        LOCK(cs_tally);
+        ClearTallyMap();
+    }
+}
+
+BENCHMARK(OmniDeobfuscateClassB, 20 * 1000);
+BENCHMARK(OmniParseClassC, 50 * 1000);
+BENCHMARK(OmniInterpretPacket, 100 * 1000);
@@ -0,0 +1,144 @@
+#include <bench/bench.h>
+
+#include <omnicore/consensushash.h>
+#include <omnicore/dbspinfo.h>
+#include <omnicore/omnicore.h>
+#include <omnicore/persistence.h>
+#include <omnicore/sp.h>
+#include <omnicore/sto.h>
+#include <omnicore/tally.h>
+
+#include <chain.h>
+#include <fs.h>
+#include <sync.h>
+#include <tinyformat.h>
+#include <uint256.h>
+#include <util/system.h>
+#include <validation.h>
+
+#include <assert.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+using namespace mastercore;
+
+//! Path for file based persistence
+extern fs::path pathStateFiles;
+
+//! Property held by the synthetic addresses
+static const uint32_t BENCH_PROPERTY = 3;
+//! Number of addresses of the synthetic tally state
+static const int BENCH_TALLY_ADDRESSES = 1000000;
+//! Number of holders for distributions, consensus hashing and persistence
+static const int BENCH_HOLDERS = 10000;
+
+/** Returns the address of the n-th synthetic holder. */
+static std::string BenchAddress(int n)
+{
+    return strprintf("bench%d", n);
+}
+
+/**
+ * Generates a tally state, where each address holds a different amount of the
+ * given number of properties, starting with BENCH_PROPERTY.
+ */
+static void GenerateTallyState(int nAddresses, int nProperties)
+{
+    LOCK(cs_tally);
+    for (int n = 0; n < nAddresses; ++n) {
+        const std::string address = BenchAddress(n);
+        for (int i = 0; i < nProperties; ++i) {
+            bool fUpdated = update_tally_map(address, BENCH_PROPERTY + i, 1000 + n, BALANCE);
+            assert(fUpdated);
+        }
+    }
+}
+
+/** Removes the generated tally state. */
+static void ClearTallyState()
+{
+    LOCK(cs_tally);
+    ClearTallyMap();
+}
+
+// Updates balances of existing addresses in a large tally state.
+static void OmniTallyUpdate(benchmark::State& state)
+{
+    GenerateTallyState(BENCH_TALLY_ADDRESSES, 1);
+
+    std::vector<std::string> vAddresses;
+    vAddresses.reserve(BENCH_TALLY_ADDRESSES);
+    for (int n = 0; n < BENCH_TALLY_ADDRESSES; ++n) {
+        vAddresses.push_back(BenchAddress(n));
+    }
+
+    {
+        LOCK(cs_tally);
+        uint64_t nUpdate = 0;
+        while (state.KeepRunning()) {
+            // spread the updates over the whole state, and keep the balances
+            const std::string& address = vAddresses[(nUpdate * 7919) % BENCH_TALLY_ADDRESSES];
+            bool fUpdated = update_tally_map(address, BENCH_PROPERTY, (nUpdate % 2) ? 1 : -1, BALANCE);
+            assert(fUpdated);
+            ++nUpdate;
+        }
+    }
+
+    ClearTallyState();
+}
+
+// Determines the receivers of a send to owners transaction.
+static void OmniSTOGetReceivers(benchmark::State& state)
+{
+    GenerateTallyState(BENCH_HOLDERS, 1);
+
+    while (state.KeepRunning()) {
+        OwnerAddrType receivers = STO_GetReceivers(BenchAddress(0), BENCH_PROPERTY, 100000000);
+        assert(!receivers.empty());
+    }
+
+    ClearTallyState();
+}
+
+// Hashes the state, which is compared at consensus checkpoints.
+static void OmniConsensusHash(benchmark::State& state)
+{
+    // properties are looked up in the database opened by the testing setup
+    assert(pDbSpInfo != nullptr);
+    GenerateTallyState(BENCH_HOLDERS, 3);
+
+    while (state.KeepRunning()) {
+        GetConsensusHash();
+    }
+
+    ClearTallyState();
+}
+
+// Writes the state files, and loads the balances from them.
+static void OmniPersistAndRestoreState(benchmark::State& state)
+{
+    // the state is written to the directory set up by the testing setup
+    assert(pDbSpInfo != nullptr);
+    TryCreateDirectories(pathStateFiles);
+    GenerateTallyState(BENCH_HOLDERS, 3);
+
+    const CBlockIndex* pBlockIndex = WITH_LOCK(cs_main, return ::ChainActive().Tip());
+    const fs::path pathBalances = pathStateFiles / strprintf("balances-%s.dat", pBlockIndex->GetBlockHash().ToString());
+
+    {
+        LOCK(cs_tally);
+        while (state.KeepRunning()) {
+            PersistInMemoryState(pBlockIndex);
+            int nResult = RestoreInMemoryState(pathBalances.string(), FILETYPE_BALANCES, true);
+            assert(nResult == 0);
+        }
+    }
+
+    ClearTallyState();
+}
+
+BENCHMARK(OmniTallyUpdate, 1000 * 1000);
+BENCHMARK(OmniSTOGetReceivers, 50);
+BENCHMARK(OmniConsensusHash, 20);
+BENCHMARK(OmniPersistAndRestoreState, 5);
@@ -0,0 +1 @@
+#define BUILD_SUFFIX 903dce6-dirty
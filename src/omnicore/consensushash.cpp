@@ -9,19 +9,43 @@
 #include <omnicore/dex.h>
 #include <omnicore/mdex.h>
 #include <omnicore/log.h>
+#include <omnicore/omnicore.h>
 #include <omnicore/parse_string.h>
 #include <omnicore/sp.h>
+#include <omnicore/tally.h>
 
 #include <arith_uint256.h>
 #include <uint256.h>
 
 #include <stdint.h>
 #include <algorithm>
+#include <map>
 #include <string>
+#include <unordered_set>
 #include <vector>
 
 namespace mastercore
 {
+//! Consensus strings of all balance records of an address, sorted by address
+static std::map<std::string, std::string> mapBalanceStrings;
+//! Addresses with balance updates, which are not yet reflected in the consensus strings
+static std::unordered_set<std::string> setDirtyBalances;
+//! Whether the balance consensus strings are populated and maintained
+static bool fBalanceStringsActive = false;
+
+/**
+ * Returns whether consensus hashes are requested regularly, in which case the
+ * consensus strings of the balances are kept between the requests.
+ *
+ * Otherwise the strings are only rarely needed, e.g. for checkpoints, and they
+ * are dropped after each hash, instead of keeping a copy of all balances.
+ */
+static bool KeepConsensusBalances()
+{
+    return msc_debug_consensus_hash_every_block || msc_debug_consensus_hash_every_transaction ||
+            gArgs.IsArgSet("-omnishowblockconsensushash");
+}
+
 bool ShouldConsensusHashBlock(int block) {
     if (msc_debug_consensus_hash_every_block) {
         return true;
@@ -96,6 +120,73 @@ std::string GenerateConsensusString(const uint32_t propertyId, const std::string
     return strprintf("%d|%s", propertyId, address);
 }
 
+// Generates the consensus strings of all balance records of an address, ordered by property ID
+static std::string GenerateConsensusString(const CMPTally& tallyObj, const std::string& address)
+{
+    std::string dataStr;
+    for (const CMPTally::BalanceRecord& record : tallyObj) {
+        dataStr += GenerateConsensusString(tallyObj, address, record.propertyId);
+    }
+    return dataStr;
+}
+
+/**
+ * Marks the balances of an address as updated.
+ *
+ * The consensus strings of the address are regenerated, once the next consensus
+ * hash is requested. Nothing is tracked, until a consensus hash was requested
+ * for the first time.
+ */
+void MarkConsensusBalancesDirty(const std::string& address)
+{
+    if (fBalanceStringsActive) {
+        setDirtyBalances.insert(address);
+    }
+}
+
+/**
+ * Drops the cached consensus strings of all balances.
+ */
+void ClearConsensusBalances()
+{
+    mapBalanceStrings.clear();
+    setDirtyBalances.clear();
+    fBalanceStringsActive = false;
+}
+
+/**
+ * Brings the cached consensus strings of the balances up to date.
+ *
+ * The strings of all addresses are generated on the first call, and afterwards
+ * only the addresses marked as dirty are regenerated.
+ */
+static void UpdateConsensusBalances()
+{
+    if (!fBalanceStringsActive) {
+        for (std::unordered_map<uint32_t, CMPTally>::const_iterator it = mp_tally_map.begin(); it != mp_tally_map.end(); ++it) {
+            const std::string& address = mp_address_table.resolve(it->first);
+            std::string dataStr = GenerateConsensusString(it->second, address);
+            if (dataStr.empty()) continue; // skip empty balances
+            mapBalanceStrings.insert(std::make_pair(address, dataStr));
+        }
+        fBalanceStringsActive = true;
+        return;
+    }
+
+    for (std::unordered_set<std::string>::const_iterator it = setDirtyBalances.begin(); it != setDirtyBalances.end(); ++it) {
+        const std::string& address = *it;
+        CMPTally* tally = getTally(address);
+        std::string dataStr;
+        if (tally) dataStr = GenerateConsensusString(*tally, address);
+        if (dataStr.empty()) {
+            mapBalanceStrings.erase(address);
+        } else {
+            mapBalanceStrings[address] = dataStr;
+        }
+    }
+    setDirtyBalances.clear();
+}
+
 /**
  * Obtains a hash of the active state to use for consensus verification and checkpointing.
  *
@@ -144,6 +235,8 @@ std::string GenerateConsensusString(const uint32_t propertyId, const std::string
  * The byte order is important, and we assume:
  *   SHA256("abc") = "ad1500f261ff10b49c7a1796a36103b02322ae5dde404141eacf018fbf1678ba"
  *
+ * The consensus strings of the balances are cached and only regenerated for addresses,
+ * which were updated since the last call, if consensus hashes are requested regularly.
  */
 uint256 GetConsensusHash()
 {
@@ -153,24 +246,17 @@ uint256 GetConsensusHash()
 
     if (msc_debug_consensus_hash) PrintToLog("Beginning generation of current consensus hash...\n");
 
-    // Balances - loop through the tally map, updating the sha context with the data from each balance and tally type
+    // Balances - loop through the cached balance strings, updating the sha context with the data from each balance and tally type
     // Placeholders:  "address|propertyid|balance|selloffer_reserve|accept_reserve|metadex_reserve"
-    // Sort alphabetically first
-    std::map<std::string, CMPTally> tallyMapSorted;
-    for (std::unordered_map<std::string, CMPTally>::iterator uoit = mp_tally_map.begin(); uoit != mp_tally_map.end(); ++uoit) {
-        tallyMapSorted.insert(std::make_pair(uoit->first,uoit->second));
+    // Sorted alphabetically by address, and by property ID per address
+    UpdateConsensusBalances();
+    for (std::map<std::string, std::string>::const_iterator it = mapBalanceStrings.begin(); it != mapBalanceStrings.end(); ++it) {
+        const std::string& dataStr = it->second;
+        if (msc_debug_consensus_hash) PrintToLog("Adding balance data to consensus hash: %s\n", dataStr);
+        hasher.Write((unsigned char*)dataStr.c_str(), dataStr.length());
     }
-    for (std::map<std::string, CMPTally>::iterator my_it = tallyMapSorted.begin(); my_it != tallyMapSorted.end(); ++my_it) {
-        const std::string& address = my_it->first;
-        CMPTally& tally = my_it->second;
-        tally.init();
-        uint32_t propertyId = 0;
-        while (0 != (propertyId = (tally.next()))) {
-            std::string dataStr = GenerateConsensusString(tally, address, propertyId);
-            if (dataStr.empty()) continue; // skip empty balances
-            if (msc_debug_consensus_hash) PrintToLog("Adding balance data to consensus hash: %s\n", dataStr);
-            hasher.Write((unsigned char*)dataStr.c_str(), dataStr.length());
-        }
+    if (!KeepConsensusBalances()) {
+        ClearConsensusBalances();
     }
 
     // DEx sell offers - loop through the DEx and add each sell offer to the consensus hash (ordered by txid)
@@ -195,8 +281,7 @@ uint256 GetConsensusHash()
     std::vector<std::pair<std::string, std::string> > vecAccepts;
     for (AcceptMap::const_iterator it = my_accepts.begin(); it != my_accepts.end(); ++it) {
         const CMPAccept& accept = it->second;
-        const std::string& acceptCombo = it->first;
-        std::string buyer = acceptCombo.substr((acceptCombo.find("+") + 1), (acceptCombo.size()-(acceptCombo.find("+") + 1)));
+        const std::string& buyer = accept.getBuyer();
         std::string dataStr = GenerateConsensusString(accept, buyer);
         std::string sortKey = strprintf("%s-%s", accept.getHash().GetHex(), buyer);
         vecAccepts.push_back(std::make_pair(sortKey, dataStr));
@@ -281,7 +366,7 @@ uint256 GetMetaDExHash(const uint32_t propertyId)
 
     std::vector<std::pair<arith_uint256, std::string> > vecMetaDExTrades;
     for (md_PropertiesMap::const_iterator my_it = metadex.begin(); my_it != metadex.end(); ++my_it) {
-        if (propertyId == 0 || propertyId == my_it->first) {
+        if (propertyId == 0 || propertyId == my_it->first.first) {
             const md_PricesMap& prices = my_it->second;
             for (md_PricesMap::const_iterator it = prices.begin(); it != prices.end(); ++it) {
                 const md_Set& indexes = it->second;
@@ -312,23 +397,26 @@ uint256 GetBalancesHash(const uint32_t hashPropertyId)
 
     LOCK(cs_tally);
 
-    std::map<std::string, CMPTally> tallyMapSorted;
-    for (std::unordered_map<std::string, CMPTally>::iterator uoit = mp_tally_map.begin(); uoit != mp_tally_map.end(); ++uoit) {
-        tallyMapSorted.insert(std::make_pair(uoit->first,uoit->second));
-    }
-    for (std::map<std::string, CMPTally>::iterator my_it = tallyMapSorted.begin(); my_it != tallyMapSorted.end(); ++my_it) {
-        const std::string& address = my_it->first;
-        CMPTally& tally = my_it->second;
-        tally.init();
-        uint32_t propertyId = 0;
-        while (0 != (propertyId = (tally.next()))) {
-            if (propertyId != hashPropertyId) continue;
-            std::string dataStr = GenerateConsensusString(tally, address, propertyId);
-            if (dataStr.empty()) continue;
-            if (msc_debug_consensus_hash) PrintToLog("Adding data to balances hash: %s\n", dataStr);
-            hasher.Write((unsigned char*)dataStr.c_str(), dataStr.length());
+    // Only holders of the property have non-empty balance records, sort them alphabetically
+    std::vector<std::string> vecHolders;
+    const CMPHolderIndex::HolderSet* holders = mp_holder_index.getHolders(hashPropertyId);
+    if (holders) {
+        vecHolders.reserve(holders->size());
+        for (CMPHolderIndex::HolderSet::const_iterator it = holders->begin(); it != holders->end(); ++it) {
+            vecHolders.push_back(mp_address_table.resolve(*it));
         }
     }
+    std::sort(vecHolders.begin(), vecHolders.end());
+
+    for (std::vector<std::string>::const_iterator it = vecHolders.begin(); it != vecHolders.end(); ++it) {
+        const std::string& address = *it;
+        const CMPTally* tally = getTally(address);
+        if (!tally) continue;
+        std::string dataStr = GenerateConsensusString(*tally, address, hashPropertyId);
+        if (dataStr.empty()) continue;
+        if (msc_debug_consensus_hash) PrintToLog("Adding data to balances hash: %s\n", dataStr);
+        hasher.Write((unsigned char*)dataStr.c_str(), dataStr.length());
+    }
 
     uint256 balancesHash;
     hasher.Finalize(balancesHash.begin());
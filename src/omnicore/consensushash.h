@@ -3,11 +3,19 @@
 
 #include <uint256.h>
 
+#include <string>
+
 namespace mastercore
 {
 /** Checks if a given block should be consensus hashed. */
 bool ShouldConsensusHashBlock(int block);
 
+/** Marks the balances of an address as updated, to refresh them before the next consensus hash. */
+void MarkConsensusBalancesDirty(const std::string& address);
+
+/** Drops the cached consensus strings of all balances. */
+void ClearConsensusBalances();
+
 /** Obtains a hash of all balances to use for consensus verification and checkpointing. */
 uint256 GetConsensusHash();
 
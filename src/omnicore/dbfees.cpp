@@ -11,15 +11,17 @@
 #include <omnicore/sp.h>
 #include <omnicore/sto.h>
 
+#include <clientversion.h>
+#include <crypto/common.h>
+#include <serialize.h>
+#include <streams.h>
 #include <validation.h>
 
 #include <leveldb/db.h>
 
-#include <boost/algorithm/string.hpp>
-#include <boost/lexical_cast.hpp>
-
 #include <stdint.h>
 
+#include <exception>
 #include <limits>
 #include <map>
 #include <string>
@@ -29,6 +31,62 @@ using namespace mastercore;
 
 std::map<uint32_t, int64_t> distributionThresholds;
 
+/**
+ * The fee databases use binary keys and serialized values.
+ *
+ * Property and distribution identifiers are stored in big-endian byte order, so
+ * that entries are sorted numerically.
+ *
+ *   fee cache:   <property>     -> set of (block, cached amount)
+ *   fee history: <distribution> -> FeeDistribution
+ */
+static std::string GetIdKey(uint32_t id)
+{
+    unsigned char buf[4];
+    WriteBE32(buf, id);
+    return std::string(reinterpret_cast<const char*>(buf), sizeof(buf));
+}
+
+/** A fee distribution, as stored in the database. */
+struct FeeDistribution
+{
+    int32_t block = 0;
+    uint32_t propertyId = 0;
+    int64_t total = 0;
+    std::set<feeHistoryItem> recipients;
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action) {
+        READWRITE(block);
+        READWRITE(propertyId);
+        READWRITE(total);
+        READWRITE(recipients);
+    }
+};
+
+template <typename T>
+static std::string SerializeValue(const T& obj)
+{
+    CDataStream ssValue(SER_DISK, CLIENT_VERSION);
+    ssValue << obj;
+    return ssValue.str();
+}
+
+template <typename T>
+static bool DeserializeValue(const leveldb::Slice& slValue, T& obj)
+{
+    try {
+        CDataStream ssValue(slValue.data(), slValue.data() + slValue.size(), SER_DISK, CLIENT_VERSION);
+        ssValue >> obj;
+    } catch (const std::exception& e) {
+        PrintToLog("Fee DB error - failed to deserialize record: %s\n", e.what());
+        return false;
+    }
+    return true;
+}
+
 COmniFeeCache::COmniFeeCache(const fs::path& path, bool fWipe)
 {
     leveldb::Status status = Open(path, fWipe);
@@ -77,23 +135,18 @@ int64_t COmniFeeCache::GetCachedAmount(const uint32_t &propertyId)
 void COmniFeeCache::ClearCache(const uint32_t &propertyId, int block)
 {
     if (msc_debug_fees) PrintToLog("ClearCache starting (block %d, property ID %d)...\n", block, propertyId);
-    const std::string key = strprintf("%010d", propertyId);
     std::set<feeCacheItem> sCacheHistoryItems = GetCacheHistory(propertyId);
     if (msc_debug_fees) PrintToLog("   Iterating cache history (%d items)...\n",sCacheHistoryItems.size());
-    std::string newValue;
-    if (!sCacheHistoryItems.empty()) {
-        for (std::set<feeCacheItem>::iterator it = sCacheHistoryItems.begin(); it != sCacheHistoryItems.end(); it++) {
-            feeCacheItem tempItem = *it;
-            if (tempItem.first == block) continue;
-            if (!newValue.empty()) newValue += ",";
-            newValue += strprintf("%d:%d", tempItem.first, tempItem.second);
-            if (msc_debug_fees) PrintToLog("      Readding entry: block %d amount %d\n", tempItem.first, tempItem.second);
-        }
-        if (!newValue.empty()) newValue += ",";
+    std::set<feeCacheItem> sNewItems;
+    for (std::set<feeCacheItem>::iterator it = sCacheHistoryItems.begin(); it != sCacheHistoryItems.end(); it++) {
+        feeCacheItem tempItem = *it;
+        if (tempItem.first == block) continue;
+        sNewItems.insert(tempItem);
+        if (msc_debug_fees) PrintToLog("      Readding entry: block %d amount %d\n", tempItem.first, tempItem.second);
     }
     if (msc_debug_fees) PrintToLog("   Adding zero valued entry: block %d\n", block);
-    newValue += strprintf("%d:%d", block, 0);
-    leveldb::Status status = pdb->Put(writeoptions, key, newValue);
+    sNewItems.insert(std::make_pair(block, 0));
+    leveldb::Status status = WriteCacheHistory(propertyId, sNewItems);
     assert(status.ok());
     ++nWritten;
 
@@ -125,26 +178,21 @@ void COmniFeeCache::AddFee(const uint32_t &propertyId, int block, const int64_t
     int64_t newCachedAmount = currentCachedAmount + amount;
 
     if (msc_debug_fees) PrintToLog("   New cached amount %d\n", newCachedAmount);
-    const std::string key = strprintf("%010d", propertyId);
     std::set<feeCacheItem> sCacheHistoryItems = GetCacheHistory(propertyId);
     if (msc_debug_fees) PrintToLog("   Iterating cache history (%d items)...\n",sCacheHistoryItems.size());
-    std::string newValue;
-    if (!sCacheHistoryItems.empty()) {
-        for (std::set<feeCacheItem>::iterator it = sCacheHistoryItems.begin(); it != sCacheHistoryItems.end(); it++) {
-            feeCacheItem tempItem = *it;
-            if (tempItem.first == block) continue; // this is an older entry for the same block, discard it
-            if (!newValue.empty()) newValue += ",";
-            newValue += strprintf("%d:%d", tempItem.first, tempItem.second);
-            if (msc_debug_fees) PrintToLog("      Readding entry: block %d amount %d\n", tempItem.first, tempItem.second);
-        }
-        if (!newValue.empty()) newValue += ",";
+    std::set<feeCacheItem> sNewItems;
+    for (std::set<feeCacheItem>::iterator it = sCacheHistoryItems.begin(); it != sCacheHistoryItems.end(); it++) {
+        feeCacheItem tempItem = *it;
+        if (tempItem.first == block) continue; // this is an older entry for the same block, discard it
+        sNewItems.insert(tempItem);
+        if (msc_debug_fees) PrintToLog("      Readding entry: block %d amount %d\n", tempItem.first, tempItem.second);
     }
     if (msc_debug_fees) PrintToLog("   Adding requested entry: block %d new amount %d\n", block, newCachedAmount);
-    newValue += strprintf("%d:%d", block, newCachedAmount);
-    leveldb::Status status = pdb->Put(writeoptions, key, newValue);
+    sNewItems.insert(std::make_pair(block, newCachedAmount));
+    leveldb::Status status = WriteCacheHistory(propertyId, sNewItems);
     assert(status.ok());
     ++nWritten;
-    if (msc_debug_fees) PrintToLog("AddFee completed for property %d (new=%s [%s])\n", propertyId, newValue, status.ToString());
+    if (msc_debug_fees) PrintToLog("AddFee completed for property %d (%d entries [%s])\n", propertyId, sNewItems.size(), status.ToString());
 
     // Call for pruning (we only prune when we update a record)
     PruneCache(propertyId, block);
@@ -162,23 +210,21 @@ void COmniFeeCache::RollBackCache(int block)
     for (uint8_t ecosystem = 1; ecosystem <= 2; ecosystem++) {
         uint32_t startPropertyId = (ecosystem == 1) ? 1 : TEST_ECO_PROPERTY_1;
         for (uint32_t propertyId = startPropertyId; propertyId < mastercore::pDbSpInfo->peekNextSPID(ecosystem); propertyId++) {
-            const std::string key = strprintf("%010d", propertyId);
             std::set<feeCacheItem> sCacheHistoryItems = GetCacheHistory(propertyId);
             if (!sCacheHistoryItems.empty()) {
                 std::set<feeCacheItem>::iterator mostRecentIt = sCacheHistoryItems.end();
-                std::string newValue;
+                std::set<feeCacheItem> sNewItems;
                 --mostRecentIt;
                 feeCacheItem mostRecentItem = *mostRecentIt;
                 if (mostRecentItem.first < block) continue; // all entries are unaffected by this rollback, nothing to do
                 for (std::set<feeCacheItem>::iterator it = sCacheHistoryItems.begin(); it != sCacheHistoryItems.end(); it++) {
                     feeCacheItem tempItem = *it;
                     if (tempItem.first >= block) continue; // discard this entry
-                    if (!newValue.empty()) newValue += ",";
-                    newValue += strprintf("%d:%d", tempItem.first, tempItem.second);
+                    sNewItems.insert(tempItem);
                 }
-                leveldb::Status status = pdb->Put(writeoptions, key, newValue);
+                leveldb::Status status = WriteCacheHistory(propertyId, sNewItems);
                 assert(status.ok());
-                PrintToLog("Rolling back fee cache for property %d, new=%s [%s])\n", propertyId, newValue, status.ToString());
+                PrintToLog("Rolling back fee cache for property %d, %d entries left [%s])\n", propertyId, sNewItems.size(), status.ToString());
             }
         }
     }
@@ -243,7 +289,6 @@ void COmniFeeCache::PruneCache(const uint32_t &propertyId, int block)
 
     int pruneBlock = block - MAX_STATE_HISTORY;
     if (msc_debug_fees) PrintToLog("Removing entries prior to block %d...\n", pruneBlock);
-    const std::string key = strprintf("%010d", propertyId);
     std::set<feeCacheItem> sCacheHistoryItems = GetCacheHistory(propertyId);
     if (msc_debug_fees) PrintToLog("   Iterating cache history (%d items)...\n",sCacheHistoryItems.size());
     if (!sCacheHistoryItems.empty()) {
@@ -253,7 +298,7 @@ void COmniFeeCache::PruneCache(const uint32_t &propertyId, int block)
             if (msc_debug_fees) PrintToLog("Ending PruneCache - no matured entries found.\n");
             return; // all entries are above supplied block value, nothing to do
         }
-        std::string newValue;
+        std::set<feeCacheItem> sNewItems;
         for (std::set<feeCacheItem>::iterator it = sCacheHistoryItems.begin(); it != sCacheHistoryItems.end(); it++) {
             feeCacheItem tempItem = *it;
             if (tempItem.first < pruneBlock) {
@@ -262,21 +307,20 @@ void COmniFeeCache::PruneCache(const uint32_t &propertyId, int block)
                     continue; // discard this entry
                 }
             }
-            if (!newValue.empty()) newValue += ",";
-            newValue += strprintf("%d:%d", tempItem.first, tempItem.second);
+            sNewItems.insert(tempItem);
             if (msc_debug_fees) PrintToLog("      Readding immature entry: block %d amount %d\n", tempItem.first, tempItem.second);
         }
         // make sure the pruned cache isn't completely empty, if it is, prune down to just the most recent entry
-        if (newValue.empty()) {
+        if (sNewItems.empty()) {
             std::set<feeCacheItem>::iterator mostRecentIt = sCacheHistoryItems.end();
             --mostRecentIt;
             feeCacheItem mostRecentItem = *mostRecentIt;
-            newValue = strprintf("%d:%d", mostRecentItem.first, mostRecentItem.second);
+            sNewItems.insert(mostRecentItem);
             if (msc_debug_fees) PrintToLog("   All entries matured and pruned - readding most recent entry: block %d amount %d\n", mostRecentItem.first, mostRecentItem.second);
         }
-        leveldb::Status status = pdb->Put(writeoptions, key, newValue);
+        leveldb::Status status = WriteCacheHistory(propertyId, sNewItems);
         assert(status.ok());
-        if (msc_debug_fees) PrintToLog("PruneCache completed for property %d (new=%s [%s])\n", propertyId, newValue, status.ToString());
+        if (msc_debug_fees) PrintToLog("PruneCache completed for property %d (%d entries [%s])\n", propertyId, sNewItems.size(), status.ToString());
     } else {
         return; // nothing to do
     }
@@ -295,7 +339,7 @@ void COmniFeeCache::printAll()
     leveldb::Iterator* it = NewIterator();
     for(it->SeekToFirst(); it->Valid(); it->Next()) {
         ++count;
-        PrintToConsole("entry #%8d= %s:%s\n", count, it->key().ToString(), it->value().ToString());
+        PrintToConsole("entry #%8d= %s:%s\n", count, HexStr(it->key().ToString()), HexStr(it->value().ToString()));
     }
     delete it;
 }
@@ -305,33 +349,27 @@ std::set<feeCacheItem> COmniFeeCache::GetCacheHistory(const uint32_t &propertyId
 {
     assert(pdb);
 
-    const std::string key = strprintf("%010d", propertyId);
-
     std::set<feeCacheItem> sCacheHistoryItems;
     std::string strValue;
-    leveldb::Status status = pdb->Get(readoptions, key, &strValue);
+    leveldb::Status status = pdb->Get(readoptions, GetIdKey(propertyId), &strValue);
     if (status.IsNotFound()) {
         return sCacheHistoryItems; // no cache, return empty set
     }
     assert(status.ok());
-    std::vector<std::string> vCacheHistoryItems;
-    boost::split(vCacheHistoryItems, strValue, boost::is_any_of(","), boost::token_compress_on);
-    for (std::vector<std::string>::iterator it = vCacheHistoryItems.begin(); it != vCacheHistoryItems.end(); ++it) {
-        std::vector<std::string> vCacheHistoryItem;
-        boost::split(vCacheHistoryItem, *it, boost::is_any_of(":"), boost::token_compress_on);
-        if (2 != vCacheHistoryItem.size()) {
-            PrintToConsole("ERROR: vCacheHistoryItem has unexpected number of elements: %d (raw %s)!\n", vCacheHistoryItem.size(), *it);
-            printAll();
-            continue;
-        }
-        int64_t cacheItemBlock = boost::lexical_cast<int64_t>(vCacheHistoryItem[0]);
-        int64_t cacheItemAmount = boost::lexical_cast<int64_t>(vCacheHistoryItem[1]);
-        sCacheHistoryItems.insert(std::make_pair(cacheItemBlock, cacheItemAmount));
+    if (!DeserializeValue(strValue, sCacheHistoryItems)) {
+        PrintToConsole("ERROR: fee cache of property %d could not be read!\n", propertyId);
+        printAll();
     }
 
     return sCacheHistoryItems;
 }
 
+// Writes the fee cache history items of a property
+leveldb::Status COmniFeeCache::WriteCacheHistory(const uint32_t &propertyId, const std::set<feeCacheItem>& sCacheHistoryItems)
+{
+    return pdb->Put(writeoptions, GetIdKey(propertyId), SerializeValue(sCacheHistoryItems));
+}
+
 COmniFeeHistory::COmniFeeHistory(const fs::path& path, bool fWipe)
 {
     leveldb::Status status = Open(path, fWipe);
@@ -356,8 +394,8 @@ void COmniFeeHistory::printAll()
     leveldb::Iterator* it = NewIterator();
     for(it->SeekToFirst(); it->Valid(); it->Next()) {
         ++count;
-        PrintToConsole("entry #%8d= %s-%s\n", count, it->key().ToString(), it->value().ToString());
-        PrintToLog("entry #%8d= %s-%s\n", count, it->key().ToString(), it->value().ToString());
+        PrintToConsole("entry #%8d= %s-%s\n", count, HexStr(it->key().ToString()), HexStr(it->value().ToString()));
+        PrintToLog("entry #%8d= %s-%s\n", count, HexStr(it->key().ToString()), HexStr(it->value().ToString()));
     }
     delete it;
 }
@@ -380,21 +418,15 @@ void COmniFeeHistory::RollBackHistory(int block)
 {
     assert(pdb);
 
-    std::set<int> sDistributions;
     leveldb::Iterator* it = NewIterator();
     for (it->SeekToFirst(); it->Valid(); it->Next()) {
-        std::string strValue = it->value().ToString();
-        std::string strKey = it->key().ToString();
-        std::vector<std::string> vFeeHistoryDetail;
-        boost::split(vFeeHistoryDetail, strValue, boost::is_any_of(":"), boost::token_compress_on);
-        if (4 != vFeeHistoryDetail.size()) {
-            PrintToLog("ERROR: vFeeHistoryDetail has unexpected number of elements: %d !\n", vFeeHistoryDetail.size());
+        FeeDistribution distribution;
+        if (!DeserializeValue(it->value(), distribution)) {
             continue; // bad data
         }
-        int feeBlock = boost::lexical_cast<int>(vFeeHistoryDetail[0]);
-        if (feeBlock >= block) {
-            PrintToLog("%s() deleting from fee history DB: %s %s\n", __FUNCTION__, strKey, strValue);
-            pdb->Delete(writeoptions, strKey);
+        if (distribution.block >= block) {
+            PrintToLog("%s() deleting from fee history DB: %s (block %d, property %d)\n", __FUNCTION__, HexStr(it->key().ToString()), distribution.block, distribution.propertyId);
+            pdb->Delete(writeoptions, it->key());
         }
     }
     delete it;
@@ -408,18 +440,13 @@ std::set<int> COmniFeeHistory::GetDistributionsForProperty(const uint32_t &prope
     std::set<int> sDistributions;
     leveldb::Iterator* it = NewIterator();
     for (it->SeekToFirst(); it->Valid(); it->Next()) {
-        std::string strValue = it->value().ToString();
-        std::vector<std::string> vFeeHistoryDetail;
-        boost::split(vFeeHistoryDetail, strValue, boost::is_any_of(":"), boost::token_compress_on);
-        if (4 != vFeeHistoryDetail.size()) {
-            PrintToConsole("ERROR: vFeeHistoryDetail has unexpected number of elements: %d !\n", vFeeHistoryDetail.size());
+        FeeDistribution distribution;
+        if (it->key().size() != 4 || !DeserializeValue(it->value(), distribution)) {
             printAll();
             continue; // bad data
         }
-        uint32_t prop = boost::lexical_cast<uint32_t>(vFeeHistoryDetail[1]);
-        if (prop == propertyId) {
-            std::string key = it->key().ToString();
-            int id = boost::lexical_cast<int>(key);
+        if (distribution.propertyId == propertyId) {
+            int id = ReadBE32(reinterpret_cast<const unsigned char*>(it->key().data()));
             sDistributions.insert(id);
         }
     }
@@ -432,23 +459,20 @@ bool COmniFeeHistory::GetDistributionData(int id, uint32_t *propertyId, int *blo
 {
     assert(pdb);
 
-    const std::string key = strprintf("%d", id);
     std::string strValue;
-    leveldb::Status status = pdb->Get(readoptions, key, &strValue);
+    leveldb::Status status = pdb->Get(readoptions, GetIdKey(id), &strValue);
     if (status.IsNotFound()) {
         return false; // fee distribution not found
     }
     assert(status.ok());
-    std::vector<std::string> vFeeHistoryDetail;
-    boost::split(vFeeHistoryDetail, strValue, boost::is_any_of(":"), boost::token_compress_on);
-    if (4 != vFeeHistoryDetail.size()) {
-        PrintToConsole("ERROR: vFeeHistoryDetail has unexpected number of elements: %d !\n", vFeeHistoryDetail.size());
+    FeeDistribution distribution;
+    if (!DeserializeValue(strValue, distribution)) {
         printAll();
         return false; // bad data
     }
-    *block = boost::lexical_cast<int>(vFeeHistoryDetail[0]);
-    *propertyId = boost::lexical_cast<uint32_t>(vFeeHistoryDetail[1]);
-    *total = boost::lexical_cast<int64_t>(vFeeHistoryDetail[2]);
+    *block = distribution.block;
+    *propertyId = distribution.propertyId;
+    *total = distribution.total;
     return true;
 }
 
@@ -457,36 +481,19 @@ std::set<feeHistoryItem> COmniFeeHistory::GetFeeDistribution(int id)
 {
     assert(pdb);
 
-    const std::string key = strprintf("%d", id);
-    std::set<feeHistoryItem> sFeeHistoryItems;
     std::string strValue;
-    leveldb::Status status = pdb->Get(readoptions, key, &strValue);
+    leveldb::Status status = pdb->Get(readoptions, GetIdKey(id), &strValue);
     if (status.IsNotFound()) {
-        return sFeeHistoryItems; // fee distribution not found, return empty set
+        return std::set<feeHistoryItem>(); // fee distribution not found, return empty set
     }
     assert(status.ok());
-    std::vector<std::string> vFeeHistoryDetail;
-    boost::split(vFeeHistoryDetail, strValue, boost::is_any_of(":"), boost::token_compress_on);
-    if (4 != vFeeHistoryDetail.size()) {
-        PrintToConsole("ERROR: vFeeHistoryDetail has unexpected number of elements: %d !\n", vFeeHistoryDetail.size());
+    FeeDistribution distribution;
+    if (!DeserializeValue(strValue, distribution)) {
         printAll();
-        return sFeeHistoryItems; // bad data, return empty set
-    }
-    std::vector<std::string> vFeeHistoryItems;
-    boost::split(vFeeHistoryItems, vFeeHistoryDetail[3], boost::is_any_of(","), boost::token_compress_on);
-    for (std::vector<std::string>::iterator it = vFeeHistoryItems.begin(); it != vFeeHistoryItems.end(); ++it) {
-        std::vector<std::string> vFeeHistoryItem;
-        boost::split(vFeeHistoryItem, *it, boost::is_any_of("="), boost::token_compress_on);
-        if (2 != vFeeHistoryItem.size()) {
-            PrintToConsole("ERROR: vFeeHistoryItem has unexpected number of elements: %d (raw %s)!\n", vFeeHistoryItem.size(), *it);
-            printAll();
-            continue;
-        }
-        int64_t feeHistoryItemAmount = boost::lexical_cast<int64_t>(vFeeHistoryItem[1]);
-        sFeeHistoryItems.insert(std::make_pair(vFeeHistoryItem[0], feeHistoryItemAmount));
+        return std::set<feeHistoryItem>(); // bad data, return empty set
     }
 
-    return sFeeHistoryItems;
+    return distribution.recipients;
 }
 
 // Record a fee distribution
@@ -495,20 +502,12 @@ void COmniFeeHistory::RecordFeeDistribution(const uint32_t &propertyId, int bloc
     assert(pdb);
 
     int count = CountRecords() + 1;
-    std::string key = strprintf("%d", count);
-    std::string feeRecipientsStr;
-
-    if (!feeRecipients.empty()) {
-        for (std::set<feeHistoryItem>::iterator it = feeRecipients.begin(); it != feeRecipients.end(); it++) {
-            feeHistoryItem tempRecipient = *it;
-            feeRecipientsStr += strprintf("%s=%d,", tempRecipient.first, tempRecipient.second);
-        }
-        if (feeRecipientsStr.size() > 0) {
-            feeRecipientsStr.resize(feeRecipientsStr.size() - 1);
-        }
-    }
-
-    std::string value = strprintf("%d:%d:%d:%s", block, propertyId, total, feeRecipientsStr);
-    leveldb::Status status = pdb->Put(writeoptions, key, value);
-    if (msc_debug_fees) PrintToLog("Added fee distribution to feeCacheHistory - key=%s value=%s [%s]\n", key, value, status.ToString());
+    FeeDistribution distribution;
+    distribution.block = block;
+    distribution.propertyId = propertyId;
+    distribution.total = total;
+    distribution.recipients = feeRecipients;
+
+    leveldb::Status status = pdb->Put(writeoptions, GetIdKey(count), SerializeValue(distribution));
+    if (msc_debug_fees) PrintToLog("Added fee distribution to feeCacheHistory - id=%d block=%d property=%d total=%d recipients=%d [%s]\n", count, block, propertyId, total, feeRecipients.size(), status.ToString());
 }
@@ -14,6 +14,8 @@ typedef std::pair<int, int64_t> feeCacheItem;
 typedef std::pair<std::string, int64_t> feeHistoryItem;
 
 /** LevelDB based storage for the MetaDEx fee cache.
+ *
+ * The cache history of each property is stored as one serialized set, keyed by the big-endian property identifier.
  */
 class COmniFeeCache : public CDBBase
 {
@@ -46,9 +48,15 @@ public:
     void EvalCache(const uint32_t &propertyId, int block);
     /** Performs distribution of fees */
     void DistributeCache(const uint32_t &propertyId, int block);
+
+private:
+    /** Writes the fee cache history items of a property */
+    leveldb::Status WriteCacheHistory(const uint32_t &propertyId, const std::set<feeCacheItem>& sCacheHistoryItems);
 };
 
 /** LevelDB based storage for the MetaDEx fee distributions.
+ *
+ * Distributions are stored as serialized records, keyed by the big-endian distribution identifier.
  */
 class COmniFeeHistory : public CDBBase
 {
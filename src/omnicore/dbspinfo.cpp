@@ -138,6 +138,7 @@ std::string CMPSPInfo::Entry::getDelegate(int block) const
 
 
 CMPSPInfo::CMPSPInfo(const fs::path& path, bool fWipe)
+  : nCacheHits(0), nCacheMisses(0), nCacheGeneration(0)
 {
     leveldb::Status status = Open(path, fWipe);
     PrintToConsole("Loading smart property database: %s\n", status.ToString());
@@ -177,6 +178,8 @@ void CMPSPInfo::Clear()
     CDBBase::Clear();
     // reset "next property identifiers"
     init();
+    // drop decoded entries
+    invalidateCache();
 }
 
 void CMPSPInfo::init(uint32_t nextSPID, uint32_t nextTestSPID)
@@ -185,6 +188,24 @@ void CMPSPInfo::init(uint32_t nextSPID, uint32_t nextTestSPID)
     next_test_spid = nextTestSPID;
 }
 
+void CMPSPInfo::invalidateCache(uint32_t propertyId)
+{
+    LOCK(cs_cache);
+    ++nCacheGeneration;
+    if (propertyId == 0) {
+        cachedEntries.clear();
+    } else {
+        cachedEntries.erase(propertyId);
+    }
+}
+
+void CMPSPInfo::getCacheStats(uint64_t& hits, uint64_t& misses) const
+{
+    LOCK(cs_cache);
+    hits = nCacheHits;
+    misses = nCacheMisses;
+}
+
 uint32_t CMPSPInfo::peekNextSPID(uint8_t ecosystem) const
 {
     uint32_t nextId = 0;
@@ -248,6 +269,7 @@ bool CMPSPInfo::updateSP(uint32_t propertyId, const Entry& info)
     }
 
     leveldb::Status status = pdb->Write(syncoptions, &batch);
+    invalidateCache(propertyId);
 
     if (!status.ok()) {
         PrintToLog("%s(): ERROR for SP %d: %s\n", __func__, propertyId, status.ToString());
@@ -325,6 +347,7 @@ uint32_t CMPSPInfo::putSP(uint8_t ecosystem, const Entry& info)
     }
 
     leveldb::Status status = pdb->Write(syncoptions, &batch);
+    invalidateCache(propertyId);
 
     if (!status.ok()) {
         PrintToLog("%s(): ERROR for SP %d: %s\n", __func__, propertyId, status.ToString());
@@ -344,6 +367,19 @@ bool CMPSPInfo::getSP(uint32_t propertyId, Entry& info) const
         return true;
     }
 
+    uint64_t nGeneration = 0;
+    {
+        LOCK(cs_cache);
+        std::map<uint32_t, Entry>::const_iterator it = cachedEntries.find(propertyId);
+        if (it != cachedEntries.end()) {
+            ++nCacheHits;
+            info = it->second;
+            return true;
+        }
+        ++nCacheMisses;
+        nGeneration = nCacheGeneration;
+    }
+
     // DB key for property entry
     CDataStream ssSpKey(SER_DISK, CLIENT_VERSION);
     ssSpKey << std::make_pair('s', propertyId);
@@ -395,6 +431,12 @@ bool CMPSPInfo::getSP(uint32_t propertyId, Entry& info) const
         }
     }
 
+    // the entry may have been updated while it was read, in which case it's not cached
+    LOCK(cs_cache);
+    if (nGeneration == nCacheGeneration) {
+        cachedEntries[propertyId] = info;
+    }
+
     return true;
 }
 
@@ -515,6 +557,7 @@ int64_t CMPSPInfo::popBlock(const uint256& block_hash)
     delete iter;
 
     leveldb::Status status = pdb->Write(syncoptions, &commitBatch);
+    invalidateCache();
 
     if (!status.ok()) {
         PrintToLog("%s(): ERROR: %s\n", __func__, status.ToString());
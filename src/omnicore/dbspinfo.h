@@ -7,6 +7,7 @@
 
 #include <fs.h>
 #include <serialize.h>
+#include <sync.h>
 #include <uint256.h>
 
 #include <stdint.h>
@@ -153,6 +154,20 @@ private:
     uint32_t next_spid;
     uint32_t next_test_spid;
 
+    //! Guards the cache of decoded entries
+    mutable Mutex cs_cache;
+    //! Decoded entries, keyed by property identifier
+    mutable std::map<uint32_t, Entry> cachedEntries;
+    //! Number of entries served from the cache
+    mutable uint64_t nCacheHits;
+    //! Number of entries loaded from the database
+    mutable uint64_t nCacheMisses;
+    //! Incremented on each invalidation, so entries read before a write are not cached
+    uint64_t nCacheGeneration;
+
+    /** Removes an entry from the cache, or all entries, if no identifier is given. */
+    void invalidateCache(uint32_t propertyId = 0);
+
 public:
     CMPSPInfo(const fs::path& path, bool fWipe);
     virtual ~CMPSPInfo();
@@ -175,6 +190,9 @@ public:
     bool getWatermark(uint256& watermark) const;
 
     void printAll() const;
+
+    /** Returns the number of cache hits and misses of getSP(). */
+    void getCacheStats(uint64_t& hits, uint64_t& misses) const;
 };
 
 
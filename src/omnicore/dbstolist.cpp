@@ -4,8 +4,13 @@
 #include <omnicore/sp.h>
 #include <omnicore/walletutils.h>
 
+#include <clientversion.h>
+#include <crypto/common.h>
 #include <fs.h>
 #include <interfaces/wallet.h>
+#include <serialize.h>
+#include <streams.h>
+#include <txmempool.h>
 #include <uint256.h>
 #include <util/strencodings.h>
 #include <tinyformat.h>
@@ -15,19 +20,110 @@
 #include <leveldb/iterator.h>
 #include <leveldb/slice.h>
 #include <leveldb/status.h>
-
-#include <boost/algorithm/string.hpp>
-#include <boost/lexical_cast.hpp>
+#include <leveldb/write_batch.h>
 
 #include <stddef.h>
 #include <stdint.h>
 
+#include <algorithm>
+#include <exception>
+#include <set>
 #include <string>
+#include <unordered_set>
+#include <utility>
 #include <vector>
 
 using mastercore::IsMyAddress;
 using mastercore::isPropertyDivisible;
 
+/**
+ * The STO database uses binary keys and serialized values.
+ *
+ * Transaction hashes are stored as raw 32 bytes, and block heights in big-endian
+ * byte order, so that the receipts of an address are sorted by block.
+ *
+ *   'r' <address> '\0' <block> <txid>   -> (property, amount)
+ *   't' <txid> <address>                -> (property, amount)
+ *   'b' <block> <txid> <address>        -> (empty, receipts by block)
+ */
+static const char RECEIPT_KEY = 'r';
+static const char TX_KEY = 't';
+static const char BLOCK_KEY = 'b';
+
+static void AppendBE32(std::string& key, uint32_t n)
+{
+    unsigned char buf[4];
+    WriteBE32(buf, n);
+    key.append(reinterpret_cast<const char*>(buf), sizeof(buf));
+}
+
+static void AppendHash(std::string& key, const uint256& hash)
+{
+    key.append(reinterpret_cast<const char*>(hash.begin()), hash.size());
+}
+
+/** Reads a hash, which is stored at the given offset of a key. */
+static uint256 ReadHash(const leveldb::Slice& key, size_t nOffset)
+{
+    uint256 hash;
+    assert(key.size() >= nOffset + hash.size());
+    std::copy(key.data() + nOffset, key.data() + nOffset + hash.size(), hash.begin());
+    return hash;
+}
+
+/** Returns the prefix of the receipts of an address. */
+static std::string GetReceiptKeyPrefix(const std::string& address)
+{
+    std::string key(1, RECEIPT_KEY);
+    key.append(address);
+    key.push_back('\0');
+    return key;
+}
+
+static std::string GetReceiptKey(const std::string& address, int block, const uint256& txid)
+{
+    std::string key = GetReceiptKeyPrefix(address);
+    AppendBE32(key, block);
+    AppendHash(key, txid);
+    return key;
+}
+
+static std::string GetTxKey(const uint256& txid, const std::string& address = "")
+{
+    std::string key(1, TX_KEY);
+    AppendHash(key, txid);
+    key.append(address);
+    return key;
+}
+
+static std::string GetBlockKey(int block)
+{
+    std::string key(1, BLOCK_KEY);
+    AppendBE32(key, block);
+    return key;
+}
+
+static std::string SerializeReceipt(uint32_t propertyId, uint64_t amount)
+{
+    CDataStream ssValue(SER_DISK, CLIENT_VERSION);
+    ssValue << propertyId;
+    ssValue << amount;
+    return ssValue.str();
+}
+
+static bool DeserializeReceipt(const leveldb::Slice& slValue, uint32_t& propertyId, uint64_t& amount)
+{
+    try {
+        CDataStream ssValue(slValue.data(), slValue.data() + slValue.size(), SER_DISK, CLIENT_VERSION);
+        ssValue >> propertyId;
+        ssValue >> amount;
+    } catch (const std::exception& e) {
+        PrintToLog("STODB error - failed to deserialize receipt: %s\n", e.what());
+        return false;
+    }
+    return true;
+}
+
 CMPSTOList::CMPSTOList(const fs::path& path, bool fWipe)
 {
     leveldb::Status status = Open(path, fWipe);
@@ -53,99 +149,95 @@ void CMPSTOList::getRecipients(const uint256 txid, std::string filterAddress, Un
         filterByAddress = true;
     }
 
-    // iterate through SDB, dropping all records where key is not filterAddress (if filtering)
-    int count = 0;
-
     // the fee is variable based on version of STO - provide number of recipients and allow calling function to work out fee
     *numRecipients = 0;
 
-    leveldb::Slice skey, svalue;
+    // the recipients of the transaction are ordered by address
+    const std::string prefix = GetTxKey(txid);
     leveldb::Iterator* it = NewIterator();
-    for (it->SeekToFirst(); it->Valid(); it->Next()) {
-        skey = it->key();
-        std::string recipientAddress = skey.ToString();
-        svalue = it->value();
-        std::string strValue = svalue.ToString();
-        // see if txid is in the data
-        size_t txidMatch = strValue.find(txid.ToString());
-        if (txidMatch != std::string::npos) {
-            ++*numRecipients;
-            // the txid exists inside the data, this address was a recipient of this STO, check filter and add the details
-            if (filter) {
-                if (((filterByAddress) && (filterAddress == recipientAddress)) || ((filterByWallet) && (IsMyAddress(recipientAddress, iWallet)))) {
-                } else {
-                    continue;
-                } // move on if no filter match (but counter still increased for fee)
-            }
-            std::vector<std::string> vstr;
-            boost::split(vstr, strValue, boost::is_any_of(","), boost::token_compress_on);
-            for (uint32_t i = 0; i < vstr.size(); i++) {
-                std::vector<std::string> svstr;
-                boost::split(svstr, vstr[i], boost::is_any_of(":"), boost::token_compress_on);
-                if (4 == svstr.size()) {
-                    if (svstr[0] == txid.ToString()) {
-                        //add data to array
-                        uint64_t amount = 0;
-                        uint64_t propertyId = 0;
-                        try {
-                            amount = boost::lexical_cast<uint64_t>(svstr[3]);
-                            propertyId = boost::lexical_cast<uint64_t>(svstr[2]);
-                        } catch (const boost::bad_lexical_cast &e) {
-                            PrintToLog("DEBUG STO - error in converting values from leveldb\n");
-                            delete it;
-                            return; //(something went wrong)
-                        }
-                        UniValue recipient(UniValue::VOBJ);
-                        recipient.pushKV("address", recipientAddress);
-                        if (isPropertyDivisible(propertyId)) {
-                            recipient.pushKV("amount", FormatDivisibleMP(amount));
-                        } else {
-                            recipient.pushKV("amount", FormatIndivisibleMP(amount));
-                        }
-                        *total += amount;
-                        recipientArray->push_back(recipient);
-                        ++count;
-                    }
-                }
-            }
+    for (it->Seek(prefix); it->Valid() && it->key().starts_with(prefix); it->Next()) {
+        const std::string recipientAddress(it->key().data() + prefix.size(), it->key().size() - prefix.size());
+        ++*numRecipients;
+        // this address was a recipient of this STO, check filter and add the details
+        if (filter) {
+            if (((filterByAddress) && (filterAddress == recipientAddress)) || ((filterByWallet) && (IsMyAddress(recipientAddress, iWallet)))) {
+            } else {
+                continue;
+            } // move on if no filter match (but counter still increased for fee)
+        }
+        uint32_t propertyId = 0;
+        uint64_t amount = 0;
+        if (!DeserializeReceipt(it->value(), propertyId, amount)) {
+            break; // something went wrong
+        }
+        UniValue recipient(UniValue::VOBJ);
+        recipient.pushKV("address", recipientAddress);
+        if (isPropertyDivisible(propertyId)) {
+            recipient.pushKV("amount", FormatDivisibleMP(amount));
+        } else {
+            recipient.pushKV("amount", FormatIndivisibleMP(amount));
         }
+        *total += amount;
+        recipientArray->push_back(recipient);
     }
 
     delete it;
-    return;
 }
 
-std::string CMPSTOList::getMySTOReceipts(std::string filterAddress, interfaces::Wallet &iWallet)
+std::vector<std::string> CMPSTOList::getRecipientAddresses()
 {
-    if (!pdb) return "";
-    std::string mySTOReceipts = "";
-    leveldb::Slice skey, svalue;
+    std::vector<std::string> vAddresses;
+    if (!pdb) return vAddresses;
+
+    // skip over the receipts of each address
+    const std::string prefix(1, RECEIPT_KEY);
     leveldb::Iterator* it = NewIterator();
-    for (it->SeekToFirst(); it->Valid(); it->Next()) {
-        skey = it->key();
-        std::string recipientAddress = skey.ToString();
-        if (!IsMyAddress(recipientAddress, &iWallet)) continue; // not ours, not interested
-        if ((!filterAddress.empty()) && (filterAddress != recipientAddress)) continue; // not the filtered address
-        // ours, get info
-        svalue = it->value();
-        std::string strValue = svalue.ToString();
-        // break into individual receipts
-        std::vector<std::string> vstr;
-        boost::split(vstr, strValue, boost::is_any_of(","), boost::token_compress_on);
-        for (uint32_t i = 0; i < vstr.size(); i++) {
-            // add to array
-            std::vector<std::string> svstr;
-            boost::split(svstr, vstr[i], boost::is_any_of(":"), boost::token_compress_on);
-            if (4 == svstr.size()) {
-                size_t txidMatch = mySTOReceipts.find(svstr[0]);
-                if (txidMatch == std::string::npos) mySTOReceipts += svstr[0] + ":" + svstr[1] + ":" + recipientAddress + ":" + svstr[2] + ",";
-            }
+    it->Seek(prefix);
+    while (it->Valid() && it->key().starts_with(prefix)) {
+        const char* pbegin = it->key().data() + 1;
+        const char* pend = std::find(pbegin, it->key().data() + it->key().size(), '\0');
+        vAddresses.emplace_back(pbegin, pend);
+        std::string next = GetReceiptKeyPrefix(vAddresses.back());
+        next.back() = '\x01';
+        it->Seek(next);
+    }
+    delete it;
+
+    return vAddresses;
+}
+
+std::vector<CMPSTOList::Receipt> CMPSTOList::getReceipts(const std::set<std::string>& addresses, int startBlock, int endBlock)
+{
+    std::vector<Receipt> vReceipts;
+    if (!pdb) return vReceipts;
+
+    // the same STO may have been received by several of the addresses
+    std::unordered_set<uint256, SaltedTxidHasher> seenHashes;
+
+    leveldb::Iterator* it = NewIterator();
+    for (const std::string& address : addresses) {
+        const std::string prefix = GetReceiptKeyPrefix(address);
+        for (it->Seek(GetReceiptKey(address, std::max(startBlock, 0), uint256())); it->Valid() && it->key().starts_with(prefix); it->Next()) {
+            leveldb::Slice slKey = it->key();
+            if (slKey.size() != prefix.size() + 4 + 32) continue;
+            int block = ReadBE32(reinterpret_cast<const unsigned char*>(slKey.data() + prefix.size()));
+            if (block > endBlock) break;
+            Receipt receipt;
+            receipt.txid = ReadHash(slKey, prefix.size() + 4);
+            if (!seenHashes.insert(receipt.txid).second) continue;
+            receipt.block = block;
+            receipt.address = address;
+            if (!DeserializeReceipt(it->value(), receipt.propertyId, receipt.amount)) continue;
+            vReceipts.push_back(receipt);
         }
     }
     delete it;
-    // above code will leave a trailing comma - strip it
-    if (mySTOReceipts.size() > 0) mySTOReceipts.resize(mySTOReceipts.size() - 1);
-    return mySTOReceipts;
+
+    std::stable_sort(vReceipts.begin(), vReceipts.end(), [](const Receipt& a, const Receipt& b) {
+        return a.block < b.block;
+    });
+
+    return vReceipts;
 }
 
 /**
@@ -155,35 +247,28 @@ std::string CMPSTOList::getMySTOReceipts(std::string filterAddress, interfaces::
  */
 int CMPSTOList::deleteAboveBlock(int blockNum)
 {
+    if (!pdb) return 0;
+
     unsigned int n_found = 0;
-    std::vector<std::string> vecSTORecords;
+    const std::string blockPrefix(1, BLOCK_KEY);
+    leveldb::WriteBatch batch;
     leveldb::Iterator* it = NewIterator();
-    for (it->SeekToFirst(); it->Valid(); it->Next()) {
-        std::string newValue;
-        std::string oldValue = it->value().ToString();
-        bool needsUpdate = false;
-        boost::split(vecSTORecords, oldValue, boost::is_any_of(","), boost::token_compress_on);
-        for (uint32_t i = 0; i < vecSTORecords.size(); i++) {
-            std::vector<std::string> vecSTORecordFields;
-            boost::split(vecSTORecordFields, vecSTORecords[i], boost::is_any_of(":"), boost::token_compress_on);
-            if (4 != vecSTORecordFields.size()) continue;
-            if (atoi(vecSTORecordFields[1]) < blockNum) {
-                newValue += vecSTORecords[i].append(","); // STO before the reorg, add data back to new value string
-            } else {
-                needsUpdate = true;
-            }
-        }
-        if (needsUpdate) { // rewrite record with existing key and new value
-            ++n_found;
-            leveldb::Status status = pdb->Put(writeoptions, it->key().ToString(), newValue);
-            PrintToLog("DEBUG STO - rewriting STO data after reorg\n");
-            PrintToLog("STODBDEBUG : %s(): %s, line %d, file: %s\n", __FUNCTION__, status.ToString(), __LINE__, __FILE__);
-        }
+    for (it->Seek(GetBlockKey(blockNum)); it->Valid() && it->key().starts_with(blockPrefix); it->Next()) {
+        leveldb::Slice slKey = it->key();
+        if (slKey.size() < 1 + 4 + 32) continue;
+        int block = ReadBE32(reinterpret_cast<const unsigned char*>(slKey.data() + 1));
+        const uint256 txid = ReadHash(slKey, 5);
+        const std::string address(slKey.data() + 37, slKey.size() - 37);
+        batch.Delete(GetReceiptKey(address, block, txid));
+        batch.Delete(GetTxKey(txid, address));
+        batch.Delete(slKey);
+        ++n_found;
     }
+    delete it;
 
-    PrintToLog("%s(%d); stodb updated records= %d\n", __FUNCTION__, blockNum, n_found);
+    pdb->Write(writeoptions, &batch);
 
-    delete it;
+    PrintToLog("%s(%d); stodb deleted records= %d\n", __FUNCTION__, blockNum, n_found);
 
     return (n_found);
 }
@@ -203,7 +288,7 @@ void CMPSTOList::printAll()
         skey = it->key();
         svalue = it->value();
         ++count;
-        PrintToConsole("entry #%8d= %s:%s\n", count, skey.ToString(), svalue.ToString());
+        PrintToConsole("entry #%8d= %s:%s\n", count, HexStr(skey.ToString()), HexStr(svalue.ToString()));
     }
 
     delete it;
@@ -213,49 +298,35 @@ bool CMPSTOList::exists(std::string address)
 {
     if (!pdb) return false;
 
-    std::string strValue;
-    leveldb::Status status = pdb->Get(readoptions, address, &strValue);
-
-    if (!status.ok()) {
-        if (status.IsNotFound()) return false;
-    }
+    const std::string prefix = GetReceiptKeyPrefix(address);
+    leveldb::Iterator* it = NewIterator();
+    it->Seek(prefix);
+    bool fFound = it->Valid() && it->key().starts_with(prefix);
+    delete it;
 
-    return true;
+    return fFound;
 }
 
 void CMPSTOList::recordSTOReceive(std::string address, const uint256 &txid, int nBlock, unsigned int propertyId, uint64_t amount)
 {
     if (!pdb) return;
 
-    bool addressExists = exists(address);
-    if (addressExists) {
-        // retrieve existing record
-        std::vector<std::string> vstr;
-        std::string strValue;
-        leveldb::Status status = pdb->Get(readoptions, address, &strValue);
-        if (status.ok()) {
-            // add details to record
-            // see if we are overwriting (check)
-            size_t txidMatch = strValue.find(txid.ToString());
-            if (txidMatch != std::string::npos) PrintToLog("STODEBUG : Duplicating entry for %s : %s\n", address, txid.ToString());
-
-            const std::string key = address;
-            const std::string newValue = strprintf("%s:%d:%u:%lu,", txid.ToString(), nBlock, propertyId, amount);
-            strValue += newValue;
-            // write updated record
-            leveldb::Status status;
-            if (pdb) {
-                status = pdb->Put(writeoptions, key, strValue);
-                PrintToLog("STODBDEBUG : %s(): %s, line %d, file: %s\n", __FUNCTION__, status.ToString(), __LINE__, __FILE__);
-            }
-        }
-    } else {
-        const std::string key = address;
-        const std::string value = strprintf("%s:%d:%u:%lu,", txid.ToString(), nBlock, propertyId, amount);
-        leveldb::Status status;
-        if (pdb) {
-            status = pdb->Put(writeoptions, key, value);
-            PrintToLog("STODBDEBUG : %s(): %s, line %d, file: %s\n", __FUNCTION__, status.ToString(), __LINE__, __FILE__);
-        }
+    const std::string txKey = GetTxKey(txid, address);
+    std::string strValue;
+    if (pdb->Get(readoptions, txKey, &strValue).ok()) {
+        PrintToLog("STODEBUG : Duplicating entry for %s : %s\n", address, txid.ToString());
     }
+
+    std::string blockKey = GetBlockKey(nBlock);
+    AppendHash(blockKey, txid);
+    blockKey.append(address);
+
+    const std::string value = SerializeReceipt(propertyId, amount);
+    leveldb::WriteBatch batch;
+    batch.Put(GetReceiptKey(address, nBlock, txid), value);
+    batch.Put(txKey, value);
+    batch.Put(blockKey, "");
+    leveldb::Status status = pdb->Write(writeoptions, &batch);
+    ++nWritten;
+    PrintToLog("STODBDEBUG : %s(): %s, line %d, file: %s\n", __FUNCTION__, status.ToString(), __LINE__, __FILE__);
 }
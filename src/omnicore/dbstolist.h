@@ -10,23 +10,46 @@
 
 #include <stdint.h>
 
+#include <set>
 #include <string>
+#include <vector>
 
 namespace interfaces {
 class Wallet;
 } // namespace interfaces
 
 /** LevelDB based storage for STO recipients.
+ *
+ * Receipts are indexed by recipient address and by transaction, with keys ordered by block.
  */
 class CMPSTOList : public CDBBase
 {
 public:
+    /** A received send-to-owners payment. */
+    struct Receipt
+    {
+        uint256 txid;
+        int block;
+        std::string address;
+        uint32_t propertyId;
+        uint64_t amount;
+    };
+
     CMPSTOList(const fs::path& path, bool fWipe);
     virtual ~CMPSTOList();
 
     void getRecipients(const uint256 txid, std::string filterAddress, UniValue* recipientArray, uint64_t* total, uint64_t* numRecipients, interfaces::Wallet* iWallet = nullptr);
-    std::string getMySTOReceipts(std::string filterAddress, interfaces::Wallet& iWallet);
-    
+
+    /** Returns all addresses, which received STO payments. */
+    std::vector<std::string> getRecipientAddresses();
+
+    /**
+     * Returns the STO receipts of the given addresses within the block range, ordered by block.
+     *
+     * Receipts of the same transaction are only returned once.
+     */
+    std::vector<Receipt> getReceipts(const std::set<std::string>& addresses, int startBlock = 0, int endBlock = 999999);
+
     /**
      * This function deletes records of STO receivers above/equal to a specific block from the STO database.
      *
@@ -5,7 +5,11 @@
 #include <omnicore/sp.h>
 
 #include <amount.h>
+#include <clientversion.h>
+#include <crypto/common.h>
 #include <fs.h>
+#include <serialize.h>
+#include <streams.h>
 #include <uint256.h>
 #include <util/strencodings.h>
 #include <tinyformat.h>
@@ -15,20 +19,152 @@
 #include <leveldb/iterator.h>
 #include <leveldb/slice.h>
 #include <leveldb/status.h>
-
-#include <boost/algorithm/string.hpp>
-#include <boost/lexical_cast.hpp>
+#include <leveldb/write_batch.h>
 
 #include <stddef.h>
 
 #include <algorithm>
-#include <map>
+#include <exception>
 #include <string>
 #include <utility>
 #include <vector>
 
 using mastercore::isPropertyDivisible;
 
+/**
+ * The trade database uses binary keys and serialized values.
+ *
+ * Transaction hashes are stored as raw 32 bytes, and block heights, positions and
+ * property identifiers of secondary keys in big-endian byte order, so that entries
+ * are sorted numerically.
+ *
+ *   'n' <txid>                                     -> CMPTradeList::NewTrade
+ *   'm' <txid1> <txid2>                            -> CMPTradeList::MatchedTrade
+ *   'M' <txid2> <txid1>                            -> (empty, matches by txid2)
+ *   'a' <address> '\0' <block> <idx> <txid>        -> (property for sale, property desired)
+ *   'p' <property> <property> <block> <idx> <txid1> <txid2> -> (empty, smaller property first)
+ *   'b' <block> <primary key>                      -> (empty, records by block)
+ */
+static const char NEW_TRADE_KEY = 'n';
+static const char MATCH_KEY = 'm';
+static const char MATCH_REVERSE_KEY = 'M';
+static const char ADDRESS_KEY = 'a';
+static const char PAIR_KEY = 'p';
+static const char BLOCK_KEY = 'b';
+
+static void AppendBE32(std::string& key, uint32_t n)
+{
+    unsigned char buf[4];
+    WriteBE32(buf, n);
+    key.append(reinterpret_cast<const char*>(buf), sizeof(buf));
+}
+
+static void AppendHash(std::string& key, const uint256& hash)
+{
+    key.append(reinterpret_cast<const char*>(hash.begin()), hash.size());
+}
+
+/** Reads a hash, which is stored at the given offset of a key. */
+static uint256 ReadHash(const leveldb::Slice& key, size_t nOffset)
+{
+    uint256 hash;
+    assert(key.size() >= nOffset + hash.size());
+    std::copy(key.data() + nOffset, key.data() + nOffset + hash.size(), hash.begin());
+    return hash;
+}
+
+static std::string GetNewTradeKey(const uint256& txid)
+{
+    std::string key(1, NEW_TRADE_KEY);
+    AppendHash(key, txid);
+    return key;
+}
+
+static std::string GetMatchKey(char prefix, const uint256& txidFirst, const uint256& txidSecond)
+{
+    std::string key(1, prefix);
+    AppendHash(key, txidFirst);
+    AppendHash(key, txidSecond);
+    return key;
+}
+
+/** Returns the prefix of the secondary keys of the trades of an address. */
+static std::string GetAddressKeyPrefix(const std::string& address)
+{
+    std::string key(1, ADDRESS_KEY);
+    key.append(address);
+    key.push_back('\0');
+    return key;
+}
+
+static std::string GetAddressKey(const std::string& address, int block, int blockIndex, const uint256& txid)
+{
+    std::string key = GetAddressKeyPrefix(address);
+    AppendBE32(key, block);
+    AppendBE32(key, blockIndex);
+    AppendHash(key, txid);
+    return key;
+}
+
+/** Returns the prefix of the secondary keys of the matched trades of a pair, for both sides of the market. */
+static std::string GetPairKeyPrefix(uint32_t propertyIdSideA, uint32_t propertyIdSideB)
+{
+    std::string key(1, PAIR_KEY);
+    AppendBE32(key, std::min(propertyIdSideA, propertyIdSideB));
+    AppendBE32(key, std::max(propertyIdSideA, propertyIdSideB));
+    return key;
+}
+
+static std::string GetPairKey(const CMPTradeList::MatchedTrade& trade, const uint256& txid1, const uint256& txid2)
+{
+    std::string key = GetPairKeyPrefix(trade.prop1, trade.prop2);
+    AppendBE32(key, trade.block);
+    AppendBE32(key, trade.blockIndex);
+    AppendHash(key, txid1);
+    AppendHash(key, txid2);
+    return key;
+}
+
+static std::string GetBlockKey(int block, const std::string& primaryKey = "")
+{
+    std::string key(1, BLOCK_KEY);
+    AppendBE32(key, block);
+    key.append(primaryKey);
+    return key;
+}
+
+/** Positions the iterator at the last entry with the given prefix, if any. */
+static void SeekToLastWithPrefix(leveldb::Iterator* it, const std::string& prefix)
+{
+    it->Seek(prefix + std::string(128, '\xff'));
+    if (it->Valid()) {
+        it->Prev();
+    } else {
+        it->SeekToLast();
+    }
+}
+
+template <typename T>
+static std::string SerializeRecord(const T& record)
+{
+    CDataStream ssValue(SER_DISK, CLIENT_VERSION);
+    ssValue << record;
+    return ssValue.str();
+}
+
+template <typename T>
+static bool DeserializeRecord(const leveldb::Slice& slValue, T& record)
+{
+    try {
+        CDataStream ssValue(slValue.data(), slValue.data() + slValue.size(), SER_DISK, CLIENT_VERSION);
+        ssValue >> record;
+    } catch (const std::exception& e) {
+        PrintToLog("TRADEDB error - failed to deserialize record: %s\n", e.what());
+        return false;
+    }
+    return true;
+}
+
 CMPTradeList::CMPTradeList(const fs::path& path, bool fWipe)
 {
     leveldb::Status status = Open(path, fWipe);
@@ -40,12 +176,28 @@ CMPTradeList::~CMPTradeList()
     if (msc_debug_persistence) PrintToLog("CMPTradeList closed\n");
 }
 
-void CMPTradeList::recordMatchedTrade(const uint256& txid1, const uint256& txid2, const std::string& address1, const std::string& address2, uint32_t prop1, uint32_t prop2, int64_t amount1, int64_t amount2, int blockNum, int64_t fee)
+void CMPTradeList::recordMatchedTrade(const uint256& txid1, const uint256& txid2, const std::string& address1, const std::string& address2, uint32_t prop1, uint32_t prop2, int64_t amount1, int64_t amount2, int blockNum, int blockIndex, int64_t fee)
 {
     if (!pdb) return;
-    const std::string key = txid1.ToString() + "+" + txid2.ToString();
-    const std::string value = strprintf("%s:%s:%u:%u:%lu:%lu:%d:%d", address1, address2, prop1, prop2, amount1, amount2, blockNum, fee);
-    leveldb::Status status = pdb->Put(writeoptions, key, value);
+
+    MatchedTrade trade;
+    trade.address1 = address1;
+    trade.address2 = address2;
+    trade.prop1 = prop1;
+    trade.prop2 = prop2;
+    trade.amount1 = amount1;
+    trade.amount2 = amount2;
+    trade.block = blockNum;
+    trade.blockIndex = blockIndex;
+    trade.fee = fee;
+
+    const std::string key = GetMatchKey(MATCH_KEY, txid1, txid2);
+    leveldb::WriteBatch batch;
+    batch.Put(key, SerializeRecord(trade));
+    batch.Put(GetMatchKey(MATCH_REVERSE_KEY, txid2, txid1), "");
+    batch.Put(GetPairKey(trade, txid1, txid2), "");
+    batch.Put(GetBlockKey(blockNum, key), "");
+    leveldb::Status status = pdb->Write(writeoptions, &batch);
     ++nWritten;
     if (msc_debug_tradedb) PrintToLog("%s: %s\n", __func__, status.ToString());
 }
@@ -53,8 +205,21 @@ void CMPTradeList::recordMatchedTrade(const uint256& txid1, const uint256& txid2
 void CMPTradeList::recordNewTrade(const uint256& txid, const std::string& address, uint32_t propertyIdForSale, uint32_t propertyIdDesired, int blockNum, int blockIndex)
 {
     if (!pdb) return;
-    std::string strValue = strprintf("%s:%d:%d:%d:%d", address, propertyIdForSale, propertyIdDesired, blockNum, blockIndex);
-    leveldb::Status status = pdb->Put(writeoptions, txid.ToString(), strValue);
+
+    NewTrade trade;
+    trade.address = address;
+    trade.propertyIdForSale = propertyIdForSale;
+    trade.propertyIdDesired = propertyIdDesired;
+    trade.block = blockNum;
+    trade.blockIndex = blockIndex;
+
+    // the properties are stored in the address index to filter without reading the trade
+    const std::string key = GetNewTradeKey(txid);
+    leveldb::WriteBatch batch;
+    batch.Put(key, SerializeRecord(trade));
+    batch.Put(GetAddressKey(address, blockNum, blockIndex, txid), SerializeRecord(std::make_pair(propertyIdForSale, propertyIdDesired)));
+    batch.Put(GetBlockKey(blockNum, key), "");
+    leveldb::Status status = pdb->Write(writeoptions, &batch);
     ++nWritten;
     if (msc_debug_tradedb) PrintToLog("%s: %s\n", __func__, status.ToString());
 }
@@ -66,29 +231,41 @@ void CMPTradeList::recordNewTrade(const uint256& txid, const std::string& addres
  */
 int CMPTradeList::deleteAboveBlock(int blockNum)
 {
-    leveldb::Slice skey, svalue;
-    unsigned int count = 0;
-    std::vector<std::string> vstr;
-    int block = 0;
+    if (!pdb) return 0;
+
     unsigned int n_found = 0;
+    const std::string blockPrefix(1, BLOCK_KEY);
+    leveldb::WriteBatch batch;
     leveldb::Iterator* it = NewIterator();
-    for (it->SeekToFirst(); it->Valid(); it->Next()) {
-        skey = it->key();
-        svalue = it->value();
-        ++count;
-        std::string strvalue = it->value().ToString();
-        boost::split(vstr, strvalue, boost::is_any_of(":"), boost::token_compress_on);
-        if (7 == vstr.size()) block = atoi(vstr[6]); // trade matches have 7 tokens, key is txid+txid, only care about block
-        if (5 == vstr.size()) block = atoi(vstr[3]); // trades have 5 tokens, key is txid, only care about block
-        if (block >= blockNum) {
+    for (it->Seek(GetBlockKey(blockNum)); it->Valid() && it->key().starts_with(blockPrefix); it->Next()) {
+        // the primary key follows the block
+        leveldb::Slice slKey(it->key().data() + 5, it->key().size() - 5);
+        std::string strValue;
+        if (pdb->Get(readoptions, slKey, &strValue).ok()) {
+            if (slKey[0] == NEW_TRADE_KEY && slKey.size() == 33) {
+                NewTrade trade;
+                if (DeserializeRecord(strValue, trade)) {
+                    batch.Delete(GetAddressKey(trade.address, trade.block, trade.blockIndex, ReadHash(slKey, 1)));
+                }
+            } else if (slKey[0] == MATCH_KEY && slKey.size() == 65) {
+                MatchedTrade trade;
+                const uint256 txid1 = ReadHash(slKey, 1);
+                const uint256 txid2 = ReadHash(slKey, 33);
+                if (DeserializeRecord(strValue, trade)) {
+                    batch.Delete(GetPairKey(trade, txid1, txid2));
+                }
+                batch.Delete(GetMatchKey(MATCH_REVERSE_KEY, txid2, txid1));
+            }
             ++n_found;
-            PrintToLog("%s() DELETING FROM TRADEDB: %s=%s\n", __func__, skey.ToString(), svalue.ToString());
-            pdb->Delete(writeoptions, skey);
+            if (msc_debug_tradedb) PrintToLog("%s() DELETING FROM TRADEDB: %s\n", __func__, HexStr(slKey.ToString()));
+            batch.Delete(slKey);
         }
+        batch.Delete(it->key());
     }
-    
     delete it;
 
+    pdb->Write(writeoptions, &batch);
+
     PrintToLog("%s(%d); tradedb n_found= %d\n", __func__, blockNum, n_found);
 
     return n_found;
@@ -109,7 +286,7 @@ void CMPTradeList::printAll()
         skey = it->key();
         svalue = it->value();
         ++count;
-        PrintToConsole("entry #%8d= %s:%s\n", count, skey.ToString(), svalue.ToString());
+        PrintToConsole("entry #%8d= %s:%s\n", count, HexStr(skey.ToString()), HexStr(svalue.ToString()));
     }
 
     delete it;
@@ -123,163 +300,127 @@ bool CMPTradeList::getMatchingTrades(const uint256& txid, uint32_t propertyId, U
     totalReceived = 0;
     totalSold = 0;
 
-    std::vector<std::string> vstr;
-    std::string txidStr = txid.ToString();
+    // collect the matches, where the transaction is either side of the trade
+    std::vector<std::pair<std::string, uint256> > vecMatches;
     leveldb::Iterator* it = NewIterator();
-    for (it->SeekToFirst(); it->Valid(); it->Next()) {
-        // search key to see if this is a matching trade
-        std::string strKey = it->key().ToString();
-        std::string strValue = it->value().ToString();
-        std::string matchTxid;
-        size_t txidMatch = strKey.find(txidStr);
-        if (txidMatch == std::string::npos) continue; // no match
-
-        // sanity check key is the correct length for a matched trade
-        if (strKey.length() != 129) continue;
-
-        // obtain the txid of the match
-        if (txidMatch == 0) {
-            matchTxid = strKey.substr(65, 64);
-        } else {
-            matchTxid = strKey.substr(0, 64);
+    for (const char prefix : {MATCH_KEY, MATCH_REVERSE_KEY}) {
+        std::string strPrefix(1, prefix);
+        AppendHash(strPrefix, txid);
+        for (it->Seek(strPrefix); it->Valid() && it->key().starts_with(strPrefix); it->Next()) {
+            if (it->key().size() != 65) continue;
+            const uint256 matchTxid = ReadHash(it->key(), 33);
+            if (prefix == MATCH_KEY) {
+                vecMatches.push_back(std::make_pair(it->key().ToString(), matchTxid));
+            } else {
+                vecMatches.push_back(std::make_pair(GetMatchKey(MATCH_KEY, matchTxid, txid), matchTxid));
+            }
         }
+    }
+    delete it;
 
-        // ensure correct amount of tokens in value string
-        boost::split(vstr, strValue, boost::is_any_of(":"), boost::token_compress_on);
-        if (vstr.size() != 8) {
-            PrintToLog("TRADEDB error - unexpected number of tokens in value (%s)\n", strValue);
+    for (const auto& match : vecMatches) {
+        std::string strValue;
+        MatchedTrade trade;
+        ++nRead;
+        if (!pdb->Get(readoptions, match.first, &strValue).ok() || !DeserializeRecord(strValue, trade)) {
+            PrintToLog("TRADEDB error - failed to read matched trade (%s)\n", HexStr(match.first));
             continue;
         }
 
-        // decode the details from the value string
-        std::string address1 = vstr[0];
-        std::string address2 = vstr[1];
-        uint32_t prop1 = boost::lexical_cast<uint32_t>(vstr[2]);
-        uint32_t prop2 = boost::lexical_cast<uint32_t>(vstr[3]);
-        int64_t amount1 = boost::lexical_cast<int64_t>(vstr[4]);
-        int64_t amount2 = boost::lexical_cast<int64_t>(vstr[5]);
-        int blockNum = atoi(vstr[6]);
-        int64_t tradingFee = boost::lexical_cast<int64_t>(vstr[7]);
-
-        std::string strAmount1 = FormatMP(prop1, amount1);
-        std::string strAmount2 = FormatMP(prop2, amount2);
-        std::string strTradingFee = FormatMP(prop2, tradingFee);
-        std::string strAmount2PlusFee = FormatMP(prop2, amount2 + tradingFee);
+        std::string strAmount1 = FormatMP(trade.prop1, trade.amount1);
+        std::string strAmount2 = FormatMP(trade.prop2, trade.amount2);
+        std::string strTradingFee = FormatMP(trade.prop2, trade.fee);
+        std::string strAmount2PlusFee = FormatMP(trade.prop2, trade.amount2 + trade.fee);
 
         // populate trade object and add to the trade array, correcting for orientation of trade
-        UniValue trade(UniValue::VOBJ);
-        trade.pushKV("txid", matchTxid);
-        trade.pushKV("block", blockNum);
-        if (prop1 == propertyId) {
-            trade.pushKV("address", address1);
-            trade.pushKV("amountsold", strAmount1);
-            trade.pushKV("amountreceived", strAmount2);
-            trade.pushKV("tradingfee", strTradingFee);
-            totalReceived += amount2;
-            totalSold += amount1;
+        UniValue tradeObj(UniValue::VOBJ);
+        tradeObj.pushKV("txid", match.second.GetHex());
+        tradeObj.pushKV("block", trade.block);
+        if (trade.prop1 == propertyId) {
+            tradeObj.pushKV("address", trade.address1);
+            tradeObj.pushKV("amountsold", strAmount1);
+            tradeObj.pushKV("amountreceived", strAmount2);
+            tradeObj.pushKV("tradingfee", strTradingFee);
+            totalReceived += trade.amount2;
+            totalSold += trade.amount1;
         } else {
-            trade.pushKV("address", address2);
-            trade.pushKV("amountsold", strAmount2PlusFee);
-            trade.pushKV("amountreceived", strAmount1);
-            trade.pushKV("tradingfee", FormatMP(prop1, 0)); // not the liquidity taker so no fee for this participant - include attribute for standardness
-            totalReceived += amount1;
-            totalSold += amount2;
+            tradeObj.pushKV("address", trade.address2);
+            tradeObj.pushKV("amountsold", strAmount2PlusFee);
+            tradeObj.pushKV("amountreceived", strAmount1);
+            tradeObj.pushKV("tradingfee", FormatMP(trade.prop1, 0)); // not the liquidity taker so no fee for this participant - include attribute for standardness
+            totalReceived += trade.amount1;
+            totalSold += trade.amount2;
         }
-        tradeArray.push_back(trade);
+        tradeArray.push_back(tradeObj);
         ++count;
     }
 
-    // clean up
-    delete it;
-    if (count) {
-        return true;
-    } else {
-        return false;
-    }
+    return count > 0;
 }
 
-
 // obtains a vector of txids where the supplied address participated in a trade (needed for gettradehistory_MP)
 // optional property ID parameter will filter on propertyId transacted if supplied
-// sorted by block then index
-void CMPTradeList::getTradesForAddress(const std::string& address, std::vector<uint256>& vecTransactions, uint32_t propertyIdFilter)
+// sorted by block then index, most recent first, and limited to count transactions
+void CMPTradeList::getTradesForAddress(const std::string& address, std::vector<uint256>& vecTransactions, uint32_t propertyIdFilter, uint64_t count)
 {
     if (!pdb) return;
 
-    std::map<std::string, uint256> mapTrades;
+    const std::string prefix = GetAddressKeyPrefix(address);
     leveldb::Iterator* it = NewIterator();
-    for (it->SeekToFirst(); it->Valid(); it->Next()) {
-        std::string strKey = it->key().ToString();
-        std::string strValue = it->value().ToString();
-        std::vector<std::string> vecValues;
-        if (strKey.size() != 64) continue; // only interested in trades
-        uint256 txid = uint256S(strKey);
-        size_t addressMatch = strValue.find(address);
-        if (addressMatch == std::string::npos) continue;
-        boost::split(vecValues, strValue, boost::is_any_of(":"), boost::token_compress_on);
-        if (vecValues.size() != 5) {
-            PrintToLog("TRADEDB error - unexpected number of tokens in value (%s)\n", strValue);
-            continue;
+    for (SeekToLastWithPrefix(it, prefix); it->Valid() && it->key().starts_with(prefix); it->Prev()) {
+        if (vecTransactions.size() >= count) break;
+        if (it->key().size() != prefix.size() + 40) continue;
+        if (propertyIdFilter != 0) {
+            std::pair<uint32_t, uint32_t> properties;
+            if (!DeserializeRecord(it->value(), properties)) continue;
+            if (propertyIdFilter != properties.first && propertyIdFilter != properties.second) continue;
         }
-        uint32_t propertyIdForSale = boost::lexical_cast<uint32_t>(vecValues[1]);
-        uint32_t propertyIdDesired = boost::lexical_cast<uint32_t>(vecValues[2]);
-        int64_t blockNum = boost::lexical_cast<uint32_t>(vecValues[3]);
-        int64_t txIndex = boost::lexical_cast<uint32_t>(vecValues[4]);
-        if (propertyIdFilter != 0 && propertyIdFilter != propertyIdForSale && propertyIdFilter != propertyIdDesired) continue;
-        std::string sortKey = strprintf("%06d%010d", blockNum, txIndex);
-        mapTrades.insert(std::make_pair(sortKey, txid));
+        vecTransactions.push_back(ReadHash(it->key(), prefix.size() + 8));
     }
     delete it;
-
-    for (std::map<std::string, uint256>::iterator it = mapTrades.begin(); it != mapTrades.end(); it++) {
-        vecTransactions.push_back(it->second);
-    }
-}
-
-static bool CompareTradePair(const std::pair<int64_t, UniValue>& firstJSONObj, const std::pair<int64_t, UniValue>& secondJSONObj)
-{
-    return firstJSONObj.first > secondJSONObj.first;
 }
 
 // obtains an array of matching trades with pricing and volume details for a pair sorted by blocknumber
+// only the most recent count trades are included
 void CMPTradeList::getTradesForPair(uint32_t propertyIdSideA, uint32_t propertyIdSideB, UniValue& responseArray, uint64_t count)
 {
     if (!pdb) return;
-    leveldb::Iterator* it = NewIterator();
-    std::vector<std::pair<int64_t, UniValue> > vecResponse;
+    std::vector<UniValue> vecResponse;
     bool propertyIdSideAIsDivisible = isPropertyDivisible(propertyIdSideA);
     bool propertyIdSideBIsDivisible = isPropertyDivisible(propertyIdSideB);
-    for (it->SeekToFirst(); it->Valid(); it->Next()) {
-        std::string strKey = it->key().ToString();
-        std::string strValue = it->value().ToString();
-        std::vector<std::string> vecKeys;
-        std::vector<std::string> vecValues;
+
+    const std::string prefix = GetPairKeyPrefix(propertyIdSideA, propertyIdSideB);
+    leveldb::Iterator* it = NewIterator();
+    for (SeekToLastWithPrefix(it, prefix); it->Valid() && it->key().starts_with(prefix); it->Prev()) {
+        if (vecResponse.size() >= count) break;
+        if (it->key().size() != prefix.size() + 72) continue;
+        const uint256 txid1 = ReadHash(it->key(), prefix.size() + 8);
+        const uint256 txid2 = ReadHash(it->key(), prefix.size() + 40);
+        std::string strValue;
+        MatchedTrade trade;
+        ++nRead;
+        if (!pdb->Get(readoptions, GetMatchKey(MATCH_KEY, txid1, txid2), &strValue).ok() || !DeserializeRecord(strValue, trade)) {
+            PrintToLog("TRADEDB error - failed to read matched trade (%s+%s)\n", txid1.GetHex(), txid2.GetHex());
+            continue;
+        }
+
         uint256 sellerTxid, matchingTxid;
         std::string sellerAddress, matchingAddress;
         int64_t amountReceived = 0, amountSold = 0;
-        if (strKey.size() != 129) continue; // only interested in matches
-        boost::split(vecKeys, strKey, boost::is_any_of("+"), boost::token_compress_on);
-        boost::split(vecValues, strValue, boost::is_any_of(":"), boost::token_compress_on);
-        if (vecKeys.size() != 2 || vecValues.size() != 8) {
-            PrintToLog("TRADEDB error - unexpected number of tokens (%s:%s)\n", strKey, strValue);
-            continue;
-        }
-        uint32_t tradePropertyIdSideA = boost::lexical_cast<uint32_t>(vecValues[2]);
-        uint32_t tradePropertyIdSideB = boost::lexical_cast<uint32_t>(vecValues[3]);
-        if (tradePropertyIdSideA == propertyIdSideA && tradePropertyIdSideB == propertyIdSideB) {
-            sellerTxid.SetHex(vecKeys[1]);
-            sellerAddress = vecValues[1];
-            amountSold = boost::lexical_cast<int64_t>(vecValues[4]);
-            matchingTxid.SetHex(vecKeys[0]);
-            matchingAddress = vecValues[0];
-            amountReceived = boost::lexical_cast<int64_t>(vecValues[5]);
-        } else if (tradePropertyIdSideB == propertyIdSideA && tradePropertyIdSideA == propertyIdSideB) {
-            sellerTxid.SetHex(vecKeys[0]);
-            sellerAddress = vecValues[0];
-            amountSold = boost::lexical_cast<int64_t>(vecValues[5]);
-            matchingTxid.SetHex(vecKeys[1]);
-            matchingAddress = vecValues[1];
-            amountReceived = boost::lexical_cast<int64_t>(vecValues[4]);
+        if (trade.prop1 == propertyIdSideA && trade.prop2 == propertyIdSideB) {
+            sellerTxid = txid2;
+            sellerAddress = trade.address2;
+            amountSold = trade.amount1;
+            matchingTxid = txid1;
+            matchingAddress = trade.address1;
+            amountReceived = trade.amount2;
+        } else if (trade.prop2 == propertyIdSideA && trade.prop1 == propertyIdSideB) {
+            sellerTxid = txid1;
+            sellerAddress = trade.address1;
+            amountSold = trade.amount2;
+            matchingTxid = txid2;
+            matchingAddress = trade.address2;
+            amountReceived = trade.amount1;
         } else {
             continue;
         }
@@ -291,54 +432,43 @@ void CMPTradeList::getTradesForPair(uint32_t propertyIdSideA, uint32_t propertyI
         std::string unitPriceStr = xToString(unitPrice); // TODO: not here!
         std::string inversePriceStr = xToString(inversePrice);
 
-        int64_t blockNum = boost::lexical_cast<int64_t>(vecValues[6]);
-
-        UniValue trade(UniValue::VOBJ);
-        trade.pushKV("block", blockNum);
-        trade.pushKV("unitprice", unitPriceStr);
-        trade.pushKV("inverseprice", inversePriceStr);
-        trade.pushKV("sellertxid", sellerTxid.GetHex());
-        trade.pushKV("selleraddress", sellerAddress);
+        UniValue tradeObj(UniValue::VOBJ);
+        tradeObj.pushKV("block", trade.block);
+        tradeObj.pushKV("unitprice", unitPriceStr);
+        tradeObj.pushKV("inverseprice", inversePriceStr);
+        tradeObj.pushKV("sellertxid", sellerTxid.GetHex());
+        tradeObj.pushKV("selleraddress", sellerAddress);
         if (propertyIdSideAIsDivisible) {
-            trade.pushKV("amountsold", FormatDivisibleMP(amountSold));
+            tradeObj.pushKV("amountsold", FormatDivisibleMP(amountSold));
         } else {
-            trade.pushKV("amountsold", FormatIndivisibleMP(amountSold));
+            tradeObj.pushKV("amountsold", FormatIndivisibleMP(amountSold));
         }
         if (propertyIdSideBIsDivisible) {
-            trade.pushKV("amountreceived", FormatDivisibleMP(amountReceived));
+            tradeObj.pushKV("amountreceived", FormatDivisibleMP(amountReceived));
         } else {
-            trade.pushKV("amountreceived", FormatIndivisibleMP(amountReceived));
+            tradeObj.pushKV("amountreceived", FormatIndivisibleMP(amountReceived));
         }
-        trade.pushKV("matchingtxid", matchingTxid.GetHex());
-        trade.pushKV("matchingaddress", matchingAddress);
-        vecResponse.push_back(std::make_pair(blockNum, trade));
-    }
-
-    // sort the response most recent first before adding to the array
-    std::sort(vecResponse.begin(), vecResponse.end(), CompareTradePair);
-    uint64_t processed = 0;
-    for (std::vector<std::pair<int64_t, UniValue> >::iterator it = vecResponse.begin(); it != vecResponse.end(); ++it) {
-        responseArray.push_back(it->second);
-        processed++;
-        if (processed >= count) break;
+        tradeObj.pushKV("matchingtxid", matchingTxid.GetHex());
+        tradeObj.pushKV("matchingaddress", matchingAddress);
+        vecResponse.push_back(tradeObj);
     }
+    delete it;
 
-    std::vector<UniValue> responseArrayValues = responseArray.getValues();
-    std::reverse(responseArrayValues.begin(), responseArrayValues.end());
-    responseArray.clear();
-    for (std::vector<UniValue>::iterator it = responseArrayValues.begin(); it != responseArrayValues.end(); ++it) {
-        responseArray.push_back(*it);
+    // the trades were collected most recent first, but are listed in chronological order
+    for (std::vector<UniValue>::reverse_iterator rit = vecResponse.rbegin(); rit != vecResponse.rend(); ++rit) {
+        responseArray.push_back(*rit);
     }
-
-    delete it;
 }
 
 int CMPTradeList::getMPTradeCountTotal()
 {
     int count = 0;
     leveldb::Iterator* it = NewIterator();
-    for (it->SeekToFirst(); it->Valid(); it->Next()) {
-        ++count;
+    for (const char prefix : {MATCH_KEY, NEW_TRADE_KEY}) {
+        const std::string strPrefix(1, prefix);
+        for (it->Seek(strPrefix); it->Valid() && it->key().starts_with(strPrefix); it->Next()) {
+            ++count;
+        }
     }
     delete it;
     return count;
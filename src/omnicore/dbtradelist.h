@@ -4,6 +4,7 @@
 #include <omnicore/dbbase.h>
 
 #include <fs.h>
+#include <serialize.h>
 #include <uint256.h>
 
 #include <univalue.h>
@@ -13,22 +14,76 @@
 #include <string>
 #include <vector>
 
-/** LevelDB based storage for the MetaDEx trade history. Trades are listed with key "txid1+txid2".
+/** LevelDB based storage for the MetaDEx trade history.
+ *
+ * New trades are keyed by the raw 32 byte transaction hash, and matched trades by the hashes of both
+ * orders, with serialized records as values. New trades are additionally indexed by address, and matched
+ * trades by property pair, with block heights and positions stored big-endian, so that secondary keys
+ * are ordered by block and position in the block.
  */
 class CMPTradeList : public CDBBase
 {
 public:
+    /** A new trade, i.e. a MetaDEx order, as stored in the database. */
+    struct NewTrade
+    {
+        std::string address;
+        uint32_t propertyIdForSale = 0;
+        uint32_t propertyIdDesired = 0;
+        int32_t block = 0;
+        int32_t blockIndex = 0;
+
+        ADD_SERIALIZE_METHODS;
+
+        template <typename Stream, typename Operation>
+        inline void SerializationOp(Stream& s, Operation ser_action) {
+            READWRITE(address);
+            READWRITE(propertyIdForSale);
+            READWRITE(propertyIdDesired);
+            READWRITE(block);
+            READWRITE(blockIndex);
+        }
+    };
+
+    /** A matched trade, as stored in the database. The first side is the existing order. */
+    struct MatchedTrade
+    {
+        std::string address1;
+        std::string address2;
+        uint32_t prop1 = 0;
+        uint32_t prop2 = 0;
+        int64_t amount1 = 0;
+        int64_t amount2 = 0;
+        int32_t block = 0;
+        int32_t blockIndex = 0;
+        int64_t fee = 0;
+
+        ADD_SERIALIZE_METHODS;
+
+        template <typename Stream, typename Operation>
+        inline void SerializationOp(Stream& s, Operation ser_action) {
+            READWRITE(address1);
+            READWRITE(address2);
+            READWRITE(prop1);
+            READWRITE(prop2);
+            READWRITE(amount1);
+            READWRITE(amount2);
+            READWRITE(block);
+            READWRITE(blockIndex);
+            READWRITE(fee);
+        }
+    };
+
     CMPTradeList(const fs::path& path, bool fWipe);
     virtual ~CMPTradeList();
 
-    void recordMatchedTrade(const uint256& txid1, const uint256& txid2, const std::string& address1, const std::string& address2, uint32_t prop1, uint32_t prop2, int64_t amount1, int64_t amount2, int blockNum, int64_t fee);
+    void recordMatchedTrade(const uint256& txid1, const uint256& txid2, const std::string& address1, const std::string& address2, uint32_t prop1, uint32_t prop2, int64_t amount1, int64_t amount2, int blockNum, int blockIndex, int64_t fee);
     void recordNewTrade(const uint256& txid, const std::string& address, uint32_t propertyIdForSale, uint32_t propertyIdDesired, int blockNum, int blockIndex);
     int deleteAboveBlock(int blockNum);
-    bool exists(const uint256 &txid);
     void printStats();
     void printAll();
     bool getMatchingTrades(const uint256& txid, uint32_t propertyId, UniValue& tradeArray, int64_t& totalSold, int64_t& totalBought);
-    void getTradesForAddress(const std::string& address, std::vector<uint256>& vecTransactions, uint32_t propertyIdFilter = 0);
+    void getTradesForAddress(const std::string& address, std::vector<uint256>& vecTransactions, uint32_t propertyIdFilter, uint64_t count);
     void getTradesForPair(uint32_t propertyIdSideA, uint32_t propertyIdSideB, UniValue& response, uint64_t count);
     int getMPTradeCountTotal();
 };
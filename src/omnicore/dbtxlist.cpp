@@ -11,7 +11,11 @@
 
 #include <chain.h>
 #include <chainparams.h>
+#include <clientversion.h>
+#include <crypto/common.h>
 #include <fs.h>
+#include <serialize.h>
+#include <streams.h>
 #include <validation.h>
 #include <sync.h>
 #include <tinyformat.h>
@@ -22,14 +26,14 @@
 #include <leveldb/iterator.h>
 #include <leveldb/slice.h>
 #include <leveldb/status.h>
-
-#include <boost/algorithm/string.hpp>
-#include <boost/lexical_cast.hpp>
+#include <leveldb/write_batch.h>
 
 #include <stddef.h>
 #include <stdint.h>
 
 #include <algorithm>
+#include <exception>
+#include <functional>
 #include <string>
 #include <utility>
 #include <vector>
@@ -43,6 +47,168 @@ using mastercore::GetBlockIndex;
 using mastercore::isNonMainNet;
 using mastercore::pDbTransaction;
 
+/**
+ * The transaction list uses binary keys and serialized values.
+ *
+ * Transaction hashes are stored as raw 32 bytes, and block heights and sub record
+ * numbers in big-endian byte order, so that entries are sorted numerically.
+ *
+ *   't' <txid>         -> CMPTxList::TxRecord
+ *   'c' <txid>         -> CMPTxList::TxRecord of a MetaDEx cancel, with the number of cancelled orders
+ *   'p' <txid> <n>     -> PaymentRecord of the n-th payment of a DEx purchase
+ *   'C' <txid> <n>     -> CancelRecord of the n-th order cancelled by a MetaDEx cancel
+ *   's' <txid> <n>     -> (property, amount) of a "send all" sub record
+ *   'g' <txid>         -> (first token, last token) of a non-fungible grant
+ *   'b' <block> <txid> -> (empty, transactions by block)
+ *
+ * The database version is stored as decimal string with key "dbversion", so that
+ * it can be read by clients using any schema.
+ */
+static const char TX_KEY = 't';
+static const char CANCEL_KEY = 'c';
+static const char PAYMENT_KEY = 'p';
+static const char CANCEL_SUB_KEY = 'C';
+static const char SEND_ALL_KEY = 's';
+static const char GRANT_KEY = 'g';
+static const char BLOCK_KEY = 'b';
+
+static const std::string DB_VERSION_KEY = "dbversion";
+
+/** A DEx payment, as stored in the database. */
+struct PaymentRecord
+{
+    uint32_t vout = 0;
+    std::string buyer;
+    std::string seller;
+    uint32_t propertyId = 0;
+    uint64_t amount = 0;
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action) {
+        READWRITE(vout);
+        READWRITE(buyer);
+        READWRITE(seller);
+        READWRITE(propertyId);
+        READWRITE(amount);
+    }
+};
+
+/** An order cancelled by a MetaDEx cancel, as stored in the database. */
+struct CancelRecord
+{
+    uint256 txid;
+    uint32_t propertyId = 0;
+    uint64_t amount = 0;
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action) {
+        READWRITE(txid);
+        READWRITE(propertyId);
+        READWRITE(amount);
+    }
+};
+
+static void AppendBE32(std::string& key, uint32_t n)
+{
+    unsigned char buf[4];
+    WriteBE32(buf, n);
+    key.append(reinterpret_cast<const char*>(buf), sizeof(buf));
+}
+
+static void AppendHash(std::string& key, const uint256& hash)
+{
+    key.append(reinterpret_cast<const char*>(hash.begin()), hash.size());
+}
+
+/** Reads a hash, which is stored at the given offset of a key. */
+static uint256 ReadHash(const leveldb::Slice& key, size_t nOffset)
+{
+    uint256 hash;
+    assert(key.size() >= nOffset + hash.size());
+    std::copy(key.data() + nOffset, key.data() + nOffset + hash.size(), hash.begin());
+    return hash;
+}
+
+static std::string GetTxKey(char prefix, const uint256& txid)
+{
+    std::string key(1, prefix);
+    AppendHash(key, txid);
+    return key;
+}
+
+static std::string GetSubRecordKey(char prefix, const uint256& txid, int subRecordNumber)
+{
+    std::string key = GetTxKey(prefix, txid);
+    AppendBE32(key, subRecordNumber);
+    return key;
+}
+
+/**
+ * Returns the secondary key of a transaction in the block height index.
+ *
+ * Without txid, the returned prefix can be used to seek to the first transaction of a block.
+ */
+static std::string GetBlockKey(int nBlock)
+{
+    std::string key(1, BLOCK_KEY);
+    AppendBE32(key, nBlock);
+    return key;
+}
+
+static std::string GetBlockKey(int nBlock, const uint256& txid)
+{
+    std::string key = GetBlockKey(nBlock);
+    AppendHash(key, txid);
+    return key;
+}
+
+/**
+ * Parses a key of the block height index.
+ *
+ * @return True, if the key is a key of the block height index
+ */
+static bool ParseBlockKey(const leveldb::Slice& key, int& nBlock, uint256& txid)
+{
+    if (key.size() != 1 + 4 + 32 || key[0] != BLOCK_KEY) return false;
+
+    nBlock = ReadBE32(reinterpret_cast<const unsigned char*>(key.data() + 1));
+    txid = ReadHash(key, 5);
+    return true;
+}
+
+template <typename T>
+static std::string SerializeValue(const T& obj)
+{
+    CDataStream ssValue(SER_DISK, CLIENT_VERSION);
+    ssValue << obj;
+    return ssValue.str();
+}
+
+template <typename T>
+static bool DeserializeValue(const leveldb::Slice& slValue, T& obj)
+{
+    try {
+        CDataStream ssValue(slValue.data(), slValue.data() + slValue.size(), SER_DISK, CLIENT_VERSION);
+        ssValue >> obj;
+    } catch (const std::exception& e) {
+        PrintToLog("TXListDB error - failed to deserialize record: %s\n", e.what());
+        return false;
+    }
+    return true;
+}
+
+/** Adds the deletion of all entries with the given prefix to the batch. */
+static void DeleteWithPrefix(leveldb::Iterator* it, const std::string& prefix, leveldb::WriteBatch& batch)
+{
+    for (it->Seek(prefix); it->Valid() && it->key().starts_with(prefix); it->Next()) {
+        batch.Delete(it->key());
+    }
+}
+
 CMPTxList::CMPTxList(const fs::path& path, bool fWipe)
 {
     leveldb::Status status = Open(path, fWipe);
@@ -62,14 +228,20 @@ void CMPTxList::recordTX(const uint256 &txid, bool fValid, int nBlock, unsigned
     // reorgs delete all txs from levelDB above reorg_chain_height
     if (exists(txid)) PrintToLog("LEVELDB TX OVERWRITE DETECTION - %s\n", txid.ToString());
 
-    const std::string key = txid.ToString();
-    const std::string value = strprintf("%u:%d:%u:%lu", fValid ? 1 : 0, nBlock, type, nValue);
-    leveldb::Status status;
+    CMPTxList::TxRecord record;
+    record.valid = fValid;
+    record.block = nBlock;
+    record.type = type;
+    record.value = nValue;
 
     PrintToLog("%s(%s, valid=%s, block= %d, type= %d, value= %lu)\n",
             __func__, txid.ToString(), fValid ? "YES" : "NO", nBlock, type, nValue);
 
-    status = pdb->Put(writeoptions, key, value);
+    // add to the block height index
+    leveldb::WriteBatch batch;
+    batch.Put(GetTxKey(TX_KEY, txid), SerializeValue(record));
+    batch.Put(GetBlockKey(nBlock, txid), "");
+    leveldb::Status status = pdb->Write(writeoptions, &batch);
     ++nWritten;
 }
 
@@ -81,45 +253,37 @@ void CMPTxList::recordPaymentTX(const uint256& txid, bool fValid, int nBlock, un
     unsigned int type = 99999999;
     uint64_t numberOfPayments = 1;
     unsigned int paymentNumber = 1;
-    uint64_t existingNumberOfPayments = 0;
 
     // Step 1 - Check TXList to see if this payment TXID exists
-    bool paymentEntryExists = exists(txid);
-
     // Step 2a - If doesn't exist leave number of payments & paymentNumber set to 1
     // Step 2b - If does exist add +1 to existing number of payments and set this paymentNumber as new numberOfPayments
-    if (paymentEntryExists) {
-        //retrieve old numberOfPayments
-        std::vector<std::string> vstr;
-        std::string strValue;
-        leveldb::Status status = pdb->Get(readoptions, txid.ToString(), &strValue);
-        if (status.ok()) {
-            // parse the string returned
-            boost::split(vstr, strValue, boost::is_any_of(":"), boost::token_compress_on);
-
-            // obtain the existing number of payments
-            if (4 <= vstr.size()) {
-                existingNumberOfPayments = atoi(vstr[3]);
-                paymentNumber = existingNumberOfPayments + 1;
-                numberOfPayments = existingNumberOfPayments + 1;
-            }
-        }
+    CMPTxList::TxRecord record;
+    if (getTX(txid, record)) {
+        paymentNumber = record.value + 1;
+        numberOfPayments = record.value + 1;
     }
 
     // Step 3 - Create new/update master record for payment tx in TXList
-    const std::string key = txid.ToString();
-    const std::string value = strprintf("%u:%d:%u:%lu", fValid ? 1 : 0, nBlock, type, numberOfPayments);
-    leveldb::Status status;
+    record.valid = fValid;
+    record.block = nBlock;
+    record.type = type;
+    record.value = numberOfPayments;
     PrintToLog("DEXPAYDEBUG : Writing master record %s(%s, valid=%s, block= %d, type= %d, number of payments= %lu)\n", __func__, txid.ToString(), fValid ? "YES" : "NO", nBlock, type, numberOfPayments);
-    status = pdb->Put(writeoptions, key, value);
 
     // Step 4 - Write sub-record with payment details
-    const std::string txidStr = txid.ToString();
-    const std::string subKey = STR_PAYMENT_SUBKEY_TXID_PAYMENT_COMBO(txidStr, paymentNumber);
-    const std::string subValue = strprintf("%d:%s:%s:%d:%lu", vout, buyer, seller, propertyId, nValue);
-    leveldb::Status subStatus;
-    PrintToLog("DEXPAYDEBUG : Writing sub-record %s with value %s\n", subKey, subValue);
-    subStatus = pdb->Put(writeoptions, subKey, subValue);
+    PrintToLog("DEXPAYDEBUG : Writing sub-record %s-%d with value %d:%s:%s:%d:%lu\n", txid.ToString(), paymentNumber, vout, buyer, seller, propertyId, nValue);
+    leveldb::WriteBatch batch;
+    batch.Put(GetTxKey(TX_KEY, txid), SerializeValue(record));
+    batch.Put(GetBlockKey(nBlock, txid), "");
+    PaymentRecord payment;
+    payment.vout = vout;
+    payment.buyer = buyer;
+    payment.seller = seller;
+    payment.propertyId = propertyId;
+    payment.amount = nValue;
+    batch.Put(GetSubRecordKey(PAYMENT_KEY, txid, paymentNumber), SerializeValue(payment));
+    leveldb::Status status = pdb->Write(writeoptions, &batch);
+    ++nWritten;
 }
 
 void CMPTxList::recordMetaDExCancelTX(const uint256& txidMaster, const uint256& txidSub, bool fValid, int nBlock, unsigned int propertyId, uint64_t nValue)
@@ -129,39 +293,37 @@ void CMPTxList::recordMetaDExCancelTX(const uint256& txidMaster, const uint256&
     // Prep - setup vars
     unsigned int type = 99992104;
     unsigned int refNumber = 1;
-    uint64_t existingAffectedTXCount = 0;
-    std::string txidMasterStr = txidMaster.ToString() + "-C";
 
     // Step 1 - Check TXList to see if this cancel TXID exists
     // Step 2a - If doesn't exist leave number of affected txs & ref set to 1
     // Step 2b - If does exist add +1 to existing ref and set this ref as new number of affected
-    std::vector<std::string> vstr;
+    const std::string key = GetTxKey(CANCEL_KEY, txidMaster);
+    CMPTxList::TxRecord record;
     std::string strValue;
-    leveldb::Status status = pdb->Get(readoptions, txidMasterStr, &strValue);
-    if (status.ok()) {
-        // parse the string returned
-        boost::split(vstr, strValue, boost::is_any_of(":"), boost::token_compress_on);
-
-        // obtain the existing affected tx count
-        if (4 <= vstr.size()) {
-            existingAffectedTXCount = atoi(vstr[3]);
-            refNumber = existingAffectedTXCount + 1;
-        }
+    if (pdb->Get(readoptions, key, &strValue).ok() && DeserializeValue(strValue, record)) {
+        refNumber = record.value + 1;
     }
 
     // Step 3 - Create new/update master record for cancel tx in TXList
-    const std::string key = txidMasterStr;
-    const std::string value = strprintf("%u:%d:%u:%lu", fValid ? 1 : 0, nBlock, type, refNumber);
+    record.valid = fValid;
+    record.block = nBlock;
+    record.type = type;
+    record.value = refNumber;
     PrintToLog("METADEXCANCELDEBUG : Writing master record %s(%s, valid=%s, block= %d, type= %d, number of affected transactions= %d)\n", __func__, txidMaster.ToString(), fValid ? "YES" : "NO", nBlock, type, refNumber);
-    status = pdb->Put(writeoptions, key, value);
 
     // Step 4 - Write sub-record with cancel details
-    const std::string txidStr = txidMaster.ToString() + "-C";
-    const std::string subKey = STR_REF_SUBKEY_TXID_REF_COMBO(txidStr, refNumber);
-    const std::string subValue = strprintf("%s:%d:%lu", txidSub.ToString(), propertyId, nValue);
-    PrintToLog("METADEXCANCELDEBUG : Writing sub-record %s with value %s\n", subKey, subValue);
-    status = pdb->Put(writeoptions, subKey, subValue);
-    if (msc_debug_txdb) PrintToLog("%s(): store: %s=%s, status: %s\n", __func__, subKey, subValue, status.ToString());
+    PrintToLog("METADEXCANCELDEBUG : Writing sub-record %s-C%d with value %s:%d:%lu\n", txidMaster.ToString(), refNumber, txidSub.ToString(), propertyId, nValue);
+    CancelRecord cancel;
+    cancel.txid = txidSub;
+    cancel.propertyId = propertyId;
+    cancel.amount = nValue;
+    leveldb::WriteBatch batch;
+    batch.Put(key, SerializeValue(record));
+    batch.Put(GetBlockKey(nBlock, txidMaster), "");
+    batch.Put(GetSubRecordKey(CANCEL_SUB_KEY, txidMaster, refNumber), SerializeValue(cancel));
+    leveldb::Status status = pdb->Write(writeoptions, &batch);
+    ++nWritten;
+    if (msc_debug_txdb) PrintToLog("%s(): store: %s-C%d, status: %s\n", __func__, txidMaster.ToString(), refNumber, status.ToString());
 }
 
 
@@ -170,46 +332,24 @@ void CMPTxList::recordMetaDExCancelTX(const uint256& txidMaster, const uint256&
  */
 void CMPTxList::recordSendAllSubRecord(const uint256& txid, int subRecordNumber, uint32_t propertyId, int64_t nValue)
 {
-    std::string strKey = strprintf("%s-%d", txid.ToString(), subRecordNumber);
-    std::string strValue = strprintf("%d:%d", propertyId, nValue);
-
-    leveldb::Status status = pdb->Put(writeoptions, strKey, strValue);
+    leveldb::Status status = pdb->Put(writeoptions, GetSubRecordKey(SEND_ALL_KEY, txid, subRecordNumber), SerializeValue(std::make_pair(propertyId, nValue)));
     ++nWritten;
-    if (msc_debug_txdb) PrintToLog("%s(): store: %s=%s, status: %s\n", __func__, strKey, strValue, status.ToString());
-}
-
-
-std::string CMPTxList::getKeyValue(std::string key)
-{
-    if (!pdb) return "";
-    std::string strValue;
-    leveldb::Status status = pdb->Get(readoptions, key, &strValue);
-    if (status.ok()) {
-        return strValue;
-    } else {
-        return "";
-    }
+    if (msc_debug_txdb) PrintToLog("%s(): store: %s-%d=%d:%d, status: %s\n", __func__, txid.ToString(), subRecordNumber, propertyId, nValue, status.ToString());
 }
 
 uint256 CMPTxList::findMetaDExCancel(const uint256 txid)
 {
-    std::vector<std::string> vstr;
-    std::string txidStr = txid.ToString();
-    leveldb::Slice skey, svalue;
-    uint256 cancelTxid;
+    if (!pdb) return uint256();
+
+    const std::string prefix(1, CANCEL_SUB_KEY);
     leveldb::Iterator* it = NewIterator();
-    for (it->SeekToFirst(); it->Valid(); it->Next()) {
-        skey = it->key();
-        svalue = it->value();
-        std::string svalueStr = svalue.ToString();
-        boost::split(vstr, svalueStr, boost::is_any_of(":"), boost::token_compress_on);
-        // obtain the existing affected tx count
-        if (3 <= vstr.size()) {
-            if (vstr[0] == txidStr) {
-                delete it;
-                cancelTxid.SetHex(skey.ToString());
-                return cancelTxid;
-            }
+    for (it->Seek(prefix); it->Valid() && it->key().starts_with(prefix); it->Next()) {
+        CancelRecord cancel;
+        if (it->key().size() != 1 + 32 + 4 || !DeserializeValue(it->value(), cancel)) continue;
+        if (cancel.txid == txid) {
+            uint256 cancelTxid = ReadHash(it->key(), 1);
+            delete it;
+            return cancelTxid;
         }
     }
 
@@ -222,59 +362,55 @@ uint256 CMPTxList::findMetaDExCancel(const uint256 txid)
  */
 int CMPTxList::getNumberOfSubRecords(const uint256& txid)
 {
-    int numberOfSubRecords = 0;
+    CMPTxList::TxRecord record;
+    if (!getTX(txid, record)) return 0;
+
+    return record.value;
+}
+
+int CMPTxList::getNumberOfMetaDExCancels(const uint256 txid)
+{
+    if (!pdb) return 0;
 
+    CMPTxList::TxRecord record;
     std::string strValue;
-    leveldb::Status status = pdb->Get(readoptions, txid.ToString(), &strValue);
-    if (status.ok()) {
-        std::vector<std::string> vstr;
-        boost::split(vstr, strValue, boost::is_any_of(":"), boost::token_compress_on);
-        if (4 <= vstr.size()) {
-            numberOfSubRecords = boost::lexical_cast<int>(vstr[3]);
-        }
+    if (!pdb->Get(readoptions, GetTxKey(CANCEL_KEY, txid), &strValue).ok() || !DeserializeValue(strValue, record)) {
+        return 0;
     }
 
-    return numberOfSubRecords;
+    return record.value;
 }
 
-int CMPTxList::getNumberOfMetaDExCancels(const uint256 txid)
+bool CMPTxList::getMetaDExCancelDetails(const uint256& txid, int refNumber, uint256& cancelledTxid, uint32_t& propertyId, int64_t& amount)
 {
-    if (!pdb) return 0;
-    int numberOfCancels = 0;
-    std::vector<std::string> vstr;
+    if (!pdb) return false;
+
     std::string strValue;
-    leveldb::Status status = pdb->Get(readoptions, txid.ToString() + "-C", &strValue);
-    if (status.ok()) {
-        // parse the string returned
-        boost::split(vstr, strValue, boost::is_any_of(":"), boost::token_compress_on);
-        // obtain the number of cancels
-        if (4 <= vstr.size()) {
-            numberOfCancels = atoi(vstr[3]);
-        }
+    CancelRecord cancel;
+    if (!pdb->Get(readoptions, GetSubRecordKey(CANCEL_SUB_KEY, txid, refNumber), &strValue).ok() || !DeserializeValue(strValue, cancel)) {
+        return false;
     }
-    return numberOfCancels;
+    cancelledTxid = cancel.txid;
+    propertyId = cancel.propertyId;
+    amount = cancel.amount;
+    return true;
 }
 
 bool CMPTxList::getPurchaseDetails(const uint256 txid, int purchaseNumber, std::string* buyer, std::string* seller, uint64_t* vout, uint64_t* propertyId, uint64_t* nValue)
 {
-    if (!pdb) return 0;
-    std::vector<std::string> vstr;
+    if (!pdb) return false;
+
     std::string strValue;
-    leveldb::Status status = pdb->Get(readoptions, txid.ToString() + "-" + std::to_string(purchaseNumber), &strValue);
-    if (status.ok()) {
-        // parse the string returned
-        boost::split(vstr, strValue, boost::is_any_of(":"), boost::token_compress_on);
-        // obtain the requisite details
-        if (5 == vstr.size()) {
-            *vout = atoi(vstr[0]);
-            *buyer = vstr[1];
-            *seller = vstr[2];
-            *propertyId = atoi64(vstr[3]);
-            *nValue = boost::lexical_cast<boost::uint64_t>(vstr[4]);
-            return true;
-        }
+    PaymentRecord payment;
+    if (!pdb->Get(readoptions, GetSubRecordKey(PAYMENT_KEY, txid, purchaseNumber), &strValue).ok() || !DeserializeValue(strValue, payment)) {
+        return false;
     }
-    return false;
+    *vout = payment.vout;
+    *buyer = payment.buyer;
+    *seller = payment.seller;
+    *propertyId = payment.propertyId;
+    *nValue = payment.amount;
+    return true;
 }
 
 /**
@@ -282,31 +418,23 @@ bool CMPTxList::getPurchaseDetails(const uint256 txid, int purchaseNumber, std::
  */
 bool CMPTxList::getSendAllDetails(const uint256& txid, int subSend, uint32_t& propertyId, int64_t& amount)
 {
-    std::string strKey = strprintf("%s-%d", txid.ToString(), subSend);
     std::string strValue;
-    leveldb::Status status = pdb->Get(readoptions, strKey, &strValue);
-    if (status.ok()) {
-        std::vector<std::string> vstr;
-        boost::split(vstr, strValue, boost::is_any_of(":"), boost::token_compress_on);
-        if (2 == vstr.size()) {
-            propertyId = boost::lexical_cast<uint32_t>(vstr[0]);
-            amount = boost::lexical_cast<int64_t>(vstr[1]);
-            return true;
-        }
+    std::pair<uint32_t, int64_t> subRecord;
+    if (!pdb->Get(readoptions, GetSubRecordKey(SEND_ALL_KEY, txid, subSend), &strValue).ok() || !DeserializeValue(strValue, subRecord)) {
+        return false;
     }
-    return false;
+    propertyId = subRecord.first;
+    amount = subRecord.second;
+    return true;
 }
 
 int CMPTxList::getMPTransactionCountTotal()
 {
     int count = 0;
-    leveldb::Slice skey, svalue;
+    const std::string prefix(1, TX_KEY);
     leveldb::Iterator* it = NewIterator();
-    for (it->SeekToFirst(); it->Valid(); it->Next()) {
-        skey = it->key();
-        if (skey.ToString().length() == 64) {
-            ++count;
-        } //extra entries for cancels and purchases are more than 64 chars long
+    for (it->Seek(prefix); it->Valid() && it->key().starts_with(prefix); it->Next()) {
+        ++count;
     }
     delete it;
     return count;
@@ -314,49 +442,30 @@ int CMPTxList::getMPTransactionCountTotal()
 
 int CMPTxList::getMPTransactionCountBlock(int block)
 {
-    int count = 0;
-    leveldb::Slice skey, svalue;
-    leveldb::Iterator* it = NewIterator();
-    for (it->SeekToFirst(); it->Valid(); it->Next()) {
-        skey = it->key();
-        svalue = it->value();
-        if (skey.ToString().length() == 64) {
-            std::string strValue = svalue.ToString();
-            std::vector<std::string> vstr;
-            boost::split(vstr, strValue, boost::is_any_of(":"), boost::token_compress_on);
-            if (4 == vstr.size()) {
-                if (atoi(vstr[1]) == block) {
-                    ++count;
-                }
-            }
-        }
-    }
-    delete it;
-    return count;
+    std::set<uint256> setTxs;
+
+    return GetOmniTxsInBlockRange(block, block, setTxs);
 }
 
-/** Returns a list of all Omni transactions in the given block range. */
+/**
+ * Returns a list of all Omni transactions in the given block range.
+ *
+ * The block height index is used to seek to the first block, and iteration
+ * stops after the last block.
+ */
 int CMPTxList::GetOmniTxsInBlockRange(int blockFirst, int blockLast, std::set<uint256>& retTxs)
 {
     int count = 0;
     leveldb::Iterator* it = NewIterator();
-    
-    for (it->SeekToFirst(); it->Valid(); it->Next()) {
-        const leveldb::Slice& sKey = it->key();
-        const leveldb::Slice& sValue = it->value();
-
-        if (sKey.ToString().length() == 64) {
-            const std::string& strValue = sValue.ToString();
-            std::vector<std::string> vStr;
-            boost::split(vStr, strValue, boost::is_any_of(":"), boost::token_compress_on);
-            if (4 == vStr.size()) {
-                int blockCurrent = atoi(vStr[1]);
-                if (blockCurrent >= blockFirst && blockCurrent <= blockLast) {
-                    retTxs.insert(uint256S(sKey.ToString()));                    
-                    ++count;
-                }
-            }
+
+    for (it->Seek(GetBlockKey(std::max(blockFirst, 0))); it->Valid(); it->Next()) {
+        int blockCurrent = 0;
+        uint256 txid;
+        if (!ParseBlockKey(it->key(), blockCurrent, txid) || blockCurrent > blockLast) {
+            break;
         }
+        retTxs.insert(txid);
+        ++count;
     }
 
     delete it;
@@ -373,9 +482,9 @@ int CMPTxList::getDBVersion()
     std::string strValue;
     int verDB = 0;
 
-    leveldb::Status status = pdb->Get(readoptions, "dbversion", &strValue);
-    if (status.ok()) {
-        verDB = boost::lexical_cast<uint64_t>(strValue);
+    leveldb::Status status = pdb->Get(readoptions, DB_VERSION_KEY, &strValue);
+    if (status.ok() && !ParseInt32(strValue, &verDB)) {
+        verDB = 0;
     }
 
     if (msc_debug_txdb) PrintToLog("%s(): dbversion %s status %s, line %d, file: %s\n", __func__, strValue, status.ToString(), __LINE__, __FILE__);
@@ -390,8 +499,8 @@ int CMPTxList::getDBVersion()
  */
 int CMPTxList::setDBVersion()
 {
-    std::string verStr = boost::lexical_cast<std::string>(DB_VERSION);
-    leveldb::Status status = pdb->Put(writeoptions, "dbversion", verStr);
+    std::string verStr = strprintf("%d", DB_VERSION);
+    leveldb::Status status = pdb->Put(writeoptions, DB_VERSION_KEY, verStr);
 
     if (msc_debug_txdb) PrintToLog("%s(): dbversion %s status %s, line %d, file: %s\n", __func__, verStr, status.ToString(), __LINE__, __FILE__);
 
@@ -400,28 +509,20 @@ int CMPTxList::setDBVersion()
 
 std::pair<int64_t,int64_t> CMPTxList::GetNonFungibleGrant(const uint256& txid)
 {
-    std::string strKey = strprintf("%s-UG", txid.ToString());
     std::string strValue;
-    leveldb::Status status = pdb->Get(readoptions, strKey, &strValue);
-    if (status.ok()) {
-        std::vector<std::string> vstr;
-        boost::split(vstr, strValue, boost::is_any_of("-"), boost::token_compress_on);
-        if (2 == vstr.size()) {
-            return std::make_pair(boost::lexical_cast<int64_t>(vstr[0]), boost::lexical_cast<int64_t>(vstr[1]));
-        }
+    std::pair<int64_t, int64_t> grantedRange;
+    if (!pdb->Get(readoptions, GetTxKey(GRANT_KEY, txid), &strValue).ok() || !DeserializeValue(strValue, grantedRange)) {
+        return std::make_pair(0,0);
     }
-    return std::make_pair(0,0);
+    return grantedRange;
 }
 
 void CMPTxList::RecordNonFungibleGrant(const uint256& txid, int64_t start, int64_t end)
 {
     assert(pdb);
 
-    const std::string key = txid.ToString() + "-UG";
-    const std::string value = strprintf("%d-%d", start, end);
-
-    leveldb::Status status = pdb->Put(writeoptions, key, value);
-    PrintToLog("%s(): Writing Non-Fungible Grant range %s:%d-%d (%s), line %d, file: %s\n", __FUNCTION__, key, start, end, status.ToString(), __LINE__, __FILE__);
+    leveldb::Status status = pdb->Put(writeoptions, GetTxKey(GRANT_KEY, txid), SerializeValue(std::make_pair(start, end)));
+    PrintToLog("%s(): Writing Non-Fungible Grant range %s-UG:%d-%d (%s), line %d, file: %s\n", __FUNCTION__, txid.ToString(), start, end, status.ToString(), __LINE__, __FILE__);
 }
 
 bool CMPTxList::exists(const uint256 &txid)
@@ -429,25 +530,18 @@ bool CMPTxList::exists(const uint256 &txid)
     if (!pdb) return false;
 
     std::string strValue;
-    leveldb::Status status = pdb->Get(readoptions, txid.ToString(), &strValue);
+    leveldb::Status status = pdb->Get(readoptions, GetTxKey(TX_KEY, txid), &strValue);
 
-    if (!status.ok()) {
-        if (status.IsNotFound()) return false;
-    }
-
-    return true;
+    return status.ok();
 }
 
-bool CMPTxList::getTX(const uint256 &txid, std::string& value)
+bool CMPTxList::getTX(const uint256& txid, TxRecord& record)
 {
-    leveldb::Status status = pdb->Get(readoptions, txid.ToString(), &value);
+    std::string strValue;
+    leveldb::Status status = pdb->Get(readoptions, GetTxKey(TX_KEY, txid), &strValue);
     ++nRead;
 
-    if (status.ok()) {
-        return true;
-    }
-
-    return false;
+    return status.ok() && DeserializeValue(strValue, record);
 }
 
 // call it like so (variable # of parameters):
@@ -459,43 +553,34 @@ bool CMPTxList::getTX(const uint256 &txid, std::string& value)
 //
 bool CMPTxList::getValidMPTX(const uint256& txid, int* block, unsigned int* type, uint64_t* nAmended)
 {
-    std::string result;
-    int validity = 0;
-
     if (msc_debug_txdb) PrintToLog("%s()\n", __func__);
 
     if (!pdb) return false;
 
-    if (!getTX(txid, result)) return false;
+    CMPTxList::TxRecord record;
+    if (!getTX(txid, record)) return false;
 
-    // parse the string returned, find the validity flag/bit & other parameters
-    std::vector<std::string> vstr;
-    boost::split(vstr, result, boost::is_any_of(":"), boost::token_compress_on);
+    if (msc_debug_txdb) PrintToLog("%s() %s: valid=%d, block=%d, type=%d, value=%d\n", __func__, txid.ToString(), record.valid, record.block, record.type, record.value);
 
-    if (msc_debug_txdb) PrintToLog("%s() size=%lu : %s\n", __func__, vstr.size(), result);
-
-    if (1 <= vstr.size()) validity = atoi(vstr[0]);
-
-    if (block) {
-        if (2 <= vstr.size()) *block = atoi(vstr[1]);
-        else *block = 0;
-    }
-
-    if (type) {
-        if (3 <= vstr.size()) *type = atoi(vstr[2]);
-        else *type = 0;
-    }
-
-    if (nAmended) {
-        if (4 <= vstr.size()) *nAmended = boost::lexical_cast<boost::uint64_t>(vstr[3]);
-        else nAmended = 0;
-    }
+    if (block) *block = record.block;
+    if (type) *type = record.type;
+    if (nAmended) *nAmended = record.value;
 
     if (msc_debug_txdb) printStats();
 
-    if ((int) 0 == validity) return false;
+    return record.valid;
+}
 
-    return true;
+void CMPTxList::ForEachTX(const std::function<bool(const uint256&, const TxRecord&)>& fn)
+{
+    const std::string prefix(1, TX_KEY);
+    leveldb::Iterator* it = NewIterator();
+    for (it->Seek(prefix); it->Valid() && it->key().starts_with(prefix); it->Next()) {
+        CMPTxList::TxRecord record;
+        if (it->key().size() != 1 + 32 || !DeserializeValue(it->value(), record)) continue;
+        if (!fn(ReadHash(it->key(), 1), record)) break;
+    }
+    delete it;
 }
 
 std::set<int> CMPTxList::GetSeedBlocks(int startHeight, int endHeight)
@@ -506,15 +591,13 @@ std::set<int> CMPTxList::GetSeedBlocks(int startHeight, int endHeight)
 
     leveldb::Iterator* it = NewIterator();
 
-    for (it->SeekToFirst(); it->Valid(); it->Next()) {
-        std::string itData = it->value().ToString();
-        std::vector<std::string> vstr;
-        boost::split(vstr, itData, boost::is_any_of(":"), boost::token_compress_on);
-        if (4 != vstr.size()) continue; // unexpected number of tokens
-        int block = atoi(vstr[1]);
-        if (block >= startHeight && block <= endHeight) {
-            setSeedBlocks.insert(block);
+    for (it->Seek(GetBlockKey(std::max(startHeight, 0))); it->Valid(); it->Next()) {
+        int block = 0;
+        uint256 txid;
+        if (!ParseBlockKey(it->key(), block, txid) || block > endHeight) {
+            break;
         }
+        setSeedBlocks.insert(block);
     }
 
     delete it;
@@ -525,20 +608,15 @@ std::set<int> CMPTxList::GetSeedBlocks(int startHeight, int endHeight)
 void CMPTxList::LoadAlerts(int blockHeight)
 {
     if (!pdb) return;
-    leveldb::Slice skey, svalue;
-    leveldb::Iterator* it = NewIterator();
 
     std::vector<std::pair<int64_t, uint256> > loadOrder;
 
-    for (it->SeekToFirst(); it->Valid(); it->Next()) {
-        std::string itData = it->value().ToString();
-        std::vector<std::string> vstr;
-        boost::split(vstr, itData, boost::is_any_of(":"), boost::token_compress_on);
-        if (4 != vstr.size()) continue; // unexpected number of tokens
-        if (atoi(vstr[2]) != OMNICORE_MESSAGE_TYPE_ALERT || atoi(vstr[0]) != 1) continue; // not a valid alert
-        uint256 txid = uint256S(it->key().ToString());
-        loadOrder.push_back(std::make_pair(atoi(vstr[1]), txid));
-    }
+    ForEachTX([&loadOrder](const uint256& txid, const TxRecord& record) {
+        if (record.type == OMNICORE_MESSAGE_TYPE_ALERT && record.valid) {
+            loadOrder.push_back(std::make_pair(record.block, txid));
+        }
+        return true;
+    });
 
     std::sort(loadOrder.begin(), loadOrder.end());
 
@@ -581,7 +659,6 @@ void CMPTxList::LoadAlerts(int blockHeight)
         }
     }
 
-    delete it;
     int64_t blockTime = 0;
     {
         LOCK(cs_main);
@@ -599,22 +676,17 @@ void CMPTxList::LoadActivations(int blockHeight)
 {
     if (!pdb) return;
 
-    leveldb::Slice skey, svalue;
-    leveldb::Iterator* it = NewIterator();
-
     PrintToLog("Loading feature activations from levelDB\n");
 
     std::vector<std::pair<int64_t, uint256> > loadOrder;
 
-    for (it->SeekToFirst(); it->Valid(); it->Next()) {
-        std::string itData = it->value().ToString();
-        std::vector<std::string> vstr;
-        boost::split(vstr, itData, boost::is_any_of(":"), boost::token_compress_on);
-        if (4 != vstr.size()) continue; // unexpected number of tokens
-        if (atoi(vstr[2]) != OMNICORE_MESSAGE_TYPE_ACTIVATION || atoi(vstr[0]) != 1) continue; // we only care about valid activations
-        uint256 txid = uint256S(it->key().ToString());
-        loadOrder.push_back(std::make_pair(atoi(vstr[1]), txid));
-    }
+    ForEachTX([&loadOrder](const uint256& txid, const TxRecord& record) {
+        // we only care about valid activations
+        if (record.type == OMNICORE_MESSAGE_TYPE_ACTIVATION && record.valid) {
+            loadOrder.push_back(std::make_pair(record.block, txid));
+        }
+        return true;
+    });
 
     std::sort(loadOrder.begin(), loadOrder.end());
 
@@ -660,7 +732,6 @@ void CMPTxList::LoadActivations(int blockHeight)
             continue;
         }
     }
-    delete it;
     CheckLiveActivations(blockHeight);
 
     // This alert never expires as long as custom activations are used
@@ -676,25 +747,17 @@ bool CMPTxList::LoadFreezeState(int blockHeight)
 
     std::vector<std::pair<std::string, uint256> > loadOrder;
     int txnsLoaded = 0;
-    leveldb::Iterator* it = NewIterator();
     PrintToLog("Loading freeze state from levelDB\n");
 
-    for (it->SeekToFirst(); it->Valid(); it->Next()) {
-        std::string itData = it->value().ToString();
-        std::vector<std::string> vstr;
-        boost::split(vstr, itData, boost::is_any_of(":"), boost::token_compress_on);
-        if (4 != vstr.size()) continue;
-        uint16_t txtype = atoi(vstr[2]);
-        if (txtype != MSC_TYPE_FREEZE_PROPERTY_TOKENS && txtype != MSC_TYPE_UNFREEZE_PROPERTY_TOKENS &&
-                txtype != MSC_TYPE_ENABLE_FREEZING && txtype != MSC_TYPE_DISABLE_FREEZING) continue;
-        if (atoi(vstr[0]) != 1) continue; // invalid, ignore
-        uint256 txid = uint256S(it->key().ToString());
+    ForEachTX([&loadOrder](const uint256& txid, const TxRecord& record) {
+        if (record.type != MSC_TYPE_FREEZE_PROPERTY_TOKENS && record.type != MSC_TYPE_UNFREEZE_PROPERTY_TOKENS &&
+                record.type != MSC_TYPE_ENABLE_FREEZING && record.type != MSC_TYPE_DISABLE_FREEZING) return true;
+        if (!record.valid) return true; // invalid, ignore
         int txPosition = pDbTransaction->FetchTransactionPosition(txid);
-        std::string sortKey = strprintf("%06d%010d", atoi(vstr[1]), txPosition);
+        std::string sortKey = strprintf("%06d%010d", record.block, txPosition);
         loadOrder.push_back(std::make_pair(sortKey, txid));
-    }
-
-    delete it;
+        return true;
+    });
 
     std::sort(loadOrder.begin(), loadOrder.end());
 
@@ -755,16 +818,14 @@ bool CMPTxList::CheckForFreezeTxs(int blockHeight)
 
     leveldb::Iterator* it = NewIterator();
 
-    for (it->SeekToFirst(); it->Valid(); it->Next()) {
-        std::string itData = it->value().ToString();
-        std::vector<std::string> vstr;
-        boost::split(vstr, itData, boost::is_any_of(":"), boost::token_compress_on);
-        if (4 != vstr.size()) continue;
-        int block = atoi(vstr[1]);
-        if (block < blockHeight) continue;
-        uint16_t txtype = atoi(vstr[2]);
-        if (txtype == MSC_TYPE_FREEZE_PROPERTY_TOKENS || txtype == MSC_TYPE_UNFREEZE_PROPERTY_TOKENS ||
-                txtype == MSC_TYPE_ENABLE_FREEZING || txtype == MSC_TYPE_DISABLE_FREEZING) {
+    for (it->Seek(GetBlockKey(std::max(blockHeight, 0))); it->Valid(); it->Next()) {
+        int block = 0;
+        uint256 txid;
+        if (!ParseBlockKey(it->key(), block, txid)) break;
+        TxRecord record;
+        if (!getTX(txid, record)) continue;
+        if (record.type == MSC_TYPE_FREEZE_PROPERTY_TOKENS || record.type == MSC_TYPE_UNFREEZE_PROPERTY_TOKENS ||
+                record.type == MSC_TYPE_ENABLE_FREEZING || record.type == MSC_TYPE_DISABLE_FREEZING) {
             delete it;
             return true;
         }
@@ -789,7 +850,7 @@ void CMPTxList::printAll()
         skey = it->key();
         svalue = it->value();
         ++count;
-        PrintToConsole("entry #%8d= %s:%s\n", count, skey.ToString(), svalue.ToString());
+        PrintToConsole("entry #%8d= %s:%s\n", count, HexStr(skey.ToString()), HexStr(svalue.ToString()));
     }
 
     delete it;
@@ -800,40 +861,40 @@ void CMPTxList::printAll()
 // pass in bDeleteFound = true to erase each entry found within the block range
 bool CMPTxList::isMPinBlockRange(int starting_block, int ending_block, bool bDeleteFound)
 {
-    leveldb::Slice skey, svalue;
-    unsigned int count = 0;
-    std::vector<std::string> vstr;
-    int block;
     unsigned int n_found = 0;
+    leveldb::WriteBatch batch;
 
     leveldb::Iterator* it = NewIterator();
+    leveldb::Iterator* itSub = NewIterator();
+
+    // the block height index refers to all records of the transactions within the range
+    for (it->Seek(GetBlockKey(std::max(starting_block, 0))); it->Valid(); it->Next()) {
+        int block = 0;
+        uint256 txid;
+        if (!ParseBlockKey(it->key(), block, txid) || block > ending_block) {
+            break;
+        }
+        ++n_found;
+        if (!bDeleteFound) continue;
+
+        PrintToLog("%s() DELETING: %s, block %d\n", __func__, txid.ToString(), block);
+        batch.Delete(GetTxKey(TX_KEY, txid));
+        batch.Delete(GetTxKey(CANCEL_KEY, txid));
+        batch.Delete(GetTxKey(GRANT_KEY, txid));
+        DeleteWithPrefix(itSub, GetTxKey(PAYMENT_KEY, txid), batch);
+        DeleteWithPrefix(itSub, GetTxKey(CANCEL_SUB_KEY, txid), batch);
+        DeleteWithPrefix(itSub, GetTxKey(SEND_ALL_KEY, txid), batch);
+        batch.Delete(it->key());
+    }
 
-    for (it->SeekToFirst(); it->Valid(); it->Next()) {
-        skey = it->key();
-        svalue = it->value();
-
-        ++count;
-
-        std::string strvalue = it->value().ToString();
-
-        // parse the string returned, find the validity flag/bit & other parameters
-        boost::split(vstr, strvalue, boost::is_any_of(":"), boost::token_compress_on);
-
-        // only care about the block number/height here
-        if (2 <= vstr.size()) {
-            block = atoi(vstr[1]);
+    delete itSub;
+    delete it;
 
-            if ((starting_block <= block) && (block <= ending_block)) {
-                ++n_found;
-                PrintToLog("%s() DELETING: %s=%s\n", __func__, skey.ToString(), svalue.ToString());
-                if (bDeleteFound) pdb->Delete(writeoptions, skey);
-            }
-        }
+    if (bDeleteFound) {
+        pdb->Write(writeoptions, &batch);
     }
 
     PrintToLog("%s(%d, %d); n_found= %d\n", __func__, starting_block, ending_block, n_found);
 
-    delete it;
-
     return (n_found);
 }
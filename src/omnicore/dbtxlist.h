@@ -5,18 +5,45 @@
 #include <omnicore/nftdb.h>
 
 #include <fs.h>
+#include <serialize.h>
 #include <uint256.h>
 
 #include <stdint.h>
 
+#include <functional>
 #include <set>
 #include <string>
+#include <utility>
 
 /** LevelDB based storage for transactions, with txid as key and validity bit, and other data as value.
+ *
+ * Keys are binary, with raw 32 byte transaction hashes, and values are serialized records. Transactions
+ * are additionally indexed by block height, with heights stored big-endian, so that the index is ordered
+ * by block.
  */
 class CMPTxList : public CDBBase
 {
 public:
+    /** A transaction, as stored in the database. */
+    struct TxRecord
+    {
+        bool valid = false;
+        int32_t block = 0;
+        uint32_t type = 0;
+        //! The amount, or the number of sub records of payments, cancels and "send all" transactions
+        uint64_t value = 0;
+
+        ADD_SERIALIZE_METHODS;
+
+        template <typename Stream, typename Operation>
+        inline void SerializationOp(Stream& s, Operation ser_action) {
+            READWRITE(valid);
+            READWRITE(block);
+            READWRITE(type);
+            READWRITE(value);
+        }
+    };
+
     CMPTxList(const fs::path& path, bool fWipe);
     virtual ~CMPTxList();
 
@@ -28,11 +55,12 @@ public:
     /** Records the range awarded in a grant applied to a non-fungible property. */
     void RecordNonFungibleGrant(const uint256 &txid, int64_t start, int64_t end);
 
-    std::string getKeyValue(std::string key);
     uint256 findMetaDExCancel(const uint256 txid);
     /** Returns the number of sub records. */
     int getNumberOfSubRecords(const uint256& txid);
     int getNumberOfMetaDExCancels(const uint256 txid);
+    /** Retrieves details about an order cancelled by a MetaDEx cancel. */
+    bool getMetaDExCancelDetails(const uint256& txid, int refNumber, uint256& cancelledTxid, uint32_t& propertyId, int64_t& amount);
     bool getPurchaseDetails(const uint256 txid, int purchaseNumber, std::string* buyer, std::string* seller, uint64_t* vout, uint64_t *propertyId, uint64_t* nValue);
     /** Retrieves details about a "send all" record. */
     bool getSendAllDetails(const uint256& txid, int subSend, uint32_t& propertyId, int64_t& amount);
@@ -48,7 +76,7 @@ public:
     int setDBVersion();
 
     bool exists(const uint256& txid);
-    bool getTX(const uint256& txid, std::string& value);
+    bool getTX(const uint256& txid, TxRecord& record);
     bool getValidMPTX(const uint256& txid, int* block = nullptr, unsigned int* type = nullptr, uint64_t* nAmended = nullptr);
 
     std::set<int> GetSeedBlocks(int startHeight, int endHeight);
@@ -61,6 +89,10 @@ public:
     void printAll();
 
     bool isMPinBlockRange(int, int, bool);
+
+private:
+    /** Calls the function for each transaction record, until it returns false. */
+    void ForEachTX(const std::function<bool(const uint256&, const TxRecord&)>& fn);
 };
 
 namespace mastercore
@@ -22,6 +22,7 @@
 
 #include <stdint.h>
 
+#include <algorithm>
 #include <fstream>
 #include <map>
 #include <set>
@@ -31,6 +32,55 @@
 
 namespace mastercore
 {
+/**
+ * Adds an accept, unless an accept with the same key already exists.
+ */
+std::pair<AcceptMap::iterator, bool> AcceptMap::insert(const std::pair<std::string, CMPAccept>& entry)
+{
+    std::pair<iterator, bool> result = mapAccepts.insert(entry);
+    if (result.second) {
+        setExpiries.insert(std::make_pair(entry.second.getExpiryBlock(), entry.first));
+    }
+
+    return result;
+}
+
+/**
+ * Removes an accept and its expiry entry.
+ */
+void AcceptMap::erase(iterator it)
+{
+    setExpiries.erase(std::make_pair(it->second.getExpiryBlock(), it->first));
+    mapAccepts.erase(it);
+}
+
+/**
+ * Removes all accepts.
+ */
+void AcceptMap::clear()
+{
+    mapAccepts.clear();
+    setExpiries.clear();
+}
+
+/**
+ * Collects the keys of the accepts, which expire at or before the given block.
+ *
+ * The keys are returned in lexicographical order, which is the order in which
+ * the whole collection was traversed, before the expiry index was introduced.
+ */
+std::vector<std::string> AcceptMap::getExpired(int block) const
+{
+    std::vector<std::string> vKeys;
+    for (std::set<std::pair<int, std::string> >::const_iterator it = setExpiries.begin(); it != setExpiries.end(); ++it) {
+        if (it->first > block) break;
+        vKeys.push_back(it->second);
+    }
+    std::sort(vKeys.begin(), vKeys.end());
+
+    return vKeys;
+}
+
 /**
  * Checks, if such a sell offer exists.
  */
@@ -366,7 +416,7 @@ int DEx_acceptCreate(const std::string& addressBuyer, const std::string& address
         assert(update_tally_map(addressSeller, propertyId, -amountReserved, SELLOFFER_RESERVE));
         assert(update_tally_map(addressSeller, propertyId, amountReserved, ACCEPT_RESERVE));
 
-        CMPAccept acceptOffer(amountReserved, block, offer.getBlockTimeLimit(), offer.getProperty(), offer.getOfferAmountOriginal(), offer.getXEPDesiredOriginal(), offer.getHash());
+        CMPAccept acceptOffer(amountReserved, block, offer.getBlockTimeLimit(), offer.getProperty(), offer.getOfferAmountOriginal(), offer.getXEPDesiredOriginal(), offer.getHash(), addressSeller, addressBuyer);
         my_accepts.insert(std::make_pair(keyAcceptOrder, acceptOffer));
 
         rc = 0;
@@ -613,36 +663,27 @@ int DEx_payment(const uint256& txid, unsigned int vout, const std::string& addre
 unsigned int eraseExpiredAccepts(int blockNow)
 {
     unsigned int how_many_erased = 0;
-    AcceptMap::iterator it = my_accepts.begin();
 
-    while (my_accepts.end() != it) {
-        const CMPAccept& acceptOrder = it->second;
+    // only the accepts with a payment window ending at or before this block are visited
+    const std::vector<std::string> vExpired = my_accepts.getExpired(blockNow);
 
-        int blocksSinceAccept = blockNow - acceptOrder.getAcceptBlock();
-        int blocksPaymentWindow = static_cast<int>(acceptOrder.getBlockTimeLimit());
+    for (std::vector<std::string>::const_iterator it = vExpired.begin(); it != vExpired.end(); ++it) {
+        AcceptMap::iterator itAccept = my_accepts.find(*it);
+        assert(itAccept != my_accepts.end());
+        const CMPAccept& acceptOrder = itAccept->second;
 
-        if (blocksSinceAccept >= blocksPaymentWindow) {
-            PrintToLog("%s: sell offer: %s\n", __func__, acceptOrder.getHash().GetHex());
-            PrintToLog("%s: erasing at block: %d, order confirmed at block: %d, payment window: %d\n",
-                    __func__, blockNow, acceptOrder.getAcceptBlock(), acceptOrder.getBlockTimeLimit());
+        PrintToLog("%s: sell offer: %s\n", __func__, acceptOrder.getHash().GetHex());
+        PrintToLog("%s: erasing at block: %d, order confirmed at block: %d, payment window: %d\n",
+                __func__, blockNow, acceptOrder.getAcceptBlock(), acceptOrder.getBlockTimeLimit());
 
-            // extract the seller, buyer and property from the key
-            std::vector<std::string> vstr;
-            boost::split(vstr, it->first, boost::is_any_of("-+"), boost::token_compress_on);
-            std::string addressSeller = vstr[0];
-            uint32_t propertyId = atoi(vstr[1]);
-            std::string addressBuyer = vstr[2];
-
-            DEx_acceptDestroy(addressBuyer, addressSeller, propertyId);
+        DEx_acceptDestroy(acceptOrder.getBuyer(), acceptOrder.getSeller(), acceptOrder.getProperty());
 
-            my_accepts.erase(it++);
+        my_accepts.erase(itAccept);
 
-            ++how_many_erased;
-        } else it++;
+        ++how_many_erased;
     }
 
     return how_many_erased;
 }
 
-
 } // namespace mastercore
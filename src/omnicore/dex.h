@@ -13,7 +13,10 @@
 #include <stdint.h>
 #include <fstream>
 #include <map>
+#include <set>
 #include <string>
+#include <utility>
+#include <vector>
 
 /** Lookup key to find DEx offers. */
 inline std::string STR_SELLOFFER_ADDR_PROP_COMBO(const std::string& address, uint32_t propertyId)
@@ -25,16 +28,6 @@ inline std::string STR_ACCEPT_ADDR_PROP_ADDR_COMBO(const std::string& seller, co
 {
     return strprintf("%s-%d+%s", seller, propertyId, buyer);
 }
-/** Lookup key to find DEx payments. */
-inline std::string STR_PAYMENT_SUBKEY_TXID_PAYMENT_COMBO(const std::string& txidStr, unsigned int paymentNumber)
-{
-    return strprintf("%s-%d", txidStr, paymentNumber);
-}
-/** Lookup key to find MetaDEx sub-records. TODO: not here! */
-inline std::string STR_REF_SUBKEY_TXID_REF_COMBO(const std::string& txidStr, unsigned int refNumber)
-{
-    return strprintf("%s%d", txidStr, refNumber);
-}
 
 /** A single outstanding offer, from one seller of one property.
  *
@@ -128,6 +121,9 @@ private:
     uint256 offer_txid;
     int block;
 
+    std::string seller;
+    std::string buyer;
+
 public:
     // TODO: it may not intuitive that this is *not* the hash of the accept order
     uint256 getHash() const { return offer_txid; }
@@ -141,12 +137,19 @@ public:
     uint32_t getProperty() const { return property; }
 
     int getAcceptBlock() const { return block; }
+    /** Returns the block, at which the payment window ends and the accept expires. */
+    int getExpiryBlock() const { return block + static_cast<int>(blocktimelimit); }
+
+    const std::string& getSeller() const { return seller; }
+    const std::string& getBuyer() const { return buyer; }
 
     CMPAccept(int64_t amountAccepted, int blockIn, uint8_t paymentWindow, uint32_t propertyId,
-              int64_t offerAmountOriginal, int64_t amountDesired, const uint256& txid)
+              int64_t offerAmountOriginal, int64_t amountDesired, const uint256& txid,
+              const std::string& addressSeller, const std::string& addressBuyer)
       : accept_amount_remaining(amountAccepted), blocktimelimit(paymentWindow),
         property(propertyId), offer_amount_original(offerAmountOriginal),
-        XEP_desired_original(amountDesired), offer_txid(txid), block(blockIn)
+        XEP_desired_original(amountDesired), offer_txid(txid), block(blockIn),
+        seller(addressSeller), buyer(addressBuyer)
     {
         accept_amount_original = accept_amount_remaining;
         PrintToLog("%s(%d): %s\n", __func__, amountAccepted, txid.GetHex());
@@ -154,11 +157,13 @@ public:
 
     CMPAccept(int64_t acceptAmountOriginal, int64_t acceptAmountRemaining, int blockIn,
               uint8_t paymentWindow, uint32_t propertyId, int64_t offerAmountOriginal,
-              int64_t amountDesired, const uint256& txid)
+              int64_t amountDesired, const uint256& txid, const std::string& addressSeller,
+              const std::string& addressBuyer)
       : accept_amount_original(acceptAmountOriginal),
         accept_amount_remaining(acceptAmountRemaining), blocktimelimit(paymentWindow),
         property(propertyId), offer_amount_original(offerAmountOriginal),
-        XEP_desired_original(amountDesired), offer_txid(txid), block(blockIn)
+        XEP_desired_original(amountDesired), offer_txid(txid), block(blockIn),
+        seller(addressSeller), buyer(addressBuyer)
     {
         PrintToLog("%s(%d[%d]): %s\n", __func__, acceptAmountRemaining, acceptAmountOriginal, txid.GetHex());
     }
@@ -194,10 +199,10 @@ public:
         return bRet;
     }
 
-    void saveAccept(std::ofstream& file, const std::string& address, const std::string& buyer, CHash256& hasher) const
+    void saveAccept(std::ofstream& file, CHash256& hasher) const
     {
         std::string lineOut = strprintf("%s,%d,%s,%d,%d,%d,%d,%d,%d,%s",
-                address,
+                seller,
                 property,
                 buyer,
                 block,
@@ -219,7 +224,41 @@ public:
 namespace mastercore
 {
 typedef std::map<std::string, CMPOffer> OfferMap;
-typedef std::map<std::string, CMPAccept> AcceptMap;
+
+/**
+ * In-memory collection of DEx accepts, keyed by seller, property and buyer.
+ *
+ * Accepts are additionally indexed by the block at which they expire, so that
+ * only the expired accepts need to be visited at the begin of a block.
+ */
+class AcceptMap
+{
+public:
+    typedef std::map<std::string, CMPAccept>::iterator iterator;
+    typedef std::map<std::string, CMPAccept>::const_iterator const_iterator;
+
+private:
+    std::map<std::string, CMPAccept> mapAccepts;
+    //! Keys of the accepts, ordered by expiry block
+    std::set<std::pair<int, std::string> > setExpiries;
+
+public:
+    iterator begin() { return mapAccepts.begin(); }
+    iterator end() { return mapAccepts.end(); }
+    const_iterator begin() const { return mapAccepts.begin(); }
+    const_iterator end() const { return mapAccepts.end(); }
+
+    iterator find(const std::string& key) { return mapAccepts.find(key); }
+    const_iterator find(const std::string& key) const { return mapAccepts.find(key); }
+    size_t size() const { return mapAccepts.size(); }
+
+    std::pair<iterator, bool> insert(const std::pair<std::string, CMPAccept>& entry);
+    void erase(iterator it);
+    void clear();
+
+    /** Returns the keys of all accepts, which expire at or before the given block. */
+    std::vector<std::string> getExpired(int block) const;
+};
 
 //! In-memory collection of DEx offers
 extern OfferMap my_offers;
@@ -0,0 +1,71 @@
+/**
+ * @file inputcache.cpp
+ *
+ * Provides a bounded cache of resolved transaction inputs, which is used to
+ * identify the senders of Omni transactions.
+ */
+
+#include <omnicore/inputcache.h>
+
+#include <coins.h>
+#include <primitives/transaction.h>
+
+#include <stddef.h>
+#include <algorithm>
+#include <utility>
+
+namespace mastercore
+{
+CMPInputCache::CMPInputCache(size_t nMaxSizeIn)
+  : nMaxSize(std::max<size_t>(1, nMaxSizeIn)), nEvictions(0)
+{
+}
+
+bool CMPInputCache::GetCoin(const COutPoint& outpoint, Coin& coin) const
+{
+    auto it = index.find(outpoint);
+    if (it == index.end()) return false;
+
+    coins.splice(coins.begin(), coins, it->second);
+    coin = it->second->second;
+
+    return !coin.IsSpent();
+}
+
+bool CMPInputCache::HaveCoin(const COutPoint& outpoint) const
+{
+    auto it = index.find(outpoint);
+    return it != index.end() && !it->second->second.IsSpent();
+}
+
+void CMPInputCache::AddCoin(const COutPoint& outpoint, const Coin& coin)
+{
+    auto it = index.find(outpoint);
+    if (it != index.end()) {
+        it->second->second = coin;
+        coins.splice(coins.begin(), coins, it->second);
+        return;
+    }
+
+    coins.emplace_front(outpoint, coin);
+    index.emplace(outpoint, coins.begin());
+    SetMaxSize(nMaxSize);
+}
+
+void CMPInputCache::SetMaxSize(size_t nMaxSizeIn)
+{
+    nMaxSize = std::max<size_t>(1, nMaxSizeIn);
+
+    while (index.size() > nMaxSize) {
+        index.erase(coins.back().first);
+        coins.pop_back();
+        ++nEvictions;
+    }
+}
+
+void CMPInputCache::Clear()
+{
+    index.clear();
+    coins.clear();
+}
+}
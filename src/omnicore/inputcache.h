@@ -0,0 +1,64 @@
+#ifndef XEP_OMNICORE_INPUTCACHE_H
+#define XEP_OMNICORE_INPUTCACHE_H
+
+#include <coins.h>
+#include <primitives/transaction.h>
+
+#include <stddef.h>
+#include <stdint.h>
+#include <list>
+#include <unordered_map>
+#include <utility>
+
+namespace mastercore
+{
+/**
+ * Bounded cache of resolved transaction inputs.
+ *
+ * It's used as backend of the coins view cache for transaction inputs, so coins
+ * fetched by the view are served from here. Once the cache is full, the least
+ * recently used coins are evicted first. At least one coin is kept, so a coin
+ * is never evicted right after it was added.
+ *
+ * Note: the cache is not thread-safe, and cs_tx_cache should be locked!
+ */
+class CMPInputCache : public CCoinsView
+{
+private:
+    typedef std::list<std::pair<COutPoint, Coin> > CoinList;
+
+    //! Coins ordered by recency of use, most recently used first
+    mutable CoinList coins;
+    //! Index of the coins by outpoint
+    std::unordered_map<COutPoint, CoinList::iterator, SaltedOutpointHasher> index;
+    //! Maximum number of coins
+    size_t nMaxSize;
+
+    //! Number of coins evicted
+    uint64_t nEvictions;
+
+public:
+    explicit CMPInputCache(size_t nMaxSizeIn);
+
+    /** Retrieves a coin and marks it as recently used. */
+    bool GetCoin(const COutPoint& outpoint, Coin& coin) const override;
+    /** Checks whether a coin is cached, without affecting the order of eviction. */
+    bool HaveCoin(const COutPoint& outpoint) const override;
+
+    /** Adds a coin, or updates an existing one, and evicts old coins, if the cache is full. */
+    void AddCoin(const COutPoint& outpoint, const Coin& coin);
+    /** Changes the maximum number of coins, which is at least one. */
+    void SetMaxSize(size_t nMaxSizeIn);
+    /** Removes all coins. */
+    void Clear();
+
+    /** Returns the number of cached coins. */
+    size_t size() const { return index.size(); }
+    /** Returns the maximum number of cached coins. */
+    size_t maxSize() const { return nMaxSize; }
+    /** Returns the number of coins evicted. */
+    uint64_t evictions() const { return nEvictions; }
+};
+}
+
+#endif // XEP_OMNICORE_INPUTCACHE_H
@@ -7,18 +7,22 @@
 #include <util/time.h>
 
 #include <assert.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <atomic>
+#include <condition_variable>
 #include <mutex>
 #include <string>
+#include <thread>
+#include <utility>
 #include <vector>
 
 // Default log files
 const std::string LOG_FILENAME    = "omnicore.log";
 
 // Options
-static const long LOG_BUFFERSIZE  =  8000000; //  8 MB
-static const long LOG_SHRINKSIZE  = 50000000; // 50 MB
+static const size_t LOG_BUFFERSIZE    =  8000000; //  8 MB of messages not yet written
+static const uintmax_t LOG_ROTATESIZE = 50000000; // 50 MB
 
 // Debug flags
 bool msc_debug_parser_data        = 0;
@@ -67,6 +71,35 @@ bool msc_debug_fees               = 1;
 //! Debug the non-fungible tokens database
 bool msc_debug_nftdb              = 0;
 
+/** A message to log, and the time at which it was logged. */
+struct LogRecord
+{
+    int64_t nTime;
+    std::string str;
+};
+
+/**
+ * Messages, which are handed over to the log writer thread.
+ *
+ * Logging threads only move their formatted message into the buffer, while
+ * the writer thread takes all buffered messages at once and writes them in
+ * one batch. If the buffer is full, the message is dropped, so logging never
+ * waits for the disk.
+ */
+struct LogBuffer
+{
+    std::mutex mutex;
+    std::condition_variable cond;
+    //! Messages not yet written
+    std::vector<LogRecord> vRecords;
+    //! Total size of the messages not yet written
+    size_t nBytes = 0;
+    //! Number of messages dropped since the last batch
+    uint64_t nDropped = 0;
+    //! Whether the writer thread should exit, once the buffer is empty
+    bool fStopRequested = false;
+};
+
 /**
  * LogPrintf() has been broken a couple of times now
  * by well-meaning people adding mutexes in the most straightforward way.
@@ -83,7 +116,11 @@ static std::once_flag debugLogInitFlag;
  * in a thread-safe manner the first time called:
  */
 static FILE* fileout = nullptr;
+static fs::path* pathFileout = nullptr;
+static uintmax_t nFileoutSize = 0;
 static std::mutex* mutexDebugLog = nullptr;
+static LogBuffer* logBuffer = nullptr;
+static std::thread* threadLogWriter = nullptr;
 /** Flag to indicate, whether the Omni Core log file should be reopened. */
 extern std::atomic<bool> fReopenOmniCoreLog;
 /**
@@ -108,23 +145,37 @@ static fs::path GetLogPath()
 }
 
 /**
- * Opens debug log file.
+ * Opens the debug log file and determines its size.
  */
-static void DebugLogInit()
+static void DebugLogOpen()
 {
-    assert(fileout == nullptr);
-    assert(mutexDebugLog == nullptr);
-
-    fs::path pathDebug = GetLogPath();
-    fileout = fopen(pathDebug.string().c_str(), "a");
+    fileout = fopen(pathFileout->string().c_str(), "a");
+    nFileoutSize = 0;
 
     if (fileout) {
-        setbuf(fileout, nullptr); // Unbuffered
+        boost::system::error_code ec;
+        uintmax_t nSize = fs::file_size(*pathFileout, ec);
+        if (!ec) nFileoutSize = nSize;
     } else {
-        PrintToConsole("Failed to open debug log file: %s\n", pathDebug.string());
+        PrintToConsole("Failed to open debug log file: %s\n", pathFileout->string());
     }
+}
 
-    mutexDebugLog = new std::mutex();
+/**
+ * Moves the debug log file to "omnicore.log.1", replacing an older one, and
+ * starts a new log file.
+ */
+static void DebugLogRotate()
+{
+    if (fileout) {
+        fclose(fileout);
+        fileout = nullptr;
+    }
+
+    fs::path pathRotated = fs::path(pathFileout->string() + ".1");
+    RenameOver(*pathFileout, pathRotated);
+
+    DebugLogOpen();
 }
 
 /**
@@ -136,16 +187,133 @@ static std::string GetTimestamp()
 }
 
 /**
- * Prints to log file.
+ * Writes messages to the log file, and rotates the log file, if it's getting
+ * too big.
  *
  * The configuration options "-logtimestamps" can be used to indicate, whether
- * the message to log should be prepended with a timestamp.
+ * the messages should be prepended with a timestamp.
+ */
+static void WriteLogRecords(const std::vector<LogRecord>& vRecords, uint64_t nDropped)
+{
+    static bool fStartedNewLine = true;
+    std::lock_guard<std::mutex> lock(*mutexDebugLog);
+
+    // Reopen the log file, if requested
+    if (fReopenOmniCoreLog) {
+        fReopenOmniCoreLog = false;
+        if (fileout) fclose(fileout);
+        DebugLogOpen();
+    }
+
+    if (fileout == nullptr) {
+        return;
+    }
+
+    for (const LogRecord& record : vRecords) {
+        // Printing log timestamps can be useful for profiling
+        if (LogInstance().m_log_timestamps && fStartedNewLine) {
+            nFileoutSize += fprintf(fileout, "%s ", FormatISO8601DateTime(record.nTime).c_str());
+        }
+        if (!record.str.empty() && record.str[record.str.size()-1] == '\n') {
+            fStartedNewLine = true;
+        } else {
+            fStartedNewLine = false;
+        }
+        nFileoutSize += fwrite(record.str.data(), 1, record.str.size(), fileout);
+    }
+    if (nDropped > 0) {
+        std::string strDropped = strprintf("%s%d log messages were dropped, because the log buffer was full\n",
+                fStartedNewLine ? "" : "\n", nDropped);
+        nFileoutSize += fwrite(strDropped.data(), 1, strDropped.size(), fileout);
+        fStartedNewLine = true;
+    }
+    fflush(fileout);
+
+    if (nFileoutSize > LOG_ROTATESIZE) {
+        DebugLogRotate();
+    }
+}
+
+/**
+ * Writes buffered messages in batches, until the log writer is stopped.
+ */
+static void ThreadLogWriter()
+{
+    std::vector<LogRecord> vBatch;
+
+    while (true) {
+        uint64_t nDropped = 0;
+        bool fStop = false;
+        {
+            std::unique_lock<std::mutex> lock(logBuffer->mutex);
+            logBuffer->cond.wait(lock, [] {
+                return !logBuffer->vRecords.empty() || logBuffer->nDropped > 0 || logBuffer->fStopRequested;
+            });
+            vBatch.swap(logBuffer->vRecords);
+            logBuffer->nBytes = 0;
+            std::swap(nDropped, logBuffer->nDropped);
+            fStop = logBuffer->fStopRequested;
+        }
+
+        WriteLogRecords(vBatch, nDropped);
+        vBatch.clear();
+
+        if (fStop) break;
+    }
+}
+
+/**
+ * Opens debug log file, rotates it, if it's too big, and starts the log
+ * writer thread.
+ */
+static void DebugLogInit()
+{
+    assert(fileout == nullptr);
+    assert(mutexDebugLog == nullptr);
+
+    pathFileout = new fs::path(GetLogPath());
+    DebugLogOpen();
+
+    if (nFileoutSize > LOG_ROTATESIZE) {
+        DebugLogRotate();
+    }
+
+    mutexDebugLog = new std::mutex();
+    logBuffer = new LogBuffer();
+    threadLogWriter = new std::thread(&TraceThread<void (*)()>, "omnilog", &ThreadLogWriter);
+}
+
+/**
+ * Writes all buffered messages and stops the log writer thread.
+ *
+ * Messages logged afterwards are written by the logging thread itself.
+ */
+void StopDebugLog()
+{
+    if (threadLogWriter == nullptr) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(logBuffer->mutex);
+        if (logBuffer->fStopRequested) return;
+        logBuffer->fStopRequested = true;
+    }
+    logBuffer->cond.notify_one();
+    threadLogWriter->join();
+}
+
+/**
+ * Prints to log file.
+ *
+ * The message is handed over to the log writer thread, which writes it to the
+ * log file. If too many messages are waiting to be written, the message is
+ * dropped, and the number of dropped messages is logged instead.
  *
  * If "-printtoconsole" is enabled, then the message is written to the standard
  * output, usually the console, instead of a log file.
  *
  * @param str[in]  The message to log
- * @return The total number of characters written
+ * @return The total number of characters written or buffered
  */
 int LogFilePrint(const std::string& str)
 {
@@ -155,33 +323,29 @@ int LogFilePrint(const std::string& str)
         ret = ConsolePrint(str);
     }
     else if (LogInstance().m_print_to_file) {
-        static bool fStartedNewLine = true;
         std::call_once(debugLogInitFlag, &DebugLogInit);
 
-        if (fileout == nullptr) {
-            return ret;
-        }
-        std::lock_guard<std::mutex> lock(*mutexDebugLog);
-
-        // Reopen the log file, if requested
-        if (fReopenOmniCoreLog) {
-            fReopenOmniCoreLog = false;
-            fs::path pathDebug = GetLogPath();
-            if (freopen(pathDebug.string().c_str(), "a", fileout) != nullptr) {
-                setbuf(fileout, nullptr); // Unbuffered
+        LogRecord record{GetTime(), str};
+        {
+            std::unique_lock<std::mutex> lock(logBuffer->mutex);
+            if (!logBuffer->fStopRequested) {
+                if (logBuffer->nBytes + str.size() > LOG_BUFFERSIZE) {
+                    ++logBuffer->nDropped;
+                    return ret;
+                }
+                const bool fWasEmpty = logBuffer->vRecords.empty();
+                logBuffer->vRecords.push_back(std::move(record));
+                logBuffer->nBytes += str.size();
+                lock.unlock();
+
+                if (fWasEmpty) logBuffer->cond.notify_one();
+                return str.size();
             }
         }
 
-        // Printing log timestamps can be useful for profiling
-        if (LogInstance().m_log_timestamps && fStartedNewLine) {
-            ret += fprintf(fileout, "%s ", GetTimestamp().c_str());
-        }
-        if (!str.empty() && str[str.size()-1] == '\n') {
-            fStartedNewLine = true;
-        } else {
-            fStartedNewLine = false;
-        }
-        ret += fwrite(str.data(), 1, str.size(), fileout);
+        // The log writer was stopped during shutdown
+        WriteLogRecords(std::vector<LogRecord>(1, record), 0);
+        ret = str.size();
     }
 
     return ret;
@@ -307,35 +471,3 @@ void InitDebugLogLevels()
         }
     }
 }
-
-/**
- * Scrolls debug log, if it's getting too big.
- */
-void ShrinkDebugLog()
-{
-    fs::path pathLog = GetLogPath();
-    FILE* file = fopen(pathLog.string().c_str(), "r");
-
-    if (file && fs::file_size(pathLog) > LOG_SHRINKSIZE) {
-        // Restart the file with some of the end
-        char* pch = new char[LOG_BUFFERSIZE];
-        if (nullptr != pch) {
-            fseek(file, -LOG_BUFFERSIZE, SEEK_END);
-            int nBytes = fread(pch, 1, LOG_BUFFERSIZE, file);
-            fclose(file);
-            file = nullptr;
-
-            file = fopen(pathLog.string().c_str(), "w");
-            if (file) {
-                fwrite(pch, 1, nBytes, file);
-                fclose(file);
-                file = nullptr;
-            }
-            delete[] pch;
-        }
-    } else if (nullptr != file) {
-        fclose(file);
-        file = nullptr;
-    }
-}
-
@@ -15,8 +15,8 @@ int ConsolePrint(const std::string& str);
 /** Determine whether to override compiled debug levels. */
 void InitDebugLogLevels();
 
-/** Scrolls log file, if it's getting too big. */
-void ShrinkDebugLog();
+/** Writes all buffered messages and stops the log writer thread. */
+void StopDebugLog();
 
 // Debug flags
 extern bool msc_debug_parser_data;
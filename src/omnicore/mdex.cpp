@@ -23,6 +23,7 @@
 #include <assert.h>
 #include <stdint.h>
 
+#include <algorithm>
 #include <fstream>
 #include <limits>
 #include <map>
@@ -40,24 +41,84 @@ using namespace mastercore;
 //! Global map for price and order data
 md_PropertiesMap mastercore::metadex;
 
-md_PricesMap* mastercore::get_Prices(uint32_t prop)
+static int64_t GreatestCommonDivisor(int64_t a, int64_t b)
 {
-    md_PropertiesMap::iterator it = metadex.find(prop);
+    while (b != 0) {
+        int64_t r = a % b;
+        a = b;
+        b = r;
+    }
+    return a;
+}
+
+CMPMetaDExPrice::CMPMetaDExPrice(int64_t num, int64_t denom)
+{
+    assert(0 < num && 0 < denom);
+
+    int64_t gcd = GreatestCommonDivisor(num, denom);
+    numerator = num / gcd;
+    denominator = denom / gcd;
+}
+
+bool CMPMetaDExPrice::operator<(const CMPMetaDExPrice& rhs) const
+{
+#ifdef __SIZEOF_INT128__
+    // both fractions are positive, so the products of the cross-multiplication always fit
+    return (static_cast<unsigned __int128>(numerator) * static_cast<unsigned __int128>(rhs.denominator)) <
+           (static_cast<unsigned __int128>(rhs.numerator) * static_cast<unsigned __int128>(denominator));
+#else
+    return toRational() < rhs.toRational();
+#endif
+}
+
+bool CMPMetaDExPrice::operator==(const CMPMetaDExPrice& rhs) const
+{
+    // both fractions are reduced, so equal prices have equal terms
+    return numerator == rhs.numerator && denominator == rhs.denominator;
+}
+
+static bool ComparePriceLevel(const md_PricesMap::value_type& level, const CMPMetaDExPrice& price)
+{
+    return level.first < price;
+}
+
+md_PricesMap* mastercore::get_Prices(uint32_t prop, uint32_t desprop)
+{
+    md_PropertiesMap::iterator it = metadex.find(md_PropertyPair(prop, desprop));
 
     if (it != metadex.end()) return &(it->second);
 
     return static_cast<md_PricesMap*>(nullptr);
 }
 
-md_Set* mastercore::get_Indexes(md_PricesMap* p, rational_t price)
+md_Set* mastercore::get_Indexes(md_PricesMap* p, const CMPMetaDExPrice& price)
 {
-    md_PricesMap::iterator it = p->find(price);
+    md_PricesMap::iterator it = std::lower_bound(p->begin(), p->end(), price, ComparePriceLevel);
 
-    if (it != p->end()) return &(it->second);
+    if (it != p->end() && it->first == price) return &(it->second);
 
     return static_cast<md_Set*>(nullptr);
 }
 
+// Removes price levels without offers, and the order book of the pair, if it has no price levels left
+static void PruneOrderBook(const md_PropertyPair& pair)
+{
+    md_PropertiesMap::iterator it = metadex.find(pair);
+    if (it == metadex.end()) return;
+
+    md_PricesMap& prices = it->second;
+    md_PricesMap::iterator levelIt = prices.begin();
+    while (levelIt != prices.end()) {
+        if (levelIt->second.empty()) {
+            levelIt = prices.erase(levelIt);
+        } else {
+            ++levelIt;
+        }
+    }
+
+    if (prices.empty()) metadex.erase(it);
+}
+
 enum MatchReturnType
 {
     NOTHING = 0,
@@ -140,7 +201,9 @@ static MatchReturnType x_Trade(CMPMetaDEx* const pnew)
     if (msc_debug_metadex1) PrintToLog("%s(%s: prop=%d, desprop=%d, desprice= %s);newo: %s\n",
         __FUNCTION__, pnew->getAddr(), propertyForSale, propertyDesired, xToString(pnew->inversePrice()), pnew->ToString());
 
-    md_PricesMap* const ppriceMap = get_Prices(propertyDesired);
+    // only offers selling the desired property for the property offered are considered
+    const md_PropertyPair marketPair(propertyDesired, propertyForSale);
+    md_PricesMap* const ppriceMap = get_Prices(propertyDesired, propertyForSale);
 
     // nothing for the desired property exists in the market, sorry!
     if (!ppriceMap) {
@@ -148,43 +211,43 @@ static MatchReturnType x_Trade(CMPMetaDEx* const pnew)
         return NewReturn;
     }
 
-    // within the desired property map (given one property) iterate over the items looking at prices
-    for (md_PricesMap::iterator priceIt = ppriceMap->begin(); priceIt != ppriceMap->end(); ++priceIt) { // check all prices
-        const rational_t sellersPrice = priceIt->first;
+    // the buyer's inverse price, which is the highest unit price the buyer accepts
+    const CMPMetaDExPrice buyersPrice(pnew->getAmountForSale(), pnew->getAmountDesired());
+
+    // within the order book of the pair iterate over the price levels, starting with the lowest price
+    md_PricesMap::iterator priceIt = ppriceMap->begin();
+    while (priceIt != ppriceMap->end()) { // check all prices
+        const CMPMetaDExPrice sellersPrice = priceIt->first;
 
         if (msc_debug_metadex2) PrintToLog("comparing prices: desprice %s needs to be GREATER THAN OR EQUAL TO %s\n",
-            xToString(pnew->inversePrice()), xToString(sellersPrice));
+            xToString(pnew->inversePrice()), xToString(sellersPrice.toRational()));
 
         // Is the desired price check satisfied? The buyer's inverse price must be larger than that of the seller.
-        if (pnew->inversePrice() < sellersPrice) {
-            continue;
+        // The price levels are sorted, so none of the following levels satisfies it either.
+        if (buyersPrice < sellersPrice) {
+            break;
         }
 
         md_Set* const pofferSet = &(priceIt->second);
 
-        // at good (single) price level and property iterate over offers looking at all parameters to find the match
+        // at good (single) price level iterate over offers looking at all parameters to find the match
         md_Set::iterator offerIt = pofferSet->begin();
-        while (offerIt != pofferSet->end()) { // specific price, check all properties
+        while (offerIt != pofferSet->end()) { // specific price, check all offers
             const CMPMetaDEx* const pold = &(*offerIt);
-            assert(pold->unitPrice() == sellersPrice);
+            assert(pold->priceLevel() == sellersPrice);
+            assert(pold->getDesProperty() == propertyForSale);
 
             if (msc_debug_metadex1) PrintToLog("Looking at existing: %s (its prop= %d, its des prop= %d) = %s\n",
-                xToString(sellersPrice), pold->getProperty(), pold->getDesProperty(), pold->ToString());
+                xToString(sellersPrice.toRational()), pold->getProperty(), pold->getDesProperty(), pold->ToString());
 
-            // does the desired property match?
-            if (pold->getDesProperty() != propertyForSale) {
-                ++offerIt;
-                continue;
-            }
-
-            if (msc_debug_metadex1) PrintToLog("MATCH FOUND, Trade: %s = %s\n", xToString(sellersPrice), pold->ToString());
+            if (msc_debug_metadex1) PrintToLog("MATCH FOUND, Trade: %s = %s\n", xToString(sellersPrice.toRational()), pold->ToString());
 
             // match found, execute trade now!
             const int64_t seller_amountForSale = pold->getAmountRemaining();
             const int64_t buyer_amountOffered = pnew->getAmountRemaining();
 
             if (msc_debug_metadex1) PrintToLog("$$ trading using price: %s; seller: forsale=%d, desired=%d, remaining=%d, buyer amount offered=%d\n",
-                xToString(sellersPrice), pold->getAmountForSale(), pold->getAmountDesired(), pold->getAmountRemaining(), pnew->getAmountRemaining());
+                xToString(sellersPrice.toRational()), pold->getAmountForSale(), pold->getAmountDesired(), pold->getAmountRemaining(), pnew->getAmountRemaining());
             if (msc_debug_metadex1) PrintToLog("$$ old: %s\n", pold->ToString());
             if (msc_debug_metadex1) PrintToLog("$$ new: %s\n", pnew->ToString());
 
@@ -309,7 +372,7 @@ static MatchReturnType x_Trade(CMPMetaDEx* const pnew)
 
             // record the trade in MPTradeList
             pDbTradeList->recordMatchedTrade(pold->getHash(), pnew->getHash(), // < might just pass pold, pnew
-                pold->getAddr(), pnew->getAddr(), pold->getDesProperty(), pnew->getDesProperty(), seller_amountGot, buyer_amountGotAfterFee, pnew->getBlock(), tradingFee);
+                pold->getAddr(), pnew->getAddr(), pold->getDesProperty(), pnew->getDesProperty(), seller_amountGot, buyer_amountGotAfterFee, pnew->getBlock(), pnew->getIdx(), tradingFee);
 
             if (msc_debug_metadex1) PrintToLog("++ erased old: %s\n", offerIt->ToString());
             // erase the old seller element
@@ -325,11 +388,20 @@ static MatchReturnType x_Trade(CMPMetaDEx* const pnew)
                 assert(buyer_amountLeft == 0);
                 break;
             }
-        } // specific price, check all properties
+        } // specific price, check all offers
+
+        // remove the price level, once all of its offers were filled
+        if (pofferSet->empty()) {
+            priceIt = ppriceMap->erase(priceIt);
+        } else {
+            ++priceIt;
+        }
 
         if (bBuyerSatisfied) break;
     } // check all prices
 
+    if (ppriceMap->empty()) metadex.erase(marketPair);
+
     PrintToLog("%s()=%d:%s\n", __FUNCTION__, NewReturn, getTradeReturnType(NewReturn));
 
     return NewReturn;
@@ -454,37 +526,19 @@ bool MetaDEx_compare::operator()(const CMPMetaDEx &lhs, const CMPMetaDEx &rhs) c
 
 bool mastercore::MetaDEx_INSERT(const CMPMetaDEx& objMetaDEx)
 {
-    // Create an empty price map (to use in case price map for this property does not already exist)
-    md_PricesMap temp_prices;
-    // Attempt to obtain the price map for the property
-    md_PricesMap *p_prices = get_Prices(objMetaDEx.getProperty());
-
-    // Create an empty set of metadex objects (to use in case no set currently exists at this price)
-    md_Set temp_indexes;
-    md_Set *p_indexes = nullptr;
-
-    // Prepare for return code
-    std::pair <md_Set::iterator, bool> ret;
+    const CMPMetaDExPrice price = objMetaDEx.priceLevel();
 
-    // Attempt to obtain a set of metadex objects for this price from the price map
-    if (p_prices) p_indexes = get_Indexes(p_prices, objMetaDEx.unitPrice());
-    // See if the set was populated, if not no set exists at this price level, use the empty set that we created earlier
-    if (!p_indexes) p_indexes = &temp_indexes;
+    // Obtain the order book for the pair, which is created, if it does not already exist
+    md_PricesMap& prices = metadex[md_PropertyPair(objMetaDEx.getProperty(), objMetaDEx.getDesProperty())];
 
-    // Attempt to insert the metadex object into the set
-    ret = p_indexes->insert(objMetaDEx);
-    if (false == ret.second) return false;
-
-    // If a prices map did not exist for this property, set p_prices to the temp empty price map
-    if (!p_prices) p_prices = &temp_prices;
-
-    // Update the prices map with the new set at this price
-    (*p_prices)[objMetaDEx.unitPrice()] = *p_indexes;
-
-    // Set the metadex map for the property to the updated (or new if it didn't exist) price map
-    metadex[objMetaDEx.getProperty()] = *p_prices;
+    // Locate the set of metadex objects for this price, and create an empty one, if no set exists at this price level
+    md_PricesMap::iterator it = std::lower_bound(prices.begin(), prices.end(), price, ComparePriceLevel);
+    if (it == prices.end() || it->first != price) {
+        it = prices.insert(it, std::make_pair(price, md_Set()));
+    }
 
-    return true;
+    // Attempt to insert the metadex object into the set, which fails, if it already exists
+    return it->second.insert(objMetaDEx).second;
 }
 
 // pretty much directly linked to the ADD TX21 command off the wire
@@ -527,7 +581,7 @@ int mastercore::MetaDEx_CANCEL_AT_PRICE(const uint256& txid, unsigned int block,
 {
     int rc = METADEX_ERROR -20;
     CMPMetaDEx mdex(sender_addr, 0, prop, amount, property_desired, amount_desired, uint256(), 0, CMPTransaction::CANCEL_AT_PRICE);
-    md_PricesMap* prices = get_Prices(prop);
+    md_PricesMap* prices = get_Prices(prop, property_desired);
     const CMPMetaDEx* p_mdex = nullptr;
 
     if (msc_debug_metadex1) PrintToLog("%s():%s\n", __FUNCTION__, mdex.ToString());
@@ -539,20 +593,17 @@ int mastercore::MetaDEx_CANCEL_AT_PRICE(const uint256& txid, unsigned int block,
         return rc -1;
     }
 
-    // within the desired property map (given one property) iterate over the items
-    for (md_PricesMap::iterator my_it = prices->begin(); my_it != prices->end(); ++my_it) {
-        rational_t sellers_price = my_it->first;
-
-        if (mdex.unitPrice() != sellers_price) continue;
-
-        md_Set* indexes = &(my_it->second);
+    // within the order book of the pair look up the price level
+    md_Set* indexes = nullptr;
+    if (0 < amount && 0 < amount_desired) indexes = get_Indexes(prices, mdex.priceLevel());
 
+    if (indexes) {
         for (md_Set::iterator iitt = indexes->begin(); iitt != indexes->end();) {
             p_mdex = &(*iitt);
 
             if (msc_debug_metadex3) PrintToLog("%s(): %s\n", __FUNCTION__, p_mdex->ToString());
 
-            if ((p_mdex->getDesProperty() != property_desired) || (p_mdex->getAddr() != sender_addr)) {
+            if (p_mdex->getAddr() != sender_addr) {
                 ++iitt;
                 continue;
             }
@@ -572,6 +623,8 @@ int mastercore::MetaDEx_CANCEL_AT_PRICE(const uint256& txid, unsigned int block,
         }
     }
 
+    PruneOrderBook(md_PropertyPair(prop, property_desired));
+
     if (msc_debug_metadex2) MetaDEx_debug_print();
 
     return rc;
@@ -580,7 +633,7 @@ int mastercore::MetaDEx_CANCEL_AT_PRICE(const uint256& txid, unsigned int block,
 int mastercore::MetaDEx_CANCEL_ALL_FOR_PAIR(const uint256& txid, unsigned int block, const std::string& sender_addr, uint32_t prop, uint32_t property_desired)
 {
     int rc = METADEX_ERROR -30;
-    md_PricesMap* prices = get_Prices(prop);
+    md_PricesMap* prices = get_Prices(prop, property_desired);
     const CMPMetaDEx* p_mdex = nullptr;
 
     PrintToLog("%s(%d,%d)\n", __FUNCTION__, prop, property_desired);
@@ -592,7 +645,7 @@ int mastercore::MetaDEx_CANCEL_ALL_FOR_PAIR(const uint256& txid, unsigned int bl
         return rc -1;
     }
 
-    // within the desired property map (given one property) iterate over the items
+    // within the order book of the pair iterate over the items
     for (md_PricesMap::iterator my_it = prices->begin(); my_it != prices->end(); ++my_it) {
         md_Set* indexes = &(my_it->second);
 
@@ -601,7 +654,7 @@ int mastercore::MetaDEx_CANCEL_ALL_FOR_PAIR(const uint256& txid, unsigned int bl
 
             if (msc_debug_metadex3) PrintToLog("%s(): %s\n", __FUNCTION__, p_mdex->ToString());
 
-            if ((p_mdex->getDesProperty() != property_desired) || (p_mdex->getAddr() != sender_addr)) {
+            if (p_mdex->getAddr() != sender_addr) {
                 ++iitt;
                 continue;
             }
@@ -621,11 +674,21 @@ int mastercore::MetaDEx_CANCEL_ALL_FOR_PAIR(const uint256& txid, unsigned int bl
         }
     }
 
+    PruneOrderBook(md_PropertyPair(prop, property_desired));
+
     if (msc_debug_metadex3) MetaDEx_debug_print();
 
     return rc;
 }
 
+// Orders offers by price, and offers at the same price by block and position in the block
+static bool CompareOfferPriority(const std::pair<CMPMetaDExPrice, CMPMetaDEx>& lhs, const std::pair<CMPMetaDExPrice, CMPMetaDEx>& rhs)
+{
+    if (lhs.first != rhs.first) return lhs.first < rhs.first;
+
+    return MetaDEx_compare()(lhs.second, rhs.second);
+}
+
 /**
  * Scans the orderbook and remove everything for an address.
  */
@@ -639,44 +702,63 @@ int mastercore::MetaDEx_CANCEL_EVERYTHING(const uint256& txid, unsigned int bloc
 
     PrintToLog("<<<<<<\n");
 
-    for (md_PropertiesMap::iterator my_it = metadex.begin(); my_it != metadex.end(); ++my_it) {
-        unsigned int prop = my_it->first;
+    md_PropertiesMap::iterator my_it = metadex.begin();
+    while (my_it != metadex.end()) {
+        const uint32_t prop = my_it->first.first;
+        const md_PropertiesMap::iterator propEnd = metadex.upper_bound(md_PropertyPair(prop, std::numeric_limits<uint32_t>::max()));
 
         // skip property, if it is not in the expected ecosystem
-        if (isMainEcosystemProperty(ecosystem) && !isMainEcosystemProperty(prop)) continue;
-        if (isTestEcosystemProperty(ecosystem) && !isTestEcosystemProperty(prop)) continue;
+        if ((isMainEcosystemProperty(ecosystem) && !isMainEcosystemProperty(prop)) ||
+                (isTestEcosystemProperty(ecosystem) && !isTestEcosystemProperty(prop))) {
+            my_it = propEnd;
+            continue;
+        }
 
         PrintToLog(" ## property: %u\n", prop);
-        md_PricesMap& prices = my_it->second;
-
-        for (md_PricesMap::iterator it = prices.begin(); it != prices.end(); ++it) {
-            rational_t price = it->first;
-            md_Set& indexes = it->second;
 
-            PrintToLog("  # Price Level: %s\n", xToString(price));
+        // collect the offers of the address across all order books of the property, and
+        // cancel them ordered by price first, and then by block and position in the block
+        std::vector<std::pair<CMPMetaDExPrice, CMPMetaDEx> > vecOffers;
+        std::vector<md_PropertyPair> vecPairs;
+        for (md_PropertiesMap::iterator pairIt = my_it; pairIt != propEnd; ++pairIt) {
+            vecPairs.push_back(pairIt->first);
+            const md_PricesMap& prices = pairIt->second;
+            for (md_PricesMap::const_iterator it = prices.begin(); it != prices.end(); ++it) {
+                const CMPMetaDExPrice& price = it->first;
+                const md_Set& indexes = it->second;
+                for (md_Set::const_iterator it = indexes.begin(); it != indexes.end(); ++it) {
+                    PrintToLog("%s= %s\n", xToString(price.toRational()), it->ToString());
+                    if (it->getAddr() != sender_addr) continue;
+                    vecOffers.push_back(std::make_pair(price, *it));
+                }
+            }
+        }
+        std::sort(vecOffers.begin(), vecOffers.end(), CompareOfferPriority);
 
-            for (md_Set::iterator it = indexes.begin(); it != indexes.end();) {
-                PrintToLog("%s= %s\n", xToString(price), it->ToString());
+        for (std::vector<std::pair<CMPMetaDExPrice, CMPMetaDEx> >::const_iterator it = vecOffers.begin(); it != vecOffers.end(); ++it) {
+            const CMPMetaDEx& obj = it->second;
 
-                if (it->getAddr() != sender_addr) {
-                    ++it;
-                    continue;
-                }
+            rc = 0;
+            PrintToLog("%s(): REMOVING %s\n", __FUNCTION__, obj.ToString());
 
-                rc = 0;
-                PrintToLog("%s(): REMOVING %s\n", __FUNCTION__, it->ToString());
+            // move from reserve to balance
+            assert(update_tally_map(obj.getAddr(), obj.getProperty(), -obj.getAmountRemaining(), METADEX_RESERVE));
+            assert(update_tally_map(obj.getAddr(), obj.getProperty(), obj.getAmountRemaining(), BALANCE));
 
-                // move from reserve to balance
-                assert(update_tally_map(it->getAddr(), it->getProperty(), -it->getAmountRemaining(), METADEX_RESERVE));
-                assert(update_tally_map(it->getAddr(), it->getProperty(), it->getAmountRemaining(), BALANCE));
+            // record the cancellation
+            bool bValid = true;
+            pDbTransactionList->recordMetaDExCancelTX(txid, obj.getHash(), bValid, block, obj.getProperty(), obj.getAmountRemaining());
 
-                // record the cancellation
-                bool bValid = true;
-                pDbTransactionList->recordMetaDExCancelTX(txid, it->getHash(), bValid, block, it->getProperty(), it->getAmountRemaining());
+            md_Set* indexes = get_Indexes(get_Prices(obj.getProperty(), obj.getDesProperty()), it->first);
+            assert(indexes);
+            indexes->erase(obj);
+        }
 
-                indexes.erase(it++);
-            }
+        for (std::vector<md_PropertyPair>::const_iterator it = vecPairs.begin(); it != vecPairs.end(); ++it) {
+            PruneOrderBook(*it);
         }
+
+        my_it = metadex.upper_bound(md_PropertyPair(prop, std::numeric_limits<uint32_t>::max()));
     }
     PrintToLog(">>>>>>\n");
 
@@ -692,20 +774,25 @@ int mastercore::MetaDEx_SHUTDOWN_ALLPAIR()
 {
     int rc = 0;
     PrintToLog("%s()\n", __FUNCTION__);
-    for (md_PropertiesMap::iterator my_it = metadex.begin(); my_it != metadex.end(); ++my_it) {
+    md_PropertiesMap::iterator my_it = metadex.begin();
+    while (my_it != metadex.end()) {
+        const md_PropertyPair& pair = my_it->first;
+        if (pair.first <= OMNI_PROPERTY_TMSC || pair.second <= OMNI_PROPERTY_TMSC) { // OMN/TOMN side to the trade
+            ++my_it;
+            continue;
+        }
         md_PricesMap& prices = my_it->second;
         for (md_PricesMap::iterator it = prices.begin(); it != prices.end(); ++it) {
             md_Set& indexes = it->second;
             for (md_Set::iterator it = indexes.begin(); it != indexes.end();) {
-                if (it->getDesProperty() > OMNI_PROPERTY_TMSC && it->getProperty() > OMNI_PROPERTY_TMSC) { // no OMN/TOMN side to the trade
-                    PrintToLog("%s(): REMOVING %s\n", __FUNCTION__, it->ToString());
-                    // move from reserve to balance
-                    assert(update_tally_map(it->getAddr(), it->getProperty(), -it->getAmountRemaining(), METADEX_RESERVE));
-                    assert(update_tally_map(it->getAddr(), it->getProperty(), it->getAmountRemaining(), BALANCE));
-                    indexes.erase(it++);
-                }
+                PrintToLog("%s(): REMOVING %s\n", __FUNCTION__, it->ToString());
+                // move from reserve to balance
+                assert(update_tally_map(it->getAddr(), it->getProperty(), -it->getAmountRemaining(), METADEX_RESERVE));
+                assert(update_tally_map(it->getAddr(), it->getProperty(), it->getAmountRemaining(), BALANCE));
+                indexes.erase(it++);
             }
         }
+        my_it = metadex.erase(my_it);
     }
     return rc;
 }
@@ -730,6 +817,7 @@ int mastercore::MetaDEx_SHUTDOWN()
             }
         }
     }
+    metadex.clear();
     return rc;
 }
 
@@ -738,7 +826,7 @@ int mastercore::MetaDEx_SHUTDOWN()
 bool mastercore::MetaDEx_isOpen(const uint256& txid, uint32_t propertyIdForSale)
 {
     for (md_PropertiesMap::iterator my_it = metadex.begin(); my_it != metadex.end(); ++my_it) {
-        if (propertyIdForSale != 0 && propertyIdForSale != my_it->first) continue;
+        if (propertyIdForSale != 0 && propertyIdForSale != my_it->first.first) continue;
         md_PricesMap & prices = my_it->second;
         for (md_PricesMap::iterator it = prices.begin(); it != prices.end(); ++it) {
             md_Set & indexes = (it->second);
@@ -807,13 +895,14 @@ void mastercore::MetaDEx_debug_print(bool bShowPriceLevel, bool bDisplay)
 {
     PrintToLog("<<<\n");
     for (md_PropertiesMap::iterator my_it = metadex.begin(); my_it != metadex.end(); ++my_it) {
-        uint32_t prop = my_it->first;
+        uint32_t prop = my_it->first.first;
+        uint32_t desprop = my_it->first.second;
 
-        PrintToLog(" ## property: %u\n", prop);
+        PrintToLog(" ## property: %u, desired property: %u\n", prop, desprop);
         md_PricesMap& prices = my_it->second;
 
         for (md_PricesMap::iterator it = prices.begin(); it != prices.end(); ++it) {
-            rational_t price = it->first;
+            const rational_t price = it->first.toRational();
             md_Set& indexes = it->second;
 
             if (bShowPriceLevel) PrintToLog("  # Price Level: %s\n", xToString(price));
@@ -16,6 +16,8 @@
 #include <map>
 #include <set>
 #include <string>
+#include <utility>
+#include <vector>
 
 class CHash256;
 
@@ -32,6 +34,34 @@ typedef boost::rational<boost::multiprecision::checked_int128_t> rational_t;
 /** Converts price to string. */
 std::string xToString(const rational_t& value);
 
+/** A price level of the distributed exchange.
+ *
+ * The price is stored as reduced fraction of two positive 64 bit integers, so
+ * that prices can be compared exactly with a single 128 bit multiplication,
+ * instead of the checked arithmetic of rational_t.
+ */
+class CMPMetaDExPrice
+{
+private:
+    int64_t numerator;
+    int64_t denominator;
+
+public:
+    /** Creates the price numerator / denominator, which must both be positive. */
+    CMPMetaDExPrice(int64_t num, int64_t denom);
+
+    int64_t getNumerator() const { return numerator; }
+    int64_t getDenominator() const { return denominator; }
+
+    /** Returns the price as rational number. */
+    rational_t toRational() const { return rational_t(numerator, denominator); }
+
+    bool operator<(const CMPMetaDExPrice& rhs) const;
+    bool operator==(const CMPMetaDExPrice& rhs) const;
+    bool operator!=(const CMPMetaDExPrice& rhs) const { return !operator==(rhs); }
+    bool operator>(const CMPMetaDExPrice& rhs) const { return rhs.operator<(*this); }
+};
+
 /** A trade on the distributed exchange.
  */
 class CMPMetaDEx
@@ -94,6 +124,9 @@ public:
     rational_t unitPrice() const;
     rational_t inversePrice() const;
 
+    /** Returns the unit price as price level, which requires non-zero amounts. */
+    CMPMetaDExPrice priceLevel() const { return CMPMetaDExPrice(amount_desired, amount_forsale); }
+
     /** Used for display of unit prices to 8 decimal places at UI layer. */
     std::string displayUnitPrice() const;
     /** Used for display of unit prices with 50 decimal places at RPC layer. */
@@ -111,18 +144,19 @@ struct MetaDEx_compare
 
 // ---------------
 //! Set of objects sorted by block+idx
-typedef std::set<CMPMetaDEx, MetaDEx_compare> md_Set; 
-//! Map of prices; there is a set of sorted objects for each price
-typedef std::map<rational_t, md_Set> md_PricesMap;
-//! Map of properties; there is a map of prices for each property
-typedef std::map<uint32_t, md_PricesMap> md_PropertiesMap;
+typedef std::set<CMPMetaDEx, MetaDEx_compare> md_Set;
+//! Price levels sorted by price; there is a set of sorted objects for each price
+typedef std::vector<std::pair<CMPMetaDExPrice, md_Set> > md_PricesMap;
+//! Pair of the property for sale and the property desired
+typedef std::pair<uint32_t, uint32_t> md_PropertyPair;
+//! Map of order books; there is a list of price levels for each pair of properties
+typedef std::map<md_PropertyPair, md_PricesMap> md_PropertiesMap;
 
 //! Global map for price and order data
 extern md_PropertiesMap metadex;
 
-// TODO: explore a property-pair, instead of a single property as map's key........
-md_PricesMap* get_Prices(uint32_t prop);
-md_Set* get_Indexes(md_PricesMap* p, rational_t price);
+md_PricesMap* get_Prices(uint32_t prop, uint32_t desprop);
+md_Set* get_Indexes(md_PricesMap* p, const CMPMetaDExPrice& price);
 // ---------------
 
 int MetaDEx_ADD(const std::string& sender_addr, uint32_t, int64_t, int block, uint32_t property_desired, int64_t amount_desired, const uint256& txid, unsigned int idx);
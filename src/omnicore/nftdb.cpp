@@ -10,72 +10,163 @@
 #include <omnicore/errors.h>
 #include <omnicore/log.h>
 
+#include <crypto/common.h>
+#include <util/strencodings.h>
 #include <validation.h>
 
+#include <stddef.h>
 #include <stdint.h>
 
-#include <boost/algorithm/string.hpp>
-#include <boost/lexical_cast.hpp>
+#include <limits>
+#include <map>
+#include <set>
+#include <string>
 
 typedef std::underlying_type<NonFungibleStorage>::type StorageType;
 
+//! Prefix of the keys of token ranges
+static const char RANGE_KEY_PREFIX = 'r';
+//! Prefix of the secondary keys, which index the owned token ranges by owner
+static const char OWNER_KEY_PREFIX = 'o';
+//! Size of a range key: prefix, property identifier, type, range start and end
+static const size_t RANGE_KEY_SIZE = 1 + 4 + 1 + 8 + 8;
+
+/* Returns the prefix of the range keys of a property and type
+ *
+ * Keys are encoded as "r<propertyid><type><start><end>", with all numbers in big-endian
+ * byte order, so that ranges are sorted by property, type and range start.
+ */
+static std::string GetRangeKeyPrefix(uint32_t propertyId, NonFungibleStorage type)
+{
+    unsigned char buf[6];
+    buf[0] = RANGE_KEY_PREFIX;
+    WriteBE32(buf + 1, propertyId);
+    buf[5] = static_cast<StorageType>(type);
+    return std::string(reinterpret_cast<const char*>(buf), sizeof(buf));
+}
+
+/* Appends a big-endian encoded token identifier to a key
+ */
+static void AppendTokenId(std::string& key, int64_t tokenId)
+{
+    unsigned char buf[8];
+    WriteBE64(buf, static_cast<uint64_t>(tokenId));
+    key.append(reinterpret_cast<const char*>(buf), sizeof(buf));
+}
+
+/* Returns the key of a range of tokens
+ */
+static std::string GetRangeKey(uint32_t propertyId, NonFungibleStorage type, int64_t start, int64_t end)
+{
+    std::string key = GetRangeKeyPrefix(propertyId, type);
+    AppendTokenId(key, start);
+    AppendTokenId(key, end);
+    return key;
+}
+
+/* Returns the prefix of the owner index keys of an address, optionally limited to a property
+ *
+ * Keys are encoded as "o<address>\0<propertyid><start><end>", with all numbers in big-endian
+ * byte order, so that the ranges of an owner are sorted by property and range start.
+ */
+static std::string GetOwnerKeyPrefix(const std::string& address, uint32_t propertyId = 0)
+{
+    std::string key = OWNER_KEY_PREFIX + address;
+    key.push_back('\0');
+    if (propertyId != 0) {
+        unsigned char buf[4];
+        WriteBE32(buf, propertyId);
+        key.append(reinterpret_cast<const char*>(buf), sizeof(buf));
+    }
+    return key;
+}
+
+/* Returns the owner index key of a range of tokens
+ */
+static std::string GetOwnerKey(const std::string& address, uint32_t propertyId, int64_t start, int64_t end)
+{
+    std::string key = GetOwnerKeyPrefix(address, propertyId);
+    AppendTokenId(key, start);
+    AppendTokenId(key, end);
+    return key;
+}
+
+/* Returns the first key after all keys with the given prefix
+ */
+static std::string GetPrefixEnd(const std::string& prefix)
+{
+    return prefix + std::string(RANGE_KEY_SIZE, '\xff');
+}
+
 /* Extracts the property ID from a DB key
  */
 uint32_t CMPNonFungibleTokensDB::GetPropertyIdFromKey(const std::string& key)
 {
-    std::vector<std::string> vPropertyId;
-    boost::split(vPropertyId, key, boost::is_any_of("_"), boost::token_compress_on);
-    assert(vPropertyId.size() == 3); // if size !=3 then we cannot trust the data in the DB and we must halt
-    return boost::lexical_cast<uint32_t>(vPropertyId[0]);
+    assert(key.size() == RANGE_KEY_SIZE && key[0] == RANGE_KEY_PREFIX); // otherwise we cannot trust the data in the DB and we must halt
+    return ReadBE32(reinterpret_cast<const unsigned char*>(key.data()) + 1);
 }
 
 /* Extracts the storage type from a DB key
  */
 NonFungibleStorage CMPNonFungibleTokensDB::GetTypeFromKey(const std::string& key)
 {
-    std::vector<std::string> vPropertyId;
-    boost::split(vPropertyId, key, boost::is_any_of("_"), boost::token_compress_on);
-    assert(vPropertyId.size() == 3); // if size !=3 then we cannot trust the data in the DB and we must halt
-    auto ch = boost::lexical_cast<uint32_t>(vPropertyId[1]);
-    return static_cast<NonFungibleStorage>(ch);
+    assert(key.size() == RANGE_KEY_SIZE && key[0] == RANGE_KEY_PREFIX); // otherwise we cannot trust the data in the DB and we must halt
+    return static_cast<NonFungibleStorage>(key[5]);
 }
 
 /* Extracts the range from a DB key
  */
 void CMPNonFungibleTokensDB::GetRangeFromKey(const std::string& key, int64_t *start, int64_t *end)
 {
-   std::vector<std::string> vPropertyId;
-   boost::split(vPropertyId, key, boost::is_any_of("_"), boost::token_compress_on);
-   assert(vPropertyId.size() == 3); // if size !=2 then we cannot trust the data in the DB and we must halt
-
-   std::vector<std::string> vRanges;
-   boost::split(vRanges, vPropertyId[2], boost::is_any_of("-"), boost::token_compress_on);
-   assert(vRanges.size() == 2); // if size !=2 then we cannot trust the data in the DB and we must halt
-
-   *start = boost::lexical_cast<int64_t>(vRanges[0]);
-   *end = boost::lexical_cast<int64_t>(vRanges[1]);
+    assert(key.size() >= 16); // the range is encoded at the end of range and owner keys
+    const unsigned char* ptr = reinterpret_cast<const unsigned char*>(key.data()) + key.size() - 16;
+    *start = static_cast<int64_t>(ReadBE64(ptr));
+    *end = static_cast<int64_t>(ReadBE64(ptr + 8));
 }
 
-/* Gets the range a non-fungible token is in
+/* Finds the range of a property and type, which contains the token
+ *
+ * Ranges of a property and type don't overlap, so the only candidate is the range
+ * with the highest start not above the token identifier.
  */
-std::pair<int64_t,int64_t> CMPNonFungibleTokensDB::GetRange(const uint32_t &propertyId, const int64_t &tokenId, const NonFungibleStorage type)
+bool CMPNonFungibleTokensDB::FindRange(const uint32_t &propertyId, const int64_t &tokenId, const NonFungibleStorage type, int64_t& start, int64_t& end, std::string* value)
 {
     assert(pdb);
-    leveldb::Iterator* it = NewIterator();
+    const std::string prefix = GetRangeKeyPrefix(propertyId, type);
+    std::string seekKey = prefix;
+    AppendTokenId(seekKey, tokenId);
+    AppendTokenId(seekKey, std::numeric_limits<int64_t>::max());
 
-    for (it->SeekToFirst(); it->Valid(); it->Next()) {
-        if (propertyId != GetPropertyIdFromKey(it->key().ToString()) ||
-                GetTypeFromKey(it->key().ToString()) != type) continue;
-
-        int64_t start, end;
+    bool found = false;
+    leveldb::Iterator* it = NewIterator();
+    it->Seek(seekKey);
+    if (it->Valid()) {
+        it->Prev();
+    } else {
+        it->SeekToLast();
+    }
+    if (it->Valid() && it->key().starts_with(prefix) && it->key().size() == RANGE_KEY_SIZE) {
         GetRangeFromKey(it->key().ToString(), &start, &end);
         if (tokenId >= start && tokenId <= end) {
-            delete it;
-            return std::make_pair(start, end);
+            if (value) *value = it->value().ToString();
+            found = true;
         }
     }
-
     delete it;
+    ++nRead;
+
+    return found;
+}
+
+/* Gets the range a non-fungible token is in
+ */
+std::pair<int64_t,int64_t> CMPNonFungibleTokensDB::GetRange(const uint32_t &propertyId, const int64_t &tokenId, const NonFungibleStorage type)
+{
+    int64_t start, end;
+    if (FindRange(propertyId, tokenId, type, start, end)) {
+        return std::make_pair(start, end);
+    }
+
     return std::make_pair(0,0); // token not found, return zero'd range
 }
 
@@ -83,29 +174,13 @@ std::pair<int64_t,int64_t> CMPNonFungibleTokensDB::GetRange(const uint32_t &prop
  */
 bool CMPNonFungibleTokensDB::IsRangeContiguous(const uint32_t &propertyId, const int64_t &rangeStart, const int64_t &rangeEnd)
 {
-
-    assert(pdb);
-    leveldb::Iterator* it = NewIterator();
-
-    for (it->SeekToFirst(); it->Valid(); it->Next()) {
-        if (propertyId != GetPropertyIdFromKey(it->key().ToString()) ||
-                GetTypeFromKey(it->key().ToString()) != NonFungibleStorage::RangeIndex) continue;
-
-        int64_t start, end;
-        GetRangeFromKey(it->key().ToString(), &start, &end);
-
-        if (rangeStart >= start && rangeStart <= end) {
-            delete it;
-            if (rangeEnd >= rangeStart && rangeEnd <= end) {
-                return true;
-            } else {
-                return false; // the start ID falls within this range but the end ID does not - not owned by a single address
-            }
-        }
+    int64_t start, end;
+    if (!FindRange(propertyId, rangeStart, NonFungibleStorage::RangeIndex, start, end)) {
+        return false; // range doesn't exist
     }
 
-    delete it;
-    return false; // range doesn't exist
+    // the start ID falls within this range, but the end ID may not - then it's not owned by a single address
+    return rangeEnd >= rangeStart && rangeEnd <= end;
 }
 
 /* Moves a range of tokens (returns false if not able to move)
@@ -172,6 +247,8 @@ bool CMPNonFungibleTokensDB::MoveNonFungibleTokens(const uint32_t &propertyId, c
         AddRange(propertyId, newTokenIdStart, newTokenIdEnd, to, NonFungibleStorage::RangeIndex);
     }
 
+    setTouchedProperties.insert(propertyId);
+
     return true;
 }
 
@@ -224,23 +301,41 @@ bool CMPNonFungibleTokensDB::ChangeNonFungibleTokenData(const uint32_t &property
 }
 
 /* Counts the highest token range end (which is thus the total number of tokens)
+ *
+ * The number is loaded from the database once, and then tracked, when tokens are created.
  */
 int64_t CMPNonFungibleTokensDB::GetHighestRangeEnd(const uint32_t &propertyId)
+{
+    std::map<uint32_t, int64_t>::const_iterator it = mapIssuedTokens.find(propertyId);
+    if (it != mapIssuedTokens.end()) {
+        return it->second;
+    }
+
+    int64_t tokenCount = ReadHighestRangeEnd(propertyId);
+    mapIssuedTokens.emplace(propertyId, tokenCount);
+    return tokenCount;
+}
+
+/* Reads the highest token range end of a property from the database
+ */
+int64_t CMPNonFungibleTokensDB::ReadHighestRangeEnd(const uint32_t &propertyId)
 {
     assert(pdb);
 
+    // ranges don't overlap, so the last range ends with the highest token
     int64_t tokenCount = 0;
+    const std::string prefix = GetRangeKeyPrefix(propertyId, NonFungibleStorage::RangeIndex);
     leveldb::Iterator* it = NewIterator();
-    for (it->SeekToFirst(); it->Valid(); it->Next()) {
-        if (propertyId != GetPropertyIdFromKey(it->key().ToString()) ||
-                GetTypeFromKey(it->key().ToString()) != NonFungibleStorage::RangeIndex) continue;
-
+    it->Seek(GetPrefixEnd(prefix));
+    if (it->Valid()) {
+        it->Prev();
+    } else {
+        it->SeekToLast();
+    }
+    if (it->Valid() && it->key().starts_with(prefix) && it->key().size() == RANGE_KEY_SIZE) {
         int64_t start, end;
         GetRangeFromKey(it->key().ToString(), &start, &end);
-
-        if (end > tokenCount) {
-            tokenCount = end;
-        }
+        tokenCount = end;
     }
     delete it;
     return tokenCount;
@@ -251,10 +346,19 @@ int64_t CMPNonFungibleTokensDB::GetHighestRangeEnd(const uint32_t &propertyId)
 void CMPNonFungibleTokensDB::DeleteRange(const uint32_t &propertyId, const int64_t &tokenIdStart, const int64_t &tokenIdEnd, const NonFungibleStorage type)
 {
     assert(pdb);
-    const std::string key = strprintf("%010d_%u_%020d-%020d", propertyId, static_cast<StorageType>(type), tokenIdStart, tokenIdEnd);
-    pdb->Delete(leveldb::WriteOptions(), key);
+    const std::string key = GetRangeKey(propertyId, type, tokenIdStart, tokenIdEnd);
+
+    // remove the range from the owner index
+    if (type == NonFungibleStorage::RangeIndex) {
+        std::string owner;
+        if (pdb->Get(readoptions, key, &owner).ok()) {
+            pdb->Delete(writeoptions, GetOwnerKey(owner, propertyId, tokenIdStart, tokenIdEnd));
+        }
+    }
 
-    if (msc_debug_nftdb) PrintToLog("%s():%s, line %d, file: %s\n", __FUNCTION__, key, __LINE__, __FILE__);
+    pdb->Delete(writeoptions, key);
+
+    if (msc_debug_nftdb) PrintToLog("%s():%d:%u:%d-%d, line %d, file: %s\n", __FUNCTION__, propertyId, static_cast<StorageType>(type), tokenIdStart, tokenIdEnd, __LINE__, __FILE__);
 }
 
 /* Adds a range of non-fungible tokens and/or sets data on that range
@@ -263,11 +367,16 @@ void CMPNonFungibleTokensDB::AddRange(const uint32_t &propertyId, const int64_t
 {
     assert(pdb);
 
-    const std::string key = strprintf("%010d_%u_%020d-%020d", propertyId, static_cast<StorageType>(type), tokenIdStart, tokenIdEnd);
+    const std::string key = GetRangeKey(propertyId, type, tokenIdStart, tokenIdEnd);
     leveldb::Status status = pdb->Put(writeoptions, key, info);
     ++nWritten;
 
-    if (msc_debug_nftdb) PrintToLog("%s():%s=%s:%s, line %d, file: %s\n", __FUNCTION__, key, info, status.ToString(), __LINE__, __FILE__);
+    // add the range to the owner index
+    if (type == NonFungibleStorage::RangeIndex) {
+        status = pdb->Put(writeoptions, GetOwnerKey(info, propertyId, tokenIdStart, tokenIdEnd), "");
+    }
+
+    if (msc_debug_nftdb) PrintToLog("%s():%d:%u:%d-%d=%s:%s, line %d, file: %s\n", __FUNCTION__, propertyId, static_cast<StorageType>(type), tokenIdStart, tokenIdEnd, info, status.ToString(), __LINE__, __FILE__);
 }
 
 /* Creates a range of non-fungible tokens
@@ -300,6 +409,9 @@ std::pair<int64_t,int64_t> CMPNonFungibleTokensDB::CreateNonFungibleTokens(const
 
     AddRange(propertyId, newTokenStartId, newTokenEndId, owner, NonFungibleStorage::RangeIndex);
 
+    mapIssuedTokens[propertyId] = newTokenEndId;
+    setTouchedProperties.insert(propertyId);
+
     return newRange;
 }
 
@@ -307,49 +419,19 @@ std::pair<int64_t,int64_t> CMPNonFungibleTokensDB::CreateNonFungibleTokens(const
  */
 std::string CMPNonFungibleTokensDB::GetNonFungibleTokenOwner(const uint32_t &propertyId, const int64_t &tokenId)
 {
-    assert(pdb);
-    leveldb::Iterator* it = NewIterator();
-
-    for (it->SeekToFirst(); it->Valid(); it->Next()) {
-        if (propertyId != GetPropertyIdFromKey(it->key().ToString()) ||
-                GetTypeFromKey(it->key().ToString()) != NonFungibleStorage::RangeIndex) continue;
-
-        int64_t start, end;
-        GetRangeFromKey(it->key().ToString(), &start, &end);
-
-        if (tokenId >= start && tokenId <= end) {
-            std::string retval = it->value().ToString();
-            delete it;
-            return retval;
-        }
-    }
-
-    delete it;
-    return ""; // not found
+    return GetNonFungibleTokenData(propertyId, tokenId, NonFungibleStorage::RangeIndex);
 }
 
 /* Gets the info set in a non-fungible token
  */
 std::string CMPNonFungibleTokensDB::GetNonFungibleTokenData(const uint32_t &propertyId, const int64_t &tokenId, const NonFungibleStorage type)
 {
-    assert(pdb);
-    leveldb::Iterator* it = NewIterator();
-
-    for (it->SeekToFirst(); it->Valid(); it->Next()) {
-        if (propertyId != GetPropertyIdFromKey(it->key().ToString()) ||
-                GetTypeFromKey(it->key().ToString()) != type) continue;
-
-        int64_t start, end;
-        GetRangeFromKey(it->key().ToString(), &start, &end);
-
-        if (tokenId >= start && tokenId <= end) {
-            std::string retval = it->value().ToString();
-            delete it;
-            return retval;
-        }
+    int64_t start, end;
+    std::string value;
+    if (FindRange(propertyId, tokenId, type, start, end, &value)) {
+        return value;
     }
 
-    delete it;
     return ""; // not found
 }
 
@@ -359,17 +441,17 @@ std::map<uint32_t, std::vector<std::pair<int64_t, int64_t>>> CMPNonFungibleToken
 {
     std::map<uint32_t, std::vector<std::pair<int64_t, int64_t>>> uniqueMap;
     assert(pdb);
-    leveldb::Iterator* it = NewIterator();
-    for (it->SeekToFirst(); it->Valid(); it->Next()) {
-        std::string value = it->value().ToString();
-        if (value != address) continue;
 
-        const auto id = GetPropertyIdFromKey(it->key().ToString());
-        if ((propertyId != 0 && propertyId != id) ||
-            GetTypeFromKey(it->key().ToString()) != NonFungibleStorage::RangeIndex) continue;
+    const std::string prefix = GetOwnerKeyPrefix(address, propertyId);
+    const size_t nKeySize = GetOwnerKeyPrefix(address).size() + 4 + 16;
+    leveldb::Iterator* it = NewIterator();
+    for (it->Seek(prefix); it->Valid() && it->key().starts_with(prefix); it->Next()) {
+        if (it->key().size() != nKeySize) continue;
+        const std::string key = it->key().ToString();
+        const auto id = ReadBE32(reinterpret_cast<const unsigned char*>(key.data()) + nKeySize - 20);
 
         int64_t start, end;
-        GetRangeFromKey(it->key().ToString(), &start, &end);
+        GetRangeFromKey(key, &start, &end);
 
         uniqueMap[id].emplace_back(start, end);
     }
@@ -385,11 +467,9 @@ std::vector<std::pair<std::string,std::pair<int64_t,int64_t> > > CMPNonFungibleT
 
     assert(pdb);
 
+    const std::string prefix = GetRangeKeyPrefix(propertyId, NonFungibleStorage::RangeIndex);
     leveldb::Iterator* it = NewIterator();
-    for (it->SeekToFirst(); it->Valid(); it->Next()) {
-        if (propertyId != GetPropertyIdFromKey(it->key().ToString()) ||
-                GetTypeFromKey(it->key().ToString()) != NonFungibleStorage::RangeIndex) continue;
-
+    for (it->Seek(prefix); it->Valid() && it->key().starts_with(prefix); it->Next()) {
         std::string address = it->value().ToString();
         int64_t start, end;
         GetRangeFromKey(it->key().ToString(), &start, &end);
@@ -401,16 +481,56 @@ std::vector<std::pair<std::string,std::pair<int64_t,int64_t> > > CMPNonFungibleT
     return rangeMap;
 }
 
+/* Verifies the number of issued tokens of a property against the tally
+ */
+bool CMPNonFungibleTokensDB::CheckSupply(const uint32_t &propertyId, const int64_t &issued, std::string& result)
+{
+    int64_t totalTokens = mastercore::getTotalTokens(propertyId);
+    if (totalTokens != issued) {
+        std::string abortMsg = strprintf("Failed sanity check on property %d (%d != %d)\n", propertyId, totalTokens, issued);
+        AbortNode(abortMsg);
+        return false;
+    }
+
+    result = result + strprintf("%d:%d=%d,", propertyId, totalTokens, issued);
+    return true;
+}
+
+/* Sanity checks the token counts of the properties, with tokens created or moved since the last check
+ */
 void CMPNonFungibleTokensDB::SanityCheck()
 {
     assert(pdb);
 
     std::string result = "";
 
+    for (std::set<uint32_t>::const_iterator it = setTouchedProperties.begin(); it != setTouchedProperties.end(); ++it) {
+        int64_t issued = GetHighestRangeEnd(*it);
+        int64_t highestRangeEnd = ReadHighestRangeEnd(*it);
+        if (issued != highestRangeEnd) {
+            std::string abortMsg = strprintf("Failed sanity check on property %d (issued tokens %d != highest token %d)\n", *it, issued, highestRangeEnd);
+            AbortNode(abortMsg);
+            return;
+        }
+        if (!CheckSupply(*it, issued, result)) return;
+    }
+    setTouchedProperties.clear();
+
+    if (msc_debug_nftdb) PrintToLog("UTDB sanity check OK (%s)\n", result);
+}
+
+/* Sanity checks the token counts of all properties, by iterating the whole database
+ */
+void CMPNonFungibleTokensDB::FullSanityCheck()
+{
+    assert(pdb);
+
+    std::string result = "";
+
     std::map<uint32_t,int64_t> totals;
 
     leveldb::Iterator* it = NewIterator();
-    for (it->SeekToFirst(); it->Valid(); it->Next()) {
+    for (it->Seek(std::string(1, RANGE_KEY_PREFIX)); it->Valid() && it->key().starts_with(std::string(1, RANGE_KEY_PREFIX)); it->Next()) {
         if (GetTypeFromKey(it->key().ToString()) != NonFungibleStorage::RangeIndex) continue;
         uint32_t propertyId = GetPropertyIdFromKey(it->key().ToString());
         int64_t start, end;
@@ -422,15 +542,28 @@ void CMPNonFungibleTokensDB::SanityCheck()
     delete it;
 
     for (std::map<uint32_t,int64_t>::iterator it = totals.begin(); it != totals.end(); ++it) {
-        if (mastercore::getTotalTokens(it->first) != it->second) {
-            std::string abortMsg = strprintf("Failed sanity check on property %d (%d != %d)\n", it->first, mastercore::getTotalTokens(it->first), it->second);
+        std::map<uint32_t, int64_t>::const_iterator itIssued = mapIssuedTokens.find(it->first);
+        if (itIssued != mapIssuedTokens.end() && itIssued->second != it->second) {
+            std::string abortMsg = strprintf("Failed sanity check on property %d (issued tokens %d != highest token %d)\n", it->first, itIssued->second, it->second);
             AbortNode(abortMsg);
-        } else {
-            result = result + strprintf("%d:%d=%d,", it->first, mastercore::getTotalTokens(it->first), it->second);
+            return;
         }
+        if (!CheckSupply(it->first, it->second, result)) return;
     }
+    setTouchedProperties.clear();
 
-    if (msc_debug_nftdb) PrintToLog("UTDB sanity check OK (%s)\n", result);
+    PrintToLog("UTDB full sanity check OK (%s)\n", result);
+}
+
+/* Deletes all tokens, and resets the issued token counts
+ */
+void CMPNonFungibleTokensDB::Clear()
+{
+    // wipe database via parent class
+    CDBBase::Clear();
+    // drop the tracked token counts
+    mapIssuedTokens.clear();
+    setTouchedProperties.clear();
 }
 
 void CMPNonFungibleTokensDB::printStats()
@@ -448,7 +581,7 @@ void CMPNonFungibleTokensDB::printAll()
         skey = it->key();
         svalue = it->value();
         ++count;
-        PrintToConsole("entry #%8d= %s:%s\n", count, skey.ToString(), svalue.ToString());
+        PrintToConsole("entry #%8d= %s:%s\n", count, HexStr(skey.ToString()), svalue.ToString());
 //      PrintToLog("entry #%8d= %s:%s\n", count, skey.ToString(), svalue.ToString());
     }
 
@@ -7,6 +7,9 @@
 #include <omnicore/persistence.h>
 
 #include <stdint.h>
+#include <map>
+#include <set>
+
 #include <boost/filesystem.hpp>
 
 enum class NonFungibleStorage : unsigned char
@@ -18,10 +21,30 @@ enum class NonFungibleStorage : unsigned char
     HolderData = 'H',
 };
 
-/** LevelDB based storage for non-fungible tokens, with uid range (propertyid_tokenidstart-tokenidend) as key and token owner (address) as value.
+/** LevelDB based storage for non-fungible tokens, with uid range (propertyid, type, tokenidstart, tokenidend) as key and token owner (address) or data as value.
+ *
+ * Keys are binary and big-endian encoded, so ranges of a property can be looked up by seeking. Owned ranges are
+ * additionally indexed by owner.
+ *
+ * The number of tokens issued per property is tracked in memory, so the supply can be verified for the properties
+ * changed in a block, without iterating the whole database.
+ *
+ * Note: the database is not thread-safe, and cs_tally should be locked!
  */
 class CMPNonFungibleTokensDB : public CDBBase
 {
+private:
+    // Finds the range of a given type, which contains a token, and optionally its value
+    bool FindRange(const uint32_t &propertyId, const int64_t &tokenId, const NonFungibleStorage type, int64_t& start, int64_t& end, std::string* value = nullptr);
+    // Reads the highest token range end of a property from the database
+    int64_t ReadHighestRangeEnd(const uint32_t &propertyId);
+    // Verifies the number of issued tokens of a property against the tally, returns false on mismatch
+    bool CheckSupply(const uint32_t &propertyId, const int64_t &issued, std::string& result);
+
+    //! Number of tokens issued per property, which is the highest token range end
+    std::map<uint32_t, int64_t> mapIssuedTokens;
+    //! Properties with tokens created or moved, since the last sanity check
+    std::set<uint32_t> setTouchedProperties;
 
 public:
     CMPNonFungibleTokensDB(const boost::filesystem::path& path, bool fWipe)
@@ -35,6 +58,9 @@ public:
         if (msc_debug_persistence) PrintToLog("CMPNonFungibleTokensDB closed\n");
     }
 
+    /** Extends clearing of CDBBase. */
+    void Clear();
+
     void printStats();
     void printAll();
 
@@ -69,8 +95,10 @@ public:
     std::map<uint32_t, std::vector<std::pair<int64_t, int64_t>>> GetAddressNonFungibleTokens(const uint32_t &propertyId, const std::string &address);
     // Gets the non-fungible token ranges for a property ID
     std::vector<std::pair<std::string,std::pair<int64_t,int64_t> > > GetNonFungibleTokenRanges(const uint32_t &propertyId);
-    // Sanity checks the token counts
+    // Sanity checks the token counts of the properties changed since the last check
     void SanityCheck();
+    // Sanity checks the token counts of all properties, by iterating the whole database
+    void FullSanityCheck();
 };
 
 namespace mastercore
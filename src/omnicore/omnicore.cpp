@@ -17,6 +17,7 @@
 #include <omnicore/dbtransaction.h>
 #include <omnicore/dbtxlist.h>
 #include <omnicore/dex.h>
+#include <omnicore/inputcache.h>
 #include <omnicore/log.h>
 #include <omnicore/mdex.h>
 #include <omnicore/notifications.h>
@@ -28,18 +29,22 @@
 #include <omnicore/seedblocks.h>
 #include <omnicore/sp.h>
 #include <omnicore/tally.h>
+#include <omnicore/tallysnapshot.h>
 #include <omnicore/tx.h>
 #include <omnicore/utilsxep.h>
 #include <omnicore/utilsui.h>
 #include <omnicore/version.h>
 #include <omnicore/walletcache.h>
+#include <omnicore/walletfetchtxs.h>
 #include <omnicore/walletutils.h>
 
 #include <base58.h>
+#include <chain.h>
 #include <chainparams.h>
 #include <coins.h>
 #include <core_io.h>
 #include <fs.h>
+#include <index/txindex.h>
 #include <key_io.h>
 #include <init.h>
 #include <validation.h>
@@ -52,8 +57,10 @@
 #include <tinyformat.h>
 #include <uint256.h>
 #include <ui_interface.h>
+#include <undo.h>
 #include <util/system.h>
 #include <util/strencodings.h>
+#include <util/threadnames.h>
 #include <util/time.h>
 #ifdef ENABLE_WALLET
 #include <wallet/ismine.h>
@@ -67,8 +74,12 @@
 #include <stdint.h>
 #include <stdio.h>
 
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
 #include <set>
 #include <string>
+#include <thread>
 #include <unordered_map>
 #include <vector>
 
@@ -139,8 +150,12 @@ std::set<std::pair<uint32_t,int> > setFreezingEnabledProperties;
 //! Set containing addresses that have been frozen
 std::set<std::pair<std::string,uint32_t> > setFrozenAddresses;
 
+//! Interned addresses, used as keys of the tally map and holder index
+CMPAddressTable mastercore::mp_address_table;
 //! In-memory collection of all amounts for all addresses for all properties
-std::unordered_map<std::string, CMPTally> mastercore::mp_tally_map;
+std::unordered_map<uint32_t, CMPTally> mastercore::mp_tally_map;
+//! Index of holders and total number of tokens per property
+CMPHolderIndex mastercore::mp_holder_index;
 
 // Only needed for GUI:
 
@@ -247,13 +262,32 @@ std::string FormatByType(int64_t amount, uint16_t propertyType)
 
 CMPTally* mastercore::getTally(const std::string& address)
 {
-    std::unordered_map<std::string, CMPTally>::iterator it = mp_tally_map.find(address);
+    uint32_t handle = 0;
+    if (!mp_address_table.find(address, handle)) {
+        return static_cast<CMPTally*>(nullptr);
+    }
+
+    std::unordered_map<uint32_t, CMPTally>::iterator it = mp_tally_map.find(handle);
 
     if (it != mp_tally_map.end()) return &(it->second);
 
     return static_cast<CMPTally*>(nullptr);
 }
 
+/**
+ * Removes all tallies and the holder index.
+ *
+ * Interned addresses are kept, so handles remain valid.
+ */
+void mastercore::ClearTallyMap()
+{
+    mp_tally_map.clear();
+    mp_holder_index.clear();
+    ClearConsensusBalances();
+    WalletCacheInvalidate();
+    TallySnapshotInvalidate();
+}
+
 // look at balance for an address
 int64_t GetTokenBalance(const std::string& address, uint32_t propertyId, TallyType ttype)
 {
@@ -263,9 +297,9 @@ int64_t GetTokenBalance(const std::string& address, uint32_t propertyId, TallyTy
     }
 
     LOCK(cs_tally);
-    const std::unordered_map<std::string, CMPTally>::iterator my_it = mp_tally_map.find(address);
-    if (my_it != mp_tally_map.end()) {
-        balance = (my_it->second).getMoney(propertyId, ttype);
+    const CMPTally* tally = getTally(address);
+    if (tally) {
+        balance = tally->getMoney(propertyId, ttype);
     }
 
     return balance;
@@ -323,6 +357,7 @@ void mastercore::ClearFreezeState()
     // Should only ever be called in the event of a reorg
     setFreezingEnabledProperties.clear();
     setFrozenAddresses.clear();
+    TallySnapshotMarkFrozenDirty();
 }
 
 void mastercore::PrintFreezeState()
@@ -362,6 +397,7 @@ void mastercore::disableFreezing(uint32_t propertyId)
         if ((*it).second == propertyId) {
             PrintToLog("Address %s has been unfrozen for property %d.\n", (*it).first, propertyId);
             it = setFrozenAddresses.erase(it);
+            TallySnapshotMarkFrozenDirty();
             assert(!isAddressFrozen((*it).first, (*it).second));
         } else {
             it++;
@@ -386,6 +422,7 @@ bool mastercore::isFreezingEnabled(uint32_t propertyId, int block)
 void mastercore::freezeAddress(const std::string& address, uint32_t propertyId)
 {
     setFrozenAddresses.insert(std::make_pair(address, propertyId));
+    TallySnapshotMarkFrozenDirty();
     assert(isAddressFrozen(address, propertyId));
     PrintToLog("Address %s has been frozen for property %d.\n", address, propertyId);
 }
@@ -393,6 +430,7 @@ void mastercore::freezeAddress(const std::string& address, uint32_t propertyId)
 void mastercore::unfreezeAddress(const std::string& address, uint32_t propertyId)
 {
     setFrozenAddresses.erase(std::make_pair(address, propertyId));
+    TallySnapshotMarkFrozenDirty();
     assert(!isAddressFrozen(address, propertyId));
     PrintToLog("Address %s has been unfrozen for property %d.\n", address, propertyId);
 }
@@ -424,8 +462,6 @@ std::string mastercore::getTokenLabel(uint32_t propertyId)
 // optionally counts the number of addresses who own that property: n_owners_total
 int64_t mastercore::getTotalTokens(uint32_t propertyId, int64_t* n_owners_total)
 {
-    int64_t prev = 0;
-    int64_t owners = 0;
     int64_t totalTokens = 0;
 
     LOCK(cs_tally);
@@ -436,19 +472,7 @@ int64_t mastercore::getTotalTokens(uint32_t propertyId, int64_t* n_owners_total)
     }
 
     if (!property.fixed || n_owners_total) {
-        for (std::unordered_map<std::string, CMPTally>::const_iterator it = mp_tally_map.begin(); it != mp_tally_map.end(); ++it) {
-            const CMPTally& tally = it->second;
-
-            totalTokens += tally.getMoney(propertyId, BALANCE);
-            totalTokens += tally.getMoney(propertyId, SELLOFFER_RESERVE);
-            totalTokens += tally.getMoney(propertyId, ACCEPT_RESERVE);
-            totalTokens += tally.getMoney(propertyId, METADEX_RESERVE);
-
-            if (prev != totalTokens) {
-                prev = totalTokens;
-                owners++;
-            }
-        }
+        totalTokens = mp_holder_index.getTotal(propertyId);
         int64_t cachedFee = pDbFeeCache->GetCachedAmount(propertyId);
         totalTokens += cachedFee;
     }
@@ -457,7 +481,7 @@ int64_t mastercore::getTotalTokens(uint32_t propertyId, int64_t* n_owners_total)
         totalTokens = property.num_tokens; // only valid for TX50
     }
 
-    if (n_owners_total) *n_owners_total = owners;
+    if (n_owners_total) *n_owners_total = mp_holder_index.getHolderCount(propertyId);
 
     return totalTokens;
 }
@@ -486,15 +510,21 @@ bool mastercore::update_tally_map(const std::string& who, uint32_t propertyId, i
 
     before = GetTokenBalance(who, propertyId, ttype);
 
-    std::unordered_map<std::string, CMPTally>::iterator my_it = mp_tally_map.find(who);
-    if (my_it == mp_tally_map.end()) {
-        // insert an empty element
-        my_it = (mp_tally_map.insert(std::make_pair(who, CMPTally()))).first;
-    }
-
-    CMPTally& tally = my_it->second;
+    // inserts an empty element, if there is none
+    uint32_t handle = mp_address_table.intern(who);
+    CMPTally& tally = mp_tally_map[handle];
+    int64_t ownedBefore = tally.getMoneyOwned(propertyId);
     bRet = tally.updateMoney(propertyId, amount, ttype);
 
+    if (bRet && PENDING != ttype) {
+        mp_holder_index.update(handle, propertyId, ownedBefore, tally.getMoneyOwned(propertyId));
+        MarkConsensusBalancesDirty(who);
+        TallySnapshotMarkDirty(handle);
+    }
+    if (bRet) {
+        WalletCacheMarkDirty(handle);
+    }
+
     after = GetTokenBalance(who, propertyId, ttype);
     if (!bRet) {
         assert(before == after);
@@ -625,15 +655,14 @@ void CheckWalletUpdate(bool forceUpdate)
     global_balance_reserved.clear();
 
     // populate global balance totals and wallet property list - note global balances do not include additional balances from watch-only addresses
-    for (std::unordered_map<std::string, CMPTally>::iterator my_it = mp_tally_map.begin(); my_it != mp_tally_map.end(); ++my_it) {
+    for (std::unordered_map<uint32_t, CMPTally>::const_iterator my_it = mp_tally_map.begin(); my_it != mp_tally_map.end(); ++my_it) {
         // check if the address is a wallet address (including watched addresses)
-        std::string address = my_it->first;
+        const std::string& address = mp_address_table.resolve(my_it->first);
         int addressIsMine = IsMyAddressAllWallets(address, false, ISMINE_SPENDABLE);
         if (!addressIsMine) continue;
         // iterate only those properties in the TokenMap for this address
-        my_it->second.init();
-        uint32_t propertyId;
-        while (0 != (propertyId = (my_it->second).next())) {
+        for (const CMPTally::BalanceRecord& record : my_it->second) {
+            uint32_t propertyId = record.propertyId;
             // add to the global wallet property list
             global_wallet_property_list.insert(propertyId);
             // check if the address is spendable (only spendable balances are included in totals)
@@ -852,19 +881,36 @@ int mastercore::GetEncodingClass(const CTransaction& tx, int nBlock)
     return NO_MARKER;
 }
 
+//! Resolved transaction inputs, bounded by "-omnitxcache"
+CMPInputCache mastercore::inputCache(500000);
 // TODO: move
-CCoinsView mastercore::viewDummy;
-CCoinsViewCache mastercore::view(&viewDummy);
+CCoinsViewCache mastercore::view(&inputCache);
 
-//! Guards coins view cache
+//! Guards coins view cache and input cache
 RecursiveMutex mastercore::cs_tx_cache;
 
-static unsigned int nCacheHits = 0;
-static unsigned int nCacheMiss = 0;
+static uint64_t nCacheHits = 0;
+static uint64_t nCacheMiss = 0;
+
+/**
+ * Provides the usage statistics of the input cache.
+ */
+void mastercore::GetInputCacheStats(uint64_t& size, uint64_t& hits, uint64_t& misses, uint64_t& evictions)
+{
+    LOCK(cs_tx_cache);
+    size = inputCache.size();
+    hits = nCacheHits;
+    misses = nCacheMiss;
+    evictions = inputCache.evictions();
+}
 
 /**
  * Fetches transaction inputs and adds them to the coins view cache.
  *
+ * Inputs are served from the input cache, or from the coins spent by the block,
+ * if available, and only looked up via GetTransaction() as last resort. Resolved
+ * inputs are kept in the input cache, which evicts the least recently used coins.
+ *
  * Note: cs_tx_cache should be locked, when adding and accessing inputs!
  *
  * @param tx[in]  The transaction to fetch inputs for
@@ -872,12 +918,11 @@ static unsigned int nCacheMiss = 0;
  */
 static bool FillTxInputCache(const CTransaction& tx, const std::shared_ptr<std::map<COutPoint, Coin>> removedCoins)
 {
-    static unsigned int nCacheSize = gArgs.GetArg("-omnitxcache", 500000);
+    // at least one coin is kept, so an added coin is never evicted right away
+    static const size_t nCacheSize = std::max<int64_t>(1, gArgs.GetArg("-omnitxcache", 500000));
 
-    if (view.GetCacheSize() > nCacheSize) {
-        PrintToLog("%s(): clearing cache before insertion [size=%d, hit=%d, miss=%d]\n",
-                __func__, view.GetCacheSize(), nCacheHits, nCacheMiss);
-        view.Flush();
+    if (inputCache.maxSize() != nCacheSize) {
+        inputCache.SetMaxSize(nCacheSize);
     }
 
     for (std::vector<CTxIn>::const_iterator it = tx.vin.begin(); it != tx.vin.end(); ++it) {
@@ -895,9 +940,11 @@ static bool FillTxInputCache(const CTransaction& tx, const std::shared_ptr<std::
         CTransactionRef txPrev;
         uint256 hashBlock;
         Coin newcoin;
-        if (removedCoins && removedCoins->find(txIn.prevout) != removedCoins->end()) {
-            newcoin = removedCoins->find(txIn.prevout)->second;
+        std::map<COutPoint, Coin>::const_iterator itCoin;
+        if (removedCoins && (itCoin = removedCoins->find(txIn.prevout)) != removedCoins->end()) {
+            newcoin = itCoin->second;
         } else if (GetTransaction(txIn.prevout.hash, txPrev, Params().GetConsensus(), hashBlock)) {
+            if (nOut >= txPrev->vout.size()) return false;
             newcoin.out.scriptPubKey = txPrev->vout[nOut].scriptPubKey;
             newcoin.out.nValue = txPrev->vout[nOut].nValue;
             BlockMap::iterator bit = ::BlockIndex().find(hashBlock);
@@ -906,12 +953,37 @@ static bool FillTxInputCache(const CTransaction& tx, const std::shared_ptr<std::
             return false;
         }
 
-        view.AddCoin(txIn.prevout, std::move(newcoin), true);
+        inputCache.AddCoin(txIn.prevout, newcoin);
+
+        // fetch the coin into the view, before other inputs of the transaction may evict it from the input cache
+        view.AccessCoin(txIn.prevout);
     }
 
     return true;
 }
 
+/**
+ * Removes the inputs of a transaction from the coins view cache, once they were
+ * used, so they are only kept by the bounded input cache.
+ *
+ * Note: inputs, which were explicitly added to the view, are not removed.
+ */
+class TxInputsUncacher
+{
+private:
+    const CTransaction& tx;
+
+public:
+    explicit TxInputsUncacher(const CTransaction& txIn) : tx(txIn) {}
+
+    ~TxInputsUncacher()
+    {
+        for (const CTxIn& txIn : tx.vin) {
+            view.Uncache(txIn.prevout);
+        }
+    }
+};
+
 // idx is position within the block, 0-based
 // int msc_tx_push(const CTransaction &wtx, int nBlock, unsigned int idx)
 // INPUT: bRPConly -- set to true to avoid moving funds; to be called from various RPC calls like this
@@ -945,6 +1017,7 @@ static int parseTransaction(bool bRPConly, const CTransaction& wtx, int nBlock,
     // mempool.cs for FillTxInputCache() > GetTransaction() > mempool.get()
     LOCK2(cs_main, ::mempool.cs);
     LOCK(cs_tx_cache);
+    TxInputsUncacher uncacher(wtx);
 
     // Add previous transaction inputs to the cache
     if (!FillTxInputCache(wtx, removedCoins)) {
@@ -1522,6 +1595,220 @@ public:
     }
 };
 
+/**
+ * A block to scan, and the location of its data and undo data on disk.
+ *
+ * The positions are taken while cs_main is held, because validation may update
+ * the status of the block index, e.g. when the block is pruned.
+ */
+struct ScanBlock
+{
+    const CBlockIndex* pblockindex = nullptr;
+    FlatFilePos blockPos;
+    //! Null, if the block has no undo data
+    FlatFilePos undoPos;
+};
+
+static ScanBlock GetScanBlock(const CBlockIndex* pblockindex) EXCLUSIVE_LOCKS_REQUIRED(cs_main)
+{
+    ScanBlock scanBlock;
+    scanBlock.pblockindex = pblockindex;
+    if (pblockindex) {
+        scanBlock.blockPos = pblockindex->GetBlockPos();
+        scanBlock.undoPos = pblockindex->GetUndoPos();
+    }
+    return scanBlock;
+}
+
+/**
+ * Reads a block to scan from the disk.
+ *
+ * Note: cs_main is not acquired, because the scan may run while it is held.
+ */
+static bool ReadScanBlock(CBlock& block, const ScanBlock& scanBlock)
+{
+    if (!ReadBlockFromDisk(block, scanBlock.blockPos, Params().GetConsensus())) return false;
+
+    return block.GetHash() == scanBlock.pblockindex->GetBlockHash();
+}
+
+/**
+ * Resolves the outputs spent by the potential Omni transactions of a block.
+ *
+ * The spent outputs are taken from the undo data of the block, so all inputs of
+ * the block are resolved with a single read. If the undo data is not available,
+ * e.g. because the block was pruned, the transaction index is used instead, if
+ * it's enabled.
+ *
+ * Note: cs_main is not acquired, because the scan may run while it is held.
+ *
+ * @param block[in]      The block to resolve the inputs for
+ * @param scanBlock[in]  The index and the undo data position of the block
+ * @return The spent outputs, or nullptr, if they can't be resolved
+ */
+static std::shared_ptr<std::map<COutPoint, Coin>> GetBlockInputs(const CBlock& block, const ScanBlock& scanBlock)
+{
+    std::shared_ptr<std::map<COutPoint, Coin>> inputs = std::make_shared<std::map<COutPoint, Coin>>();
+
+    const CBlockIndex* pblockindex = scanBlock.pblockindex;
+    CBlockUndo blockUndo;
+    if (pblockindex->pprev && !scanBlock.undoPos.IsNull() &&
+            UndoReadFromDisk(blockUndo, scanBlock.undoPos, pblockindex->pprev->GetBlockHash()) &&
+            blockUndo.vtxundo.size() + 1 == block.vtx.size()) {
+        for (size_t i = 1; i < block.vtx.size(); ++i) {
+            const CTransactionRef& tx = block.vtx[i];
+            const CTxUndo& txUndo = blockUndo.vtxundo[i - 1];
+            if (!HasMarkerUnsafe(tx) || txUndo.vprevout.size() != tx->vin.size()) continue;
+
+            for (size_t j = 0; j < tx->vin.size(); ++j) {
+                inputs->insert(std::make_pair(tx->vin[j].prevout, txUndo.vprevout[j]));
+            }
+        }
+        return inputs;
+    }
+
+    if (!g_txindex) return nullptr;
+
+    // the height of the coins is not looked up, but it's not used by the parser
+    for (const auto& tx : block.vtx) {
+        if (tx->IsCoinBase() || !HasMarkerUnsafe(tx)) continue;
+
+        for (const CTxIn& txIn : tx->vin) {
+            CTransactionRef txPrev;
+            uint256 hashBlock;
+            if (!g_txindex->FindTx(txIn.prevout.hash, hashBlock, txPrev)) continue;
+            if (txIn.prevout.n >= txPrev->vout.size()) continue;
+
+            Coin coin;
+            coin.out = txPrev->vout[txIn.prevout.n];
+            coin.nHeight = 1;
+            inputs->insert(std::make_pair(txIn.prevout, std::move(coin)));
+        }
+    }
+
+    return inputs;
+}
+
+/**
+ * Reads blocks ahead of the initial scan and resolves inputs of potential Omni transactions.
+ *
+ * Worker threads load upcoming blocks from disk, check each transaction for an Omni
+ * marker, and look up the spent outputs of those transactions via GetBlockInputs().
+ * The results are handed to the scan in block order, while the processing of
+ * the transactions, which mutates the state, remains strictly serial.
+ *
+ * The resolved inputs are only used to fill the input cache, and every transaction
+ * is still passed to mastercore_handler_tx(), so the result of the scan is unaffected.
+ *
+ * @see msc_initial_scan()
+ */
+class ScanPrefetcher
+{
+public:
+    //! A block read ahead of the scan
+    struct Item
+    {
+        const CBlockIndex* pblockindex = nullptr;
+        bool fSkipped = false;
+        bool fRead = false;
+        CBlock block;
+        std::shared_ptr<std::map<COutPoint, Coin>> inputs;
+    };
+
+private:
+    const int m_nFirstBlock;
+    const int m_nLastBlock;
+    //! Blocks to scan, collected upfront to avoid acquiring cs_main in the workers
+    const std::vector<ScanBlock> m_vScanBlocks;
+    const bool m_fSeedBlockFilter;
+    const int m_nWindow;
+
+    std::mutex m_mutex;
+    std::condition_variable m_cond;
+    //! Next block to be loaded by a worker
+    int m_nNextBlock;
+    //! Next block to be consumed by the scan
+    int m_nScanBlock;
+    //! Loaded blocks, which are not yet consumed
+    std::map<int, Item> m_items;
+    bool m_fStop;
+    std::vector<std::thread> m_threads;
+
+    /** Loads a single block and resolves the inputs of its potential Omni transactions. */
+    void Load(int nBlock, Item& item) const
+    {
+        const ScanBlock& scanBlock = m_vScanBlocks[nBlock - m_nFirstBlock];
+        item.pblockindex = scanBlock.pblockindex;
+        if (nullptr == item.pblockindex) return;
+
+        if (m_fSeedBlockFilter && SkipBlock(nBlock)) {
+            item.fSkipped = true;
+            return;
+        }
+
+        item.fRead = ReadScanBlock(item.block, scanBlock);
+        if (item.fRead) {
+            item.inputs = GetBlockInputs(item.block, scanBlock);
+        }
+    }
+
+    void ThreadLoad()
+    {
+        util::ThreadRename("omniscan");
+
+        std::unique_lock<std::mutex> lock(m_mutex);
+        while (true) {
+            m_cond.wait(lock, [this] { return m_fStop || (m_nNextBlock <= m_nLastBlock && m_nNextBlock < m_nScanBlock + m_nWindow); });
+            if (m_fStop) return;
+
+            int nBlock = m_nNextBlock++;
+            lock.unlock();
+            Item item;
+            Load(nBlock, item);
+            lock.lock();
+
+            m_items[nBlock] = std::move(item);
+            m_cond.notify_all();
+        }
+    }
+
+public:
+    ScanPrefetcher(int nFirstBlock, const std::vector<ScanBlock>& vScanBlocks, bool fSeedBlockFilter, int nThreads)
+    : m_nFirstBlock(nFirstBlock), m_nLastBlock(nFirstBlock + static_cast<int>(vScanBlocks.size()) - 1),
+      m_vScanBlocks(vScanBlocks), m_fSeedBlockFilter(fSeedBlockFilter), m_nWindow(16 * nThreads),
+      m_nNextBlock(nFirstBlock), m_nScanBlock(nFirstBlock), m_fStop(false)
+    {
+        for (int i = 0; i < nThreads; ++i) {
+            m_threads.emplace_back(&ScanPrefetcher::ThreadLoad, this);
+        }
+    }
+
+    ~ScanPrefetcher()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_fStop = true;
+        }
+        m_cond.notify_all();
+        for (std::thread& thread : m_threads) {
+            thread.join();
+        }
+    }
+
+    /** Waits for the given block to be loaded and takes it, blocks must be taken in order. */
+    void Take(int nBlock, Item& item)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        assert(nBlock == m_nScanBlock);
+        m_cond.wait(lock, [this, nBlock] { return m_items.count(nBlock) > 0; });
+
+        item = std::move(m_items[nBlock]);
+        m_items.erase(nBlock);
+        ++m_nScanBlock;
+        m_cond.notify_all();
+    }
+};
+
 /**
  * Scans the blockchain for meta transactions.
  *
@@ -1530,6 +1817,9 @@ public:
  *
  * Every 30 seconds the progress of the scan is reported.
  *
+ * Unless disabled with "-omniscanthreads=0", upcoming blocks are read and the
+ * inputs of potential Omni transactions are resolved by background threads.
+ *
  * In case the current block being processed is not part of the active chain, or
  * if a block could not be retrieved from the disk, then the scan stops early.
  * Likewise, global shutdown requests are honored, and stop the scan progress.
@@ -1568,6 +1858,21 @@ static int msc_initial_scan(int nFirstBlock)
     // check if using seed block filter should be disabled
     bool seedBlockFilterEnabled = gArgs.GetBoolArg("-omniseedblockfilter", true);
 
+    // blocks are read ahead by background threads, unless disabled
+    int nDefaultThreads = std::max(1, std::min(4, static_cast<int>(std::thread::hardware_concurrency()) - 1));
+    int nScanThreads = gArgs.GetArg("-omniscanthreads", nDefaultThreads);
+    std::unique_ptr<ScanPrefetcher> prefetcher;
+    if (nScanThreads > 0) {
+        std::vector<ScanBlock> vScanBlocks;
+        {
+            LOCK(cs_main);
+            for (int nHeight = nFirstBlock; nHeight <= nLastBlock; ++nHeight) {
+                vScanBlocks.push_back(GetScanBlock(::ChainActive()[nHeight]));
+            }
+        }
+        prefetcher.reset(new ScanPrefetcher(nFirstBlock, vScanBlocks, seedBlockFilterEnabled, nScanThreads));
+    }
+
     for (nBlock = nFirstBlock; nBlock <= nLastBlock; ++nBlock)
     {
         if (ShutdownRequested()) {
@@ -1576,9 +1881,11 @@ static int msc_initial_scan(int nFirstBlock)
         }
 
         CBlockIndex* pblockindex;
+        ScanBlock scanBlock;
         {
             LOCK(cs_main);
             pblockindex = ::ChainActive()[nBlock];
+            scanBlock = GetScanBlock(pblockindex);
         }
 
         if (nullptr == pblockindex) break;
@@ -1596,12 +1903,28 @@ static int msc_initial_scan(int nFirstBlock)
         unsigned int nTxsFoundInBlock = 0;
         mastercore_handler_block_begin(nBlock, pblockindex);
 
-        if (!seedBlockFilterEnabled || !SkipBlock(nBlock)) {
-            CBlock block;
-            if (!ReadBlockFromDisk(block, pblockindex, Params().GetConsensus())) break;
+        ScanPrefetcher::Item item;
+        if (prefetcher) {
+            prefetcher->Take(nBlock, item);
+        }
+
+        if (item.pblockindex != pblockindex) {
+            // not read ahead, or the chain changed in the meantime
+            item = ScanPrefetcher::Item();
+            item.fSkipped = seedBlockFilterEnabled && SkipBlock(nBlock);
+            if (!item.fSkipped) {
+                item.fRead = ReadScanBlock(item.block, scanBlock);
+                if (item.fRead) {
+                    item.inputs = GetBlockInputs(item.block, scanBlock);
+                }
+            }
+        }
 
-            for(const auto tx : block.vtx) {
-                if (mastercore_handler_tx(*tx, nBlock, nTxNum, pblockindex, nullptr)) ++nTxsFoundInBlock;
+        if (!item.fSkipped) {
+            if (!item.fRead) break;
+
+            for(const auto& tx : item.block.vtx) {
+                if (mastercore_handler_tx(*tx, nBlock, nTxNum, pblockindex, item.inputs)) ++nTxsFoundInBlock;
                 ++nTxNum;
             }
         }
@@ -1629,7 +1952,7 @@ void clear_all_state()
     LOCK2(cs_tally, cs_pending);
 
     // Memory based storage
-    mp_tally_map.clear();
+    ClearTallyMap();
     my_offers.clear();
     my_accepts.clear();
     my_crowds.clear();
@@ -1649,6 +1972,7 @@ void clear_all_state()
     pDbFeeCache->Clear();
     pDbFeeHistory->Clear();
     pDbNFT->Clear();
+    WalletTxIndexInvalidate();
     assert(pDbTransactionList->setDBVersion() == DB_VERSION); // new set of databases, set DB version
     exodus_prev = 0;
 }
@@ -1725,7 +2049,6 @@ int mastercore_init()
         PrintToLog("Startup time: %s\n", FormatISO8601DateTime(GetTime()));
 
         InitDebugLogLevels();
-        ShrinkDebugLog();
 
         if (isNonMainNet()) {
             exodus_address = exodus_testnet;
@@ -1785,6 +2108,11 @@ int mastercore_init()
         ++mastercoreInitialized;
     }
 
+    // pending transactions are discarded, once they leave the mempool
+    RegisterPendingListener();
+    // the wallet caches are refreshed, when keys or transactions are added to a wallet
+    RegisterWalletNotifications();
+
     int nWaterline = LoadMostRelevantInMemoryState();
 
     if (!startClean && nWaterline > 0 && nWaterline < GetHeight()) {
@@ -1879,6 +2207,11 @@ int mastercore_init()
         nWaterline = nWaterlineBlock;
     }
 
+    // select the blocks, which can be skipped during the initial scan
+    if (gArgs.GetBoolArg("-omniseedblockfilter", true)) {
+        InitSeedBlockFilter();
+    }
+
     // initial scan
     msc_initial_scan(nWaterline);
 
@@ -1905,6 +2238,9 @@ int mastercore_init()
  */
 int mastercore_shutdown()
 {
+    UnregisterPendingListener();
+    UnregisterWalletNotifications();
+
     LOCK(cs_tally);
 
     if (pDbTransactionList) {
@@ -1945,6 +2281,9 @@ int mastercore_shutdown()
     PrintToLog("\nOmniXEP Core shutdown completed\n");
     PrintToLog("Shutdown time: %s\n", FormatISO8601DateTime(GetTime()));
 
+    // write the remaining log messages
+    StopDebugLog();
+
     PrintToConsole("OmniXEP Core shutdown completed\n");
 
     return 0;
@@ -2125,9 +2464,6 @@ int mastercore_handler_block_end(int nBlockNow, CBlockIndex const * pBlockIndex,
         // check the alert status, do we need to do anything else here?
         CheckExpiredAlerts(nBlockNow, pBlockIndex->GetBlockTime());
 
-        // check that pending transactions are still in the mempool
-        PendingCheck();
-
         // transactions were found in the block, signal the UI accordingly
         if (countMP > 0) CheckWalletUpdate(true);
 
@@ -2137,8 +2473,13 @@ int mastercore_handler_block_end(int nBlockNow, CBlockIndex const * pBlockIndex,
             PrintToLog("Consensus hash for block %d: %s\n", nBlockNow, consensusHash.GetHex());
         }
 
-        // request nftdb sanity check
-        pDbNFT->SanityCheck();
+        // request nftdb sanity check, either of the properties changed in the block, or of all
+        static const bool fNftAudit = gArgs.GetBoolArg("-omninftaudit", false);
+        if (fNftAudit) {
+            pDbNFT->FullSanityCheck();
+        } else {
+            pDbNFT->SanityCheck();
+        }
 
         // request checkpoint verification
         checkpointValid = VerifyCheckpoint(nBlockNow, pBlockIndex->GetBlockHash());
@@ -2165,6 +2506,9 @@ int mastercore_handler_block_end(int nBlockNow, CBlockIndex const * pBlockIndex,
         }
     }
 
+    // make the state after this block available to readers, which don't lock cs_tally
+    PublishTallySnapshot(nBlockNow, pBlockIndex->GetBlockHash(), setFrozenAddresses);
+
     return 0;
 }
 
@@ -2174,6 +2518,8 @@ void mastercore_handler_disc_begin(const int nHeight)
 
     reorgRecoveryMode = 1;
     reorgRecoveryMaxHeight = (nHeight > reorgRecoveryMaxHeight) ? nHeight: reorgRecoveryMaxHeight;
+
+    WalletTxIndexRemoveAbove(nHeight);
 }
 
 /**
@@ -40,7 +40,7 @@ int const DONT_STORE_MAINNET_STATE_UNTIL = 622000;
 #define XEP_PROPERTY_ID 0
 
 // increment this value to force a refresh of the state (similar to --startclean)
-#define DB_VERSION 8
+#define DB_VERSION 14
 
 // could probably also use: int64_t maxInt64 = std::numeric_limits<int64_t>::max();
 // maximum numeric values from the spec:
@@ -192,15 +192,25 @@ int64_t GetXepPaymentAmount(const uint256& txid, const std::string& recipient);
 
 namespace mastercore
 {
-//! In-memory collection of all amounts for all addresses for all properties
-extern std::unordered_map<std::string, CMPTally> mp_tally_map;
+class CMPInputCache;
 
+//! Interned addresses, used as keys of mp_tally_map and mp_holder_index
+extern CMPAddressTable mp_address_table;
+//! In-memory collection of all amounts for all addresses for all properties, keyed by address handle
+extern std::unordered_map<uint32_t, CMPTally> mp_tally_map;
+//! Index of holders and total number of tokens per property, maintained by update_tally_map()
+extern CMPHolderIndex mp_holder_index;
+
+//! Resolved transaction inputs, used as backend of the coins view cache
+extern CMPInputCache inputCache;
 // TODO: move, rename
-extern CCoinsView viewDummy;
 extern CCoinsViewCache view;
-//! Guards coins view cache
+//! Guards coins view cache and input cache
 extern RecursiveMutex cs_tx_cache;
 
+/** Provides the usage statistics of the input cache. */
+void GetInputCacheStats(uint64_t& size, uint64_t& hits, uint64_t& misses, uint64_t& evictions);
+
 /** Returns the encoding class, used to embed a payload. */
 int GetEncodingClass(const CTransaction& tx, int nBlock);
 
@@ -212,6 +222,7 @@ bool isMainEcosystemProperty(uint32_t propertyId);
 uint32_t GetNextPropertyId(bool maineco); // maybe move into sp
 
 CMPTally* getTally(const std::string& address);
+void ClearTallyMap();
 bool update_tally_map(const std::string& who, uint32_t propertyId, int64_t amount, TallyType ttype);
 int64_t getTotalTokens(uint32_t propertyId, int64_t* n_owners_total = nullptr);
 
@@ -1,10 +1,13 @@
 #include <omnicore/pending.h>
 
 #include <omnicore/log.h>
+#include <omnicore/omnicore.h>
 #include <omnicore/sp.h>
 
 #include <amount.h>
+#include <primitives/transaction.h>
 #include <validation.h>
+#include <validationinterface.h>
 #include <sync.h>
 #include <txmempool.h>
 #include <uint256.h>
@@ -20,6 +23,49 @@ RecursiveMutex cs_pending;
 //! Global map of pending transaction objects
 PendingMap my_pending;
 
+/**
+ * Discards pending transactions, as soon as they are removed from the mempool.
+ *
+ * Transactions removed because they were included in a block are skipped:
+ * those are deleted from the pending map by mastercore_handler_tx(), before
+ * the transaction is parsed.
+ */
+class CPendingListener final : public CValidationInterface
+{
+protected:
+    void TransactionRemovedFromMempool(const CTransactionRef& tx, MemPoolRemovalReason reason) override
+    {
+        if (reason == MemPoolRemovalReason::BLOCK) return;
+
+        LOCK2(cs_tally, cs_pending);
+
+        const uint256& txid = tx->GetHash();
+        if (my_pending.find(txid) == my_pending.end()) return;
+
+        PrintToLog("WARNING: Pending transaction %s is no longer in this nodes mempool and will be discarded\n", txid.GetHex());
+        PendingDelete(txid);
+    }
+};
+
+//! Listener for mempool removals of pending transactions
+static CPendingListener pendingListener;
+
+/**
+ * Subscribes to mempool removals to discard pending transactions.
+ */
+void RegisterPendingListener()
+{
+    RegisterValidationInterface(&pendingListener);
+}
+
+/**
+ * Unsubscribes from mempool removals.
+ */
+void UnregisterPendingListener()
+{
+    UnregisterValidationInterface(&pendingListener);
+}
+
 /**
  * Adds a transaction to the pending map using supplied parameters.
  */
@@ -45,6 +91,12 @@ void PendingAdd(const uint256& txid, const std::string& sendingAddress, uint16_t
         LOCK(cs_pending);
         my_pending.insert(std::make_pair(txid, pending));
     }
+    // the transaction may already have left the mempool, before the listener could notice it
+    if (!mempool.exists(txid)) {
+        LOCK(cs_tally);
+        PrintToLog("WARNING: Pending transaction %s is not in this nodes mempool and will be discarded\n", txid.GetHex());
+        PendingDelete(txid);
+    }
     // after adding a transaction to pending the available balance may now be reduced, refresh wallet totals
     CheckWalletUpdate(true); // force an update since some outbound pending (eg MetaDEx cancel) may not change balances
     uiInterface.OmniPendingChanged(true);
@@ -72,32 +124,6 @@ void PendingDelete(const uint256& txid)
     }
 }
 
-/**
- * Performs a check to ensure all pending transactions are still in the mempool.
- *
- * NOTE: Transactions no longer in the mempool (eg orphaned) are deleted from
- *       the pending map and credited back to the pending tally.
- */
-void PendingCheck()
-{
-    LOCK(cs_pending);
-
-    std::vector<uint256> vecMemPoolTxids;
-    std::vector<uint256> txidsForDeletion;
-    mempool.queryHashes(vecMemPoolTxids);
-
-    for (PendingMap::iterator it = my_pending.begin(); it != my_pending.end(); ++it) {
-        const uint256& txid = it->first;
-        if (std::find(vecMemPoolTxids.begin(), vecMemPoolTxids.end(), txid) == vecMemPoolTxids.end()) {
-            PrintToLog("WARNING: Pending transaction %s is no longer in this nodes mempool and will be discarded\n", txid.GetHex());
-            txidsForDeletion.push_back(txid);
-        }
-    }
-
-    for (auto& txid : txidsForDeletion)
-        PendingDelete(txid);
-}
-
 } // namespace mastercore
 
 /**
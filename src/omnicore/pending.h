@@ -25,8 +25,11 @@ void PendingAdd(const uint256& txid, const std::string& sendingAddress, uint16_t
 /** Deletes a transaction from the pending map and credits the amount back to the pending tally for the address. */
 void PendingDelete(const uint256& txid);
 
-/** Performs a check to ensure all pending transactions are still in the mempool. */
-void PendingCheck();
+/** Subscribes to mempool removals to discard pending transactions, which are no longer in the mempool. */
+void RegisterPendingListener();
+
+/** Unsubscribes from mempool removals. */
+void UnregisterPendingListener();
 
 }
 
@@ -15,8 +15,11 @@
 #include <omnicore/utilsxep.h>
 
 #include <chain.h>
+#include <clientversion.h>
 #include <fs.h>
 #include <hash.h>
+#include <serialize.h>
+#include <streams.h>
 #include <validation.h>
 #include <tinyformat.h>
 #include <uint256.h>
@@ -43,16 +46,6 @@ extern int64_t exodus_prev;
 //! Path for file based persistence
 extern fs::path pathStateFiles;
 
-enum FILETYPES {
-  FILETYPE_BALANCES = 0,
-  FILETYPE_OFFERS,
-  FILETYPE_ACCEPTS,
-  FILETYPE_GLOBALS,
-  FILETYPE_CROWDSALES,
-  FILETYPE_MDEXORDERS,
-  NUM_FILETYPES
-};
-
 static char const * const statePrefix[NUM_FILETYPES] = {
     "balances",
     "offers",
@@ -62,6 +55,11 @@ static char const * const statePrefix[NUM_FILETYPES] = {
     "mdexorders",
 };
 
+//! Magic bytes at the beginning of binary state files, not valid at the beginning of text state files
+static const char BINARY_STATE_MAGIC[4] = {'\0', 'O', 'M', 'S'};
+//! Version of the binary state file format
+static const uint32_t BINARY_STATE_VERSION = 1;
+
 static bool is_state_prefix(std::string const &str)
 {
     for (int i = 0; i < NUM_FILETYPES; ++i) {
@@ -73,46 +71,159 @@ static bool is_state_prefix(std::string const &str)
     return false;
 }
 
-static int write_msc_balances(std::ofstream& file, CHash256& hasher)
+/**
+ * Writes the balances in the binary state file format.
+ *
+ * The file starts with the magic bytes and the format version, followed by one record
+ * per address with non-empty balances: the address, the number of balance records,
+ * and for each property the identifier and the four balances as variable length
+ * integers. An empty address terminates the records, and the double SHA256 hash of
+ * all preceding bytes concludes the file.
+ */
+static int write_msc_balances_binary(CAutoFile& file)
 {
-    std::unordered_map<std::string, CMPTally>::iterator iter;
-    for (iter = mp_tally_map.begin(); iter != mp_tally_map.end(); ++iter) {
-        bool emptyWallet = true;
-
-        std::string lineOut = (*iter).first;
-        lineOut.append("=");
-        CMPTally& curAddr = (*iter).second;
-        curAddr.init();
-        uint32_t propertyId = 0;
-        while (0 != (propertyId = curAddr.next())) {
-            int64_t balance = (*iter).second.getMoney(propertyId, BALANCE);
-            int64_t sellReserved = (*iter).second.getMoney(propertyId, SELLOFFER_RESERVE);
-            int64_t acceptReserved = (*iter).second.getMoney(propertyId, ACCEPT_RESERVE);
-            int64_t metadexReserved = (*iter).second.getMoney(propertyId, METADEX_RESERVE);
-
-            // we don't allow 0 balances to read in, so if we don't write them
-            // it makes things match up better between persisted state and processed state
-            if (0 == balance && 0 == sellReserved && 0 == acceptReserved && 0 == metadexReserved) {
-                continue;
+    CHashWriter hasher(SER_DISK, CLIENT_VERSION);
+    CDataStream ssRecord(SER_DISK, CLIENT_VERSION);
+
+    ssRecord.write(BINARY_STATE_MAGIC, sizeof(BINARY_STATE_MAGIC));
+    ssRecord << BINARY_STATE_VERSION;
+
+    std::vector<std::pair<uint32_t, const CMPTally*> > vRecords;
+    for (std::unordered_map<uint32_t, CMPTally>::const_iterator iter = mp_tally_map.begin(); iter != mp_tally_map.end(); ++iter) {
+        const CMPTally& curAddr = iter->second;
+
+        // we don't allow 0 balances to read in, so if we don't write them
+        // it makes things match up better between persisted state and processed state
+        vRecords.clear();
+        for (const CMPTally::BalanceRecord& record : curAddr) {
+            if (0 != curAddr.getMoneyOwned(record.propertyId)) {
+                vRecords.push_back(std::make_pair(record.propertyId, &curAddr));
             }
+        }
+        if (vRecords.empty()) continue;
+
+        ssRecord << mp_address_table.resolve(iter->first);
+        WriteCompactSize(ssRecord, vRecords.size());
+        for (std::vector<std::pair<uint32_t, const CMPTally*> >::const_iterator it = vRecords.begin(); it != vRecords.end(); ++it) {
+            uint32_t propertyId = it->first;
+            const CMPTally& tally = *(it->second);
+            int64_t balance = tally.getMoney(propertyId, BALANCE);
+            int64_t sellReserved = tally.getMoney(propertyId, SELLOFFER_RESERVE);
+            int64_t acceptReserved = tally.getMoney(propertyId, ACCEPT_RESERVE);
+            int64_t metadexReserved = tally.getMoney(propertyId, METADEX_RESERVE);
+
+            ssRecord << VARINT(propertyId);
+            ssRecord << VARINT_MODE(balance, VarIntMode::NONNEGATIVE_SIGNED);
+            ssRecord << VARINT_MODE(sellReserved, VarIntMode::NONNEGATIVE_SIGNED);
+            ssRecord << VARINT_MODE(acceptReserved, VarIntMode::NONNEGATIVE_SIGNED);
+            ssRecord << VARINT_MODE(metadexReserved, VarIntMode::NONNEGATIVE_SIGNED);
+        }
+
+        // flush the record to the file and the hash
+        hasher.write(ssRecord.data(), ssRecord.size());
+        file.write(ssRecord.data(), ssRecord.size());
+        ssRecord.clear();
+    }
+
+    ssRecord << std::string();
+    hasher.write(ssRecord.data(), ssRecord.size());
+    file.write(ssRecord.data(), ssRecord.size());
+
+    file << hasher.GetHash();
+
+    return 0;
+}
+
+/**
+ * Checks whether a state file is in the binary format.
+ *
+ * Only the first byte is checked, which is not valid in text state files, so that
+ * binary files with unknown magic bytes are rejected, instead of parsed as text.
+ */
+static bool is_binary_state_file(const std::string& filename)
+{
+    char magic = 0x01;
+    std::ifstream file(filename.c_str(), std::ios::binary);
+    file.read(&magic, 1);
+
+    return file.good() && magic == BINARY_STATE_MAGIC[0];
+}
 
-            emptyWallet = false;
+/**
+ * Loads the balances from a state file in the binary format.
+ *
+ * The whole file is read at once, and the hash is verified over the buffer, before
+ * any record is parsed.
+ */
+static int restore_msc_balances_binary(const std::string& filename, bool verifyHash, int& records)
+{
+    std::ifstream file(filename.c_str(), std::ios::binary | std::ios::ate);
+    if (!file.is_open()) return -1;
+
+    std::streamoff nSize = file.tellg();
+    if (nSize < static_cast<std::streamoff>(sizeof(BINARY_STATE_MAGIC) + sizeof(uint256))) return -1;
+
+    std::vector<char> vData(nSize);
+    file.seekg(0);
+    if (!file.read(vData.data(), nSize)) return -1;
+    file.close();
 
-            lineOut.append(strprintf("%d:%d,%d,%d,%d;",
-                    propertyId,
-                    balance,
-                    sellReserved,
-                    acceptReserved,
-                    metadexReserved));
+    const size_t nPayloadSize = nSize - sizeof(uint256);
+    if (verifyHash) {
+        uint256 hash;
+        CHash256().Write((const unsigned char*)vData.data(), nPayloadSize).Finalize(hash.begin());
+        if (0 != memcmp(hash.begin(), vData.data() + nPayloadSize, sizeof(uint256))) {
+            PrintToLog("File %s loaded, but failed hash validation!\n", filename);
+            return -1;
         }
+    }
 
-        if (false == emptyWallet) {
-            // add the line to the hash
-            hasher.Write((unsigned char*)lineOut.c_str(), lineOut.length());
+    if (!std::equal(BINARY_STATE_MAGIC, BINARY_STATE_MAGIC + sizeof(BINARY_STATE_MAGIC), vData.begin())) {
+        PrintToLog("File %s has unknown magic bytes\n", filename);
+        return -1;
+    }
 
-            // write the line
-            file << lineOut << std::endl;
+    try {
+        CDataStream ssData(vData.data() + sizeof(BINARY_STATE_MAGIC), vData.data() + nPayloadSize, SER_DISK, CLIENT_VERSION);
+        uint32_t nVersion = 0;
+        ssData >> nVersion;
+        if (nVersion != BINARY_STATE_VERSION) {
+            PrintToLog("File %s has unsupported version %d\n", filename, nVersion);
+            return -1;
         }
+
+        std::string strAddress;
+        while (true) {
+            ssData >> strAddress;
+            if (strAddress.empty()) break;
+
+            uint64_t nRecords = ReadCompactSize(ssData);
+            for (uint64_t n = 0; n < nRecords; ++n) {
+                uint32_t propertyId = 0;
+                int64_t balance = 0;
+                int64_t sellReserved = 0;
+                int64_t acceptReserved = 0;
+                int64_t metadexReserved = 0;
+
+                ssData >> VARINT(propertyId);
+                ssData >> VARINT_MODE(balance, VarIntMode::NONNEGATIVE_SIGNED);
+                ssData >> VARINT_MODE(sellReserved, VarIntMode::NONNEGATIVE_SIGNED);
+                ssData >> VARINT_MODE(acceptReserved, VarIntMode::NONNEGATIVE_SIGNED);
+                ssData >> VARINT_MODE(metadexReserved, VarIntMode::NONNEGATIVE_SIGNED);
+
+                if (balance) update_tally_map(strAddress, propertyId, balance, BALANCE);
+                if (sellReserved) update_tally_map(strAddress, propertyId, sellReserved, SELLOFFER_RESERVE);
+                if (acceptReserved) update_tally_map(strAddress, propertyId, acceptReserved, ACCEPT_RESERVE);
+                if (metadexReserved) update_tally_map(strAddress, propertyId, metadexReserved, METADEX_RESERVE);
+            }
+            ++records;
+        }
+
+        if (!ssData.empty()) return -1;
+
+    } catch (const std::exception& e) {
+        PrintToLog("File %s could not be parsed: %s\n", filename, e.what());
+        return -1;
     }
 
     return 0;
@@ -136,11 +247,8 @@ static int write_mp_accepts(std::ofstream& file, CHash256& hasher)
 {
     AcceptMap::const_iterator iter;
     for (iter = my_accepts.begin(); iter != my_accepts.end(); ++iter) {
-        // decompose the key for address
-        std::vector<std::string> vstr;
-        boost::split(vstr, iter->first, boost::is_any_of("-+"), boost::token_compress_on);
         const CMPAccept& accept = iter->second;
-        accept.saveAccept(file, vstr[0], vstr[2], hasher);
+        accept.saveAccept(file, hasher);
     }
 
     return 0;
@@ -296,7 +404,7 @@ static int input_mp_accepts_string(const std::string& s)
     txidStr = vstr[i++];
 
     const std::string combo = STR_ACCEPT_ADDR_PROP_ADDR_COMBO(sellerAddr, buyerAddr, prop);
-    CMPAccept newAccept(amountOriginal, amountRemaining, nBlock, blocktimelimit, prop, offerOriginal, xepDesired, uint256S(txidStr));
+    CMPAccept newAccept(amountOriginal, amountRemaining, nBlock, blocktimelimit, prop, offerOriginal, xepDesired, uint256S(txidStr), sellerAddr, buyerAddr);
     if (my_accepts.insert(std::make_pair(combo, newAccept)).second) {
         return 0;
     } else {
@@ -404,6 +512,32 @@ static int write_state_file(const CBlockIndex* pBlockIndex, int what)
     fs::path path = pathStateFiles / strprintf("%s-%s.dat", statePrefix[what], pBlockIndex->GetBlockHash().ToString());
     const std::string strFile = path.string();
 
+    // balances are stored in the binary format
+    if (FILETYPE_BALANCES == what) {
+        CAutoFile binaryFile(fsbridge::fopen(path, "wb"), SER_DISK, CLIENT_VERSION);
+        if (binaryFile.IsNull()) {
+            PrintToLog("%s(): failed to open %s\n", __func__, strFile);
+            return -1;
+        }
+
+        int result = -1;
+        try {
+            result = write_msc_balances_binary(binaryFile);
+        } catch (const std::exception& e) {
+            PrintToLog("%s(): failed to write %s: %s\n", __func__, strFile, e.what());
+        }
+
+        // buffered data may only fail to be written, when the file is closed
+        if (fclose(binaryFile.release()) != 0 && result == 0) {
+            PrintToLog("%s(): failed to write %s\n", __func__, strFile);
+            result = -1;
+        }
+        if (result != 0) {
+            fs::remove(path);
+        }
+        return result;
+    }
+
     std::ofstream file;
     file.open(strFile.c_str());
 
@@ -412,10 +546,6 @@ static int write_state_file(const CBlockIndex* pBlockIndex, int what)
     int result = 0;
 
     switch (what) {
-        case FILETYPE_BALANCES:
-            result = write_msc_balances(file, hasher);
-            break;
-
         case FILETYPE_OFFERS:
             result = write_mp_offers(file, hasher);
             break;
@@ -569,7 +699,7 @@ int RestoreInMemoryState(const std::string& filename, int what, bool verifyHash)
 
     switch (what) {
         case FILETYPE_BALANCES:
-            mp_tally_map.clear();
+            ClearTallyMap();
             inputLineFunc = input_msc_balances_string;
             break;
 
@@ -610,6 +740,15 @@ int RestoreInMemoryState(const std::string& filename, int what, bool verifyHash)
         PrintToLog("%s(%s), line %d, file: %s\n", __FUNCTION__, filename, __LINE__, __FILE__);
     }
 
+    // balances may be stored in the binary format, text files are still supported
+    if (FILETYPE_BALANCES == what && is_binary_state_file(filename)) {
+        int records = 0;
+        int res = restore_msc_balances_binary(filename, verifyHash, records);
+        PrintToLog("%s(%s), loaded records= %d, res= %d\n", __FUNCTION__, filename, records, res);
+        LogPrintf("%s(): file: %s , loaded records= %d, res= %d\n", __FUNCTION__, filename, records, res);
+        return res;
+    }
+
     std::ifstream file;
     file.open(filename.c_str());
     if (!file.is_open()) {
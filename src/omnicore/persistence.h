@@ -5,6 +5,17 @@
 
 class CBlockIndex;
 
+/** Types of state files, which hold parts of the in-memory state. */
+enum FILETYPES {
+  FILETYPE_BALANCES = 0,
+  FILETYPE_OFFERS,
+  FILETYPE_ACCEPTS,
+  FILETYPE_GLOBALS,
+  FILETYPE_CROWDSALES,
+  FILETYPE_MDEXORDERS,
+  NUM_FILETYPES
+};
+
 /** Indicates whether persistence is enabled and the state is stored. */
 bool IsPersistenceEnabled(int blockHeight);
 
@@ -25,9 +25,11 @@
 #include <omnicore/rpctxobject.h>
 #include <omnicore/rpcvalues.h>
 #include <omnicore/rules.h>
+#include <omnicore/seedblocks.h>
 #include <omnicore/sp.h>
 #include <omnicore/sto.h>
 #include <omnicore/tally.h>
+#include <omnicore/tallysnapshot.h>
 #include <omnicore/tx.h>
 #include <omnicore/nftdb.h>
 #include <omnicore/utilsxep.h>
@@ -754,6 +756,67 @@ static UniValue omni_getseedblocks(const JSONRPCRequest& request)
     return response;
 }
 
+// write a bitmap of seed blocks to a file, which can be used with -omniseedblockfile
+static UniValue omni_exportseedblocks(const JSONRPCRequest& request)
+{
+    RPCHelpMan{"omni_exportseedblocks",
+       "\nWrites the blocks containing Omni transactions to a file, which can be used with -omniseedblockfile.\n",
+       {
+           {"startblock", RPCArg::Type::NUM, RPCArg::Optional::NO, "the first block covered by the seed block file (inclusive)"},
+           {"endblock", RPCArg::Type::NUM, RPCArg::Optional::NO, "the last block covered by the seed block file (inclusive)"},
+           {"path", RPCArg::Type::STR, RPCArg::Optional::NO, "path to the output file. If relative, will be prefixed by datadir."},
+       },
+       RPCResult{
+           RPCResult::Type::OBJ, "", "",
+           {
+               {RPCResult::Type::STR, "network", "the network of the seed blocks"},
+               {RPCResult::Type::NUM, "startblock", "the first block covered by the seed block file"},
+               {RPCResult::Type::NUM, "endblock", "the last block covered by the seed block file"},
+               {RPCResult::Type::NUM, "seedblocks", "the number of blocks containing Omni transactions"},
+               {RPCResult::Type::STR, "path", "the absolute path that the seed blocks were written to"},
+           }
+       },
+       RPCExamples{
+           HelpExampleCli("omni_exportseedblocks", "0 300000 \"seedblocks.dat\"")
+           + HelpExampleRpc("omni_exportseedblocks", "0, 300000, \"seedblocks.dat\"")
+       }
+    }.Check(request);
+
+    int startHeight = request.params[0].get_int();
+    int endHeight = request.params[1].get_int();
+    fs::path path = fs::absolute(request.params[2].get_str(), GetDataDir());
+
+    RequireHeightInChain(startHeight);
+    RequireHeightInChain(endHeight);
+
+    if (startHeight > endHeight) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "End block must be greater than or equal to start block");
+    }
+    if (fs::exists(path)) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, path.string() + " already exists");
+    }
+
+    std::set<int> setSeedBlocks;
+    {
+        LOCK(cs_tally);
+        setSeedBlocks = pDbTransactionList->GetSeedBlocks(startHeight, endHeight);
+    }
+
+    CSeedBlockFilter filter(Params().NetworkIDString(), startHeight, endHeight, setSeedBlocks);
+    if (!filter.WriteFile(path)) {
+        throw JSONRPCError(RPC_INTERNAL_ERROR, "Failed to write " + path.string());
+    }
+
+    UniValue response(UniValue::VOBJ);
+    response.pushKV("network", filter.getNetwork());
+    response.pushKV("startblock", filter.getFirstBlock());
+    response.pushKV("endblock", filter.getLastBlock());
+    response.pushKV("seedblocks", filter.getSeedBlockCount());
+    response.pushKV("path", path.string());
+
+    return response;
+}
+
 // obtain the payload for a transaction
 static UniValue omni_getpayload(const JSONRPCRequest& request)
 {
@@ -876,8 +939,8 @@ static UniValue mscrpc(const JSONRPCRequest& request)
             LOCK(cs_tally);
             int64_t total = 0;
             // display all balances
-            for (std::unordered_map<std::string, CMPTally>::iterator my_it = mp_tally_map.begin(); my_it != mp_tally_map.end(); ++my_it) {
-                PrintToConsole("%34s => ", my_it->first);
+            for (std::unordered_map<uint32_t, CMPTally>::const_iterator my_it = mp_tally_map.begin(); my_it != mp_tally_map.end(); ++my_it) {
+                PrintToConsole("%34s => ", mp_address_table.resolve(my_it->first));
                 total += (my_it->second).print(extra2, bDivisible);
             }
             PrintToConsole("total for property %d  = %X is %s\n", extra2, extra2, FormatDivisibleMP(total));
@@ -901,14 +964,12 @@ static UniValue mscrpc(const JSONRPCRequest& request)
         case 3:
         {
             LOCK(cs_tally);
-            uint32_t id = 0;
             // for each address display all currencies it holds
-            for (std::unordered_map<std::string, CMPTally>::iterator my_it = mp_tally_map.begin(); my_it != mp_tally_map.end(); ++my_it) {
-                PrintToConsole("%34s => ", my_it->first);
+            for (std::unordered_map<uint32_t, CMPTally>::const_iterator my_it = mp_tally_map.begin(); my_it != mp_tally_map.end(); ++my_it) {
+                PrintToConsole("%34s => ", mp_address_table.resolve(my_it->first));
                 (my_it->second).print(extra2);
-                (my_it->second).init();
-                while (0 != (id = (my_it->second).next())) {
-                    PrintToConsole("Id: %u=0x%X ", id, id);
+                for (const CMPTally::BalanceRecord& record : my_it->second) {
+                    PrintToConsole("Id: %u=0x%X ", record.propertyId, record.propertyId);
                 }
                 PrintToConsole("\n");
             }
@@ -1011,6 +1072,13 @@ static UniValue mscrpc(const JSONRPCRequest& request)
 
             break;
         }
+        case 15:
+        {
+            LOCK(cs_tally);
+            // verify the supply of all non-fungible tokens
+            pDbNFT->FullSanityCheck();
+            break;
+        }
         default:
             break;
     }
@@ -1086,20 +1154,13 @@ static UniValue omni_getallbalancesforid(const JSONRPCRequest& request)
 
     LOCK(cs_tally);
 
-    for (std::unordered_map<std::string, CMPTally>::iterator it = mp_tally_map.begin(); it != mp_tally_map.end(); ++it) {
-        uint32_t id = 0;
-        bool includeAddress = false;
-        std::string address = it->first;
-        (it->second).init();
-        while (0 != (id = (it->second).next())) {
-            if (id == propertyId) {
-                includeAddress = true;
-                break;
-            }
-        }
-        if (!includeAddress) {
-            continue; // ignore this address, has never transacted in this propertyId
-        }
+    const CMPHolderIndex::HolderSet* holders = mp_holder_index.getHolders(propertyId);
+    if (!holders) {
+        return response;
+    }
+
+    for (CMPHolderIndex::HolderSet::const_iterator it = holders->begin(); it != holders->end(); ++it) {
+        const std::string& address = mp_address_table.resolve(*it);
         UniValue balanceObj(UniValue::VOBJ);
         balanceObj.pushKV("address", address);
         bool nonEmptyBalance = BalanceToJSON(address, propertyId, balanceObj, isDivisible);
@@ -1112,6 +1173,85 @@ static UniValue omni_getallbalancesforid(const JSONRPCRequest& request)
     return response;
 }
 
+static UniValue omni_listbalancesforid(const JSONRPCRequest& request)
+{
+    RPCHelpMan{"omni_listbalancesforid",
+       "\nReturns a page of token balances for a given currency or property identifier.\n"
+       "\nThe holders are returned in a stable order. If there are more holders, a cursor is returned, which can be used to request the next page. "
+       "Cursors remain valid until the client is restarted.\n",
+       {
+           {"propertyid", RPCArg::Type::NUM, RPCArg::Optional::NO, "the property identifier"},
+           {"count", RPCArg::Type::NUM, /* default */ "1000", "the maximum number of balances to return"},
+           {"cursor", RPCArg::Type::STR, /* default */ "\"\"", "the cursor of the previous page, or empty for the first page"},
+       },
+       RPCResult{
+           RPCResult::Type::OBJ, "", "",
+           {
+               {RPCResult::Type::ARR, "balances", "",
+               {
+                   {RPCResult::Type::OBJ, "", "",
+                   {
+                       {RPCResult::Type::STR, "address", "the address"},
+                       {RPCResult::Type::STR_AMOUNT, "balance", "the available balance of the address"},
+                       {RPCResult::Type::STR_AMOUNT, "reserved", "the amount reserved by sell offers and accepts"},
+                       {RPCResult::Type::STR_AMOUNT, "frozen", "the amount frozen by the issuer (applies to managed properties only)"},
+                   }},
+               }},
+               {RPCResult::Type::STR, "cursor", /* optional */ true, "the cursor of the next page, if there are more holders"},
+           }
+       },
+       RPCExamples{
+           HelpExampleCli("omni_listbalancesforid", "1 1000")
+           + HelpExampleRpc("omni_listbalancesforid", "1, 1000, \"1234\"")
+       }
+    }.Check(request);
+
+    uint32_t propertyId = ParsePropertyId(request.params[0]);
+    int64_t nCount = 1000;
+    if (!request.params[1].isNull()) nCount = request.params[1].get_int64();
+    if (nCount <= 0) throw JSONRPCError(RPC_INVALID_PARAMETER, "Count must be positive");
+    bool fCursor = false;
+    uint32_t cursor = 0;
+    if (!request.params[2].isNull() && !request.params[2].get_str().empty()) {
+        if (!ParseUInt32(request.params[2].get_str(), &cursor)) {
+            throw JSONRPCError(RPC_INVALID_PARAMETER, "Invalid cursor");
+        }
+        fCursor = true;
+    }
+
+    RequireExistingProperty(propertyId);
+
+    UniValue balances(UniValue::VARR);
+    UniValue response(UniValue::VOBJ);
+    bool isDivisible = isPropertyDivisible(propertyId); // we want to check this BEFORE the loop
+
+    LOCK(cs_tally);
+
+    const CMPHolderIndex::HolderSet* holders = mp_holder_index.getHolders(propertyId);
+    if (holders) {
+        // holders are ordered by address handle, continue after the last one of the previous page
+        CMPHolderIndex::HolderSet::const_iterator it = fCursor ? holders->upper_bound(cursor) : holders->begin();
+        for (int64_t n = 0; it != holders->end() && n < nCount; ++it, ++n) {
+            const std::string& address = mp_address_table.resolve(*it);
+            UniValue balanceObj(UniValue::VOBJ);
+            balanceObj.pushKV("address", address);
+            bool nonEmptyBalance = BalanceToJSON(address, propertyId, balanceObj, isDivisible);
+
+            if (nonEmptyBalance) {
+                balances.push_back(balanceObj);
+            }
+            cursor = *it;
+        }
+        if (it != holders->end()) {
+            response.pushKV("cursor", strprintf("%u", cursor));
+        }
+    }
+
+    response.pushKV("balances", balances);
+
+    return response;
+}
+
 static UniValue omni_getallbalancesforaddress(const JSONRPCRequest& request)
 {
     RPCHelpMan{"omni_getallbalancesforaddress",
@@ -1150,10 +1290,8 @@ static UniValue omni_getallbalancesforaddress(const JSONRPCRequest& request)
         throw JSONRPCError(RPC_INVALID_PARAMETER, "Address not found");
     }
 
-    addressTally->init();
-
-    uint32_t propertyId = 0;
-    while (0 != (propertyId = addressTally->next())) {
+    for (const CMPTally::BalanceRecord& record : *addressTally) {
+        uint32_t propertyId = record.propertyId;
         CMPSPInfo::Entry property;
         if (!pDbSpInfo->getSP(propertyId, property)) {
             continue;
@@ -1173,6 +1311,141 @@ static UniValue omni_getallbalancesforaddress(const JSONRPCRequest& request)
     return response;
 }
 
+/** Adds the balances of an address from a tally snapshot, and returns whether they are not empty. */
+static bool SnapshotBalanceToJSON(const CMPTallySnapshot& snapshot, const std::string& address, const CMPTally* tally, uint32_t propertyId, UniValue& balance_obj, bool divisible)
+{
+    int64_t nAvailable = 0;
+    int64_t nReserved = 0;
+    int64_t nFrozen = 0;
+
+    if (tally) {
+        nAvailable = tally->getMoney(propertyId, BALANCE);
+        nReserved = tally->getMoneyReserved(propertyId);
+        if (snapshot.isAddressFrozen(address, propertyId)) {
+            nFrozen = nAvailable;
+        }
+    }
+
+    if (divisible) {
+        balance_obj.pushKV("balance", FormatDivisibleMP(nAvailable));
+        balance_obj.pushKV("reserved", FormatDivisibleMP(nReserved));
+        balance_obj.pushKV("frozen", FormatDivisibleMP(nFrozen));
+    } else {
+        balance_obj.pushKV("balance", FormatIndivisibleMP(nAvailable));
+        balance_obj.pushKV("reserved", FormatIndivisibleMP(nReserved));
+        balance_obj.pushKV("frozen", FormatIndivisibleMP(nFrozen));
+    }
+
+    return (nAvailable || nReserved || nFrozen);
+}
+
+static UniValue omni_getbalances(const JSONRPCRequest& request)
+{
+    RPCHelpMan{"omni_getbalances",
+       "\nReturns the token balances of many addresses as of the latest processed block.\n"
+       "\nThe balances are read from a snapshot of the state, which is taken after each block, so pending amounts are not considered.\n",
+       {
+           {"addresses", RPCArg::Type::ARR, RPCArg::Optional::NO, "a JSON array of addresses",
+                {
+                    {"address", RPCArg::Type::STR, RPCArg::Optional::OMITTED, "the address"},
+                },
+           },
+           {"propertyids", RPCArg::Type::ARR, /* default */ "all properties", "a JSON array of property identifiers",
+                {
+                    {"propertyid", RPCArg::Type::NUM, RPCArg::Optional::OMITTED, "the property identifier"},
+                },
+           },
+       },
+       RPCResult{
+           RPCResult::Type::OBJ, "", "",
+           {
+               {RPCResult::Type::NUM, "block", "the index of the block the balances are consistent with"},
+               {RPCResult::Type::STR_HEX, "blockhash", "the hash of the block the balances are consistent with"},
+               {RPCResult::Type::ARR, "balances", "",
+               {
+                   {RPCResult::Type::OBJ, "", "",
+                   {
+                       {RPCResult::Type::STR, "address", "the address"},
+                       {RPCResult::Type::NUM, "propertyid", "the property identifier"},
+                       {RPCResult::Type::STR_AMOUNT, "balance", "the available balance of the address"},
+                       {RPCResult::Type::STR_AMOUNT, "reserved", "the amount reserved by sell offers and accepts"},
+                       {RPCResult::Type::STR_AMOUNT, "frozen", "the amount frozen by the issuer (applies to managed properties only)"},
+                   }},
+               }},
+           }
+       },
+       RPCExamples{
+           HelpExampleCli("omni_getbalances", "\"[\\\"1EXoDusjGwvnjZUyKkxZ4UHEf77z6A5S4P\\\"]\" \"[1,31]\"")
+           + HelpExampleRpc("omni_getbalances", "[\"1EXoDusjGwvnjZUyKkxZ4UHEf77z6A5S4P\"], [1,31]")
+       }
+    }.Check(request);
+
+    std::vector<std::string> vAddresses;
+    const UniValue& addresses = request.params[0].get_array();
+    for (size_t i = 0; i < addresses.size(); ++i) {
+        vAddresses.push_back(ParseAddress(addresses[i]));
+    }
+
+    // the divisibility is looked up once per property
+    std::map<uint32_t, bool> mapDivisible;
+    bool fAllProperties = request.params[1].isNull();
+    if (!fAllProperties) {
+        const UniValue& propertyIds = request.params[1].get_array();
+        for (size_t i = 0; i < propertyIds.size(); ++i) {
+            uint32_t propertyId = ParsePropertyId(propertyIds[i]);
+            RequireExistingProperty(propertyId);
+            mapDivisible[propertyId] = isPropertyDivisible(propertyId);
+        }
+    }
+
+    std::shared_ptr<const CMPTallySnapshot> snapshot = GetTallySnapshot();
+    if (!snapshot) {
+        throw JSONRPCError(RPC_IN_WARMUP, "Balances are not yet available");
+    }
+
+    UniValue balances(UniValue::VARR);
+    for (const std::string& address : vAddresses) {
+        const CMPTally* tally = snapshot->getTally(address);
+
+        if (!fAllProperties) {
+            for (const auto& entry : mapDivisible) {
+                UniValue balanceObj(UniValue::VOBJ);
+                balanceObj.pushKV("address", address);
+                balanceObj.pushKV("propertyid", (uint64_t) entry.first);
+                SnapshotBalanceToJSON(*snapshot, address, tally, entry.first, balanceObj, entry.second);
+                balances.push_back(balanceObj);
+            }
+            continue;
+        }
+
+        if (!tally) continue;
+
+        for (const CMPTally::BalanceRecord& record : *tally) {
+            uint32_t propertyId = record.propertyId;
+            std::map<uint32_t, bool>::const_iterator it = mapDivisible.find(propertyId);
+            if (it == mapDivisible.end()) {
+                it = mapDivisible.insert(std::make_pair(propertyId, isPropertyDivisible(propertyId))).first;
+            }
+
+            UniValue balanceObj(UniValue::VOBJ);
+            balanceObj.pushKV("address", address);
+            balanceObj.pushKV("propertyid", (uint64_t) propertyId);
+            bool nonEmptyBalance = SnapshotBalanceToJSON(*snapshot, address, tally, propertyId, balanceObj, it->second);
+
+            if (nonEmptyBalance) {
+                balances.push_back(balanceObj);
+            }
+        }
+    }
+
+    UniValue response(UniValue::VOBJ);
+    response.pushKV("block", snapshot->nBlock);
+    response.pushKV("blockhash", snapshot->blockHash.GetHex());
+    response.pushKV("balances", balances);
+
+    return response;
+}
+
 /** Returns all addresses that may be mine. */
 static std::set<std::string> getWalletAddresses(const JSONRPCRequest& request, bool fIncludeWatchOnly)
 {
@@ -1250,10 +1523,8 @@ static UniValue omni_getwalletbalances(const JSONRPCRequest& request)
             continue; // address doesn't have tokens
         }
 
-        uint32_t propertyId = 0;
-        addressTally->init();
-
-        while (0 != (propertyId = addressTally->next())) {
+        for (const CMPTally::BalanceRecord& record : *addressTally) {
+            uint32_t propertyId = record.propertyId;
             int64_t nAvailable = GetAvailableTokenBalance(address, propertyId);
             int64_t nReserved = GetReservedTokenBalance(address, propertyId);
             int64_t nFrozen = GetFrozenTokenBalance(address, propertyId);
@@ -1368,10 +1639,8 @@ static UniValue omni_getwalletaddressbalances(const JSONRPCRequest& request)
         }
 
         UniValue arrBalances(UniValue::VARR);
-        uint32_t propertyId = 0;
-        addressTally->init();
-
-        while (0 != (propertyId = addressTally->next())) {
+        for (const CMPTally::BalanceRecord& record : *addressTally) {
+            uint32_t propertyId = record.propertyId;
             CMPSPInfo::Entry property;
             if (!pDbSpInfo->getSP(propertyId, property)) {
                 continue; // token wasn't found in the DB
@@ -1847,6 +2116,15 @@ static UniValue omni_getgrants(const JSONRPCRequest& request)
     return response;
 }
 
+/** Adds the orders of an order book. */
+static void AddOrderBookObjects(const md_PricesMap& prices, std::vector<CMPMetaDEx>& vecMetaDexObjects)
+{
+    for (md_PricesMap::const_iterator it = prices.begin(); it != prices.end(); ++it) {
+        const md_Set& indexes = it->second;
+        vecMetaDexObjects.insert(vecMetaDexObjects.end(), indexes.begin(), indexes.end());
+    }
+}
+
 static UniValue omni_getorderbook(const JSONRPCRequest& request)
 {
     RPCHelpMan{"omni_getorderbook",
@@ -1900,19 +2178,19 @@ static UniValue omni_getorderbook(const JSONRPCRequest& request)
     std::vector<CMPMetaDEx> vecMetaDexObjects;
     {
         LOCK(cs_tally);
-        for (md_PropertiesMap::const_iterator my_it = metadex.begin(); my_it != metadex.end(); ++my_it) {
-            const md_PricesMap& prices = my_it->second;
-            for (md_PricesMap::const_iterator it = prices.begin(); it != prices.end(); ++it) {
-                const md_Set& indexes = it->second;
-                for (md_Set::const_iterator it = indexes.begin(); it != indexes.end(); ++it) {
-                    const CMPMetaDEx& obj = *it;
-                    if (obj.getProperty() != propertyIdForSale) continue;
-                    if (!filterDesired || obj.getDesProperty() == propertyIdDesired) vecMetaDexObjects.push_back(obj);
-                }
+        if (filterDesired) {
+            const md_PricesMap* prices = get_Prices(propertyIdForSale, propertyIdDesired);
+            if (prices) AddOrderBookObjects(*prices, vecMetaDexObjects);
+        } else {
+            // the order books of a property for sale are adjacent
+            md_PropertiesMap::const_iterator my_it = metadex.lower_bound(md_PropertyPair(propertyIdForSale, 0));
+            for (; my_it != metadex.end() && my_it->first.first == propertyIdForSale; ++my_it) {
+                AddOrderBookObjects(my_it->second, vecMetaDexObjects);
             }
         }
     }
 
+    // sorted by block and position in block, independent of the order books
     UniValue response(UniValue::VARR);
     MetaDexObjectsToJSON(vecMetaDexObjects, response);
     return response;
@@ -1989,23 +2267,20 @@ static UniValue omni_gettradehistoryforaddress(const JSONRPCRequest& request)
         RequireExistingProperty(propertyId);
     }
 
-    // Obtain a sorted vector of txids for the address trade history
+    // Obtain a vector of the most recent count txids for the address trade history
     std::vector<uint256> vecTransactions;
     {
         LOCK(cs_tally);
-        pDbTradeList->getTradesForAddress(address, vecTransactions, propertyId);
+        pDbTradeList->getTradesForAddress(address, vecTransactions, propertyId, count);
     }
 
-    // Populate the address trade history into JSON objects until we have processed count transactions
+    // Populate the address trade history into JSON objects, most recent first
     UniValue response(UniValue::VARR);
-    uint32_t processed = 0;
-    for(std::vector<uint256>::reverse_iterator it = vecTransactions.rbegin(); it != vecTransactions.rend(); ++it) {
+    for (const uint256& txid : vecTransactions) {
         UniValue txobj(UniValue::VOBJ);
-        int populateResult = populateRPCTransactionObject(*it, txobj, "", true, "", pWallet.get());
+        int populateResult = populateRPCTransactionObject(txid, txobj, "", true, "", pWallet.get());
         if (0 == populateResult) {
             response.push_back(txobj);
-            processed++;
-            if (processed >= count) break;
         }
     }
 
@@ -2163,12 +2438,10 @@ static UniValue omni_getactivedexsells(const JSONRPCRequest& request)
         for (AcceptMap::const_iterator ait = my_accepts.begin(); ait != my_accepts.end(); ++ait) {
             UniValue matchedAccept(UniValue::VOBJ);
             const CMPAccept& accept = ait->second;
-            const std::string& acceptCombo = ait->first;
 
             // does this accept match the sell?
             if (accept.getHash() == selloffer.getHash()) {
-                // split acceptCombo out to get the buyer address
-                std::string buyer = acceptCombo.substr((acceptCombo.find("+") + 1), (acceptCombo.size()-(acceptCombo.find("+") + 1)));
+                const std::string& buyer = accept.getBuyer();
                 int blockOfAccept = accept.getAcceptBlock();
                 int blocksLeftToPay = (blockOfAccept + selloffer.getBlockTimeLimit()) - curBlock;
                 int64_t amountAccepted = accept.getAcceptAmountRemaining();
@@ -2488,6 +2761,18 @@ static UniValue omni_getinfo(const JSONRPCRequest& request)
                {RPCResult::Type::NUM, "blocktime", "timestamp of the last processed block"},
                {RPCResult::Type::NUM, "blocktransactions", "Omni transactions found in the last processed block"},
                {RPCResult::Type::NUM, "totaltransactions", "Omni transactions processed in total"},
+               {RPCResult::Type::OBJ, "propertycache", "usage of the cache of property entries",
+               {
+                   {RPCResult::Type::NUM, "hits", "lookups served from the cache"},
+                   {RPCResult::Type::NUM, "misses", "lookups loaded from the database"},
+               }},
+               {RPCResult::Type::OBJ, "inputcache", "usage of the cache of transaction inputs",
+               {
+                   {RPCResult::Type::NUM, "size", "number of cached inputs"},
+                   {RPCResult::Type::NUM, "hits", "lookups served from the cache"},
+                   {RPCResult::Type::NUM, "misses", "lookups resolved from block data or the transaction index"},
+                   {RPCResult::Type::NUM, "evictions", "inputs evicted from the cache"},
+               }},
                {RPCResult::Type::ARR, "alerts", "active protocol alert (if any)",
                {
                    {RPCResult::Type::OBJ, "", "",
@@ -2532,6 +2817,28 @@ static UniValue omni_getinfo(const JSONRPCRequest& request)
     // provide the number of transactions parsed
     infoResponse.pushKV("totaltransactions", totalMPTransactions);
 
+    // provide the usage of the property cache
+    uint64_t nPropertyCacheHits = 0;
+    uint64_t nPropertyCacheMisses = 0;
+    pDbSpInfo->getCacheStats(nPropertyCacheHits, nPropertyCacheMisses);
+    UniValue propertyCache(UniValue::VOBJ);
+    propertyCache.pushKV("hits", nPropertyCacheHits);
+    propertyCache.pushKV("misses", nPropertyCacheMisses);
+    infoResponse.pushKV("propertycache", propertyCache);
+
+    // provide the usage of the input cache
+    uint64_t nInputCacheSize = 0;
+    uint64_t nInputCacheHits = 0;
+    uint64_t nInputCacheMisses = 0;
+    uint64_t nInputCacheEvictions = 0;
+    GetInputCacheStats(nInputCacheSize, nInputCacheHits, nInputCacheMisses, nInputCacheEvictions);
+    UniValue inputCache(UniValue::VOBJ);
+    inputCache.pushKV("size", nInputCacheSize);
+    inputCache.pushKV("hits", nInputCacheHits);
+    inputCache.pushKV("misses", nInputCacheMisses);
+    inputCache.pushKV("evictions", nInputCacheEvictions);
+    infoResponse.pushKV("inputcache", inputCache);
+
     // handle alerts
     UniValue alerts(UniValue::VARR);
     std::vector<AlertData> omniAlerts = GetOmniCoreAlerts();
@@ -2895,12 +3202,15 @@ static const CRPCCommand commands[] =
     { "omni layer (data retrieval)", "omni_listblocktransactions",     &omni_listblocktransactions,      {"index"} },
     { "omni layer (data retrieval)", "omni_listblockstransactions",    &omni_listblockstransactions,     {"firstblock", "lastblock"} },
     { "omni layer (data retrieval)", "omni_listpendingtransactions",   &omni_listpendingtransactions,    {"address"} },
+    { "omni layer (data retrieval)", "omni_listbalancesforid",         &omni_listbalancesforid,          {"propertyid", "count", "cursor"} },
     { "omni layer (data retrieval)", "omni_getallbalancesforaddress",  &omni_getallbalancesforaddress,   {"address"} },
+    { "omni layer (data retrieval)", "omni_getbalances",               &omni_getbalances,                {"addresses", "propertyids"} },
     { "omni layer (data retrieval)", "omni_gettradehistoryforaddress", &omni_gettradehistoryforaddress,  {"address", "count", "propertyid"} },
     { "omni layer (data retrieval)", "omni_gettradehistoryforpair",    &omni_gettradehistoryforpair,     {"propertyid", "propertyidsecond", "count"} },
     { "omni layer (data retrieval)", "omni_getcurrentconsensushash",   &omni_getcurrentconsensushash,    {} },
     { "omni layer (data retrieval)", "omni_getpayload",                &omni_getpayload,                 {"txid"} },
     { "omni layer (data retrieval)", "omni_getseedblocks",             &omni_getseedblocks,              {"startblock", "endblock"} },
+    { "omni layer (data retrieval)", "omni_exportseedblocks",          &omni_exportseedblocks,           {"startblock", "endblock", "path"} },
     { "omni layer (data retrieval)", "omni_getmetadexhash",            &omni_getmetadexhash,             {"propertyid"} },
     { "omni layer (data retrieval)", "omni_getfeecache",               &omni_getfeecache,                {"propertyid"} },
     { "omni layer (data retrieval)", "omni_getfeetrigger",             &omni_getfeetrigger,              {"propertyid"} },
@@ -32,8 +32,6 @@
 
 #include <univalue.h>
 
-#include <boost/algorithm/string.hpp>
-#include <boost/lexical_cast.hpp>
 
 #include <stdint.h>
 #include <string>
@@ -728,17 +726,14 @@ void populateRPCExtendedTypeMetaDExCancel(const uint256& txid, UniValue& txobj)
     if (0<numberOfCancels) {
         for(int refNumber = 1; refNumber <= numberOfCancels; refNumber++) {
             UniValue cancelTx(UniValue::VOBJ);
-            std::string strValue = pDbTransactionList->getKeyValue(txid.ToString() + "-C" + strprintf("%d",refNumber));
-            if (strValue.empty()) continue;
-            std::vector<std::string> vstr;
-            boost::split(vstr, strValue, boost::is_any_of(":"), boost::token_compress_on);
-            if (vstr.size() != 3) {
-                PrintToLog("TXListDB Error - trade cancel number of tokens is not as expected (%s)\n", strValue);
+            uint256 cancelledTxid;
+            uint32_t propId = 0;
+            int64_t amountUnreserved = 0;
+            if (!pDbTransactionList->getMetaDExCancelDetails(txid, refNumber, cancelledTxid, propId, amountUnreserved)) {
+                PrintToLog("TXListDB Error - trade cancel %s-C%d not found\n", txid.ToString(), refNumber);
                 continue;
             }
-            uint32_t propId = boost::lexical_cast<uint32_t>(vstr[1]);
-            int64_t amountUnreserved = boost::lexical_cast<int64_t>(vstr[2]);
-            cancelTx.pushKV("txid", vstr[0]);
+            cancelTx.pushKV("txid", cancelledTxid.GetHex());
             cancelTx.pushKV("propertyid", (uint64_t) propId);
             cancelTx.pushKV("amountunreserved", FormatMP(propId, amountUnreserved));
             cancelArray.push_back(cancelTx);
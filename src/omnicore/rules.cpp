@@ -19,10 +19,13 @@
 #include <validation.h>
 #include <script/standard.h>
 #include <uint256.h>
+#include <sync.h>
 #include <ui_interface.h>
 
 #include <stdint.h>
+#include <atomic>
 #include <limits>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -284,10 +287,175 @@ static CTestNetConsensusParams testNetConsensusParams;
 //! Consensus parameters for regtest mode
 static CRegTestConsensusParams regTestConsensusParams;
 
+/**
+ * Returns the activation block of a feature, or false, if the feature is unknown.
+ */
+static bool GetFeatureActivationBlock(const CConsensusParams& params, uint16_t featureId, int& activationBlock)
+{
+    switch (featureId) {
+        case FEATURE_CLASS_C:
+            activationBlock = params.NULLDATA_BLOCK;
+            break;
+        case FEATURE_METADEX:
+            activationBlock = params.MSC_METADEX_BLOCK;
+            break;
+        case FEATURE_BETTING:
+            activationBlock = params.MSC_BET_BLOCK;
+            break;
+        case FEATURE_GRANTEFFECTS:
+            activationBlock = params.GRANTEFFECTS_FEATURE_BLOCK;
+            break;
+        case FEATURE_DEXMATH:
+            activationBlock = params.DEXMATH_FEATURE_BLOCK;
+            break;
+        case FEATURE_SENDALL:
+            activationBlock = params.MSC_SEND_ALL_BLOCK;
+            break;
+        case FEATURE_SPCROWDCROSSOVER:
+            activationBlock = params.SPCROWDCROSSOVER_FEATURE_BLOCK;
+            break;
+        case FEATURE_TRADEALLPAIRS:
+            activationBlock = params.TRADEALLPAIRS_FEATURE_BLOCK;
+            break;
+        case FEATURE_FEES:
+            activationBlock = params.FEES_FEATURE_BLOCK;
+            break;
+        case FEATURE_STOV1:
+            activationBlock = params.MSC_STOV1_BLOCK;
+            break;
+        case FEATURE_XEP_CROWDSALES:
+            activationBlock = params.FEES_FEATURE_BLOCK;
+            break;
+        case FEATURE_FREEZENOTICE:
+            activationBlock = params.FREEZENOTICE_FEATURE_BLOCK;
+        break;
+        case FEATURE_FREEDEX:
+            activationBlock = params.FREEDEX_FEATURE_BLOCK;
+        break;
+        case FEATURE_NONFUNGIBLE:
+            activationBlock = params.MSC_NONFUNGIBLE_BLOCK;
+        break;
+        case FEATURE_DELEGATEDISSUANCE:
+            activationBlock = params.MSC_DELEGATED_ISSUANCE_BLOCK;
+        break;
+        default:
+            return false;
+    }
+
+    return true;
+}
+
+/**
+ * Activation blocks of features and transaction types, precomputed from the
+ * consensus parameters, so they can be looked up without scanning.
+ *
+ * Tables are immutable, once published.
+ */
+struct ActivationTable
+{
+    //! Number of feature identifiers covered
+    static const size_t MAX_FEATURES = 32;
+    //! Number of transaction types and versions covered by the lookup array
+    static const size_t MAX_TYPES = 256;
+    static const size_t MAX_VERSIONS = 4;
+
+    //! The consensus parameters the table was built from
+    const CConsensusParams* pParams;
+
+    //! Whether a feature is known, and the block at which it is enabled
+    bool fFeatureKnown[MAX_FEATURES];
+    int nFeatureBlock[MAX_FEATURES];
+
+    //! Whether a transaction type and version is known, and its restriction
+    bool fRestrictionKnown[MAX_TYPES][MAX_VERSIONS];
+    TransactionRestriction restrictions[MAX_TYPES][MAX_VERSIONS];
+    //! Restrictions of types and versions not covered by the lookup array
+    std::vector<TransactionRestriction> vOtherRestrictions;
+
+    explicit ActivationTable(const CConsensusParams& params) : pParams(&params)
+    {
+        for (size_t n = 0; n < MAX_FEATURES; ++n) {
+            nFeatureBlock[n] = std::numeric_limits<int>::max();
+            fFeatureKnown[n] = GetFeatureActivationBlock(params, n, nFeatureBlock[n]);
+        }
+
+        for (size_t type = 0; type < MAX_TYPES; ++type) {
+            for (size_t version = 0; version < MAX_VERSIONS; ++version) {
+                fRestrictionKnown[type][version] = false;
+            }
+        }
+        for (const TransactionRestriction& entry : params.GetRestrictions()) {
+            if (entry.txType < MAX_TYPES && entry.txVersion < MAX_VERSIONS) {
+                fRestrictionKnown[entry.txType][entry.txVersion] = true;
+                restrictions[entry.txType][entry.txVersion] = entry;
+            } else {
+                vOtherRestrictions.push_back(entry);
+            }
+        }
+    }
+
+    /** Returns the restriction of a transaction type and version, or nullptr, if it's unknown. */
+    const TransactionRestriction* GetRestriction(uint16_t txType, uint16_t version) const
+    {
+        if (txType < MAX_TYPES && version < MAX_VERSIONS) {
+            return fRestrictionKnown[txType][version] ? &restrictions[txType][version] : nullptr;
+        }
+        // only alerts, activations and deactivations end up here
+        for (const TransactionRestriction& entry : vOtherRestrictions) {
+            if (entry.txType == txType && entry.txVersion == version) {
+                return &entry;
+            }
+        }
+        return nullptr;
+    }
+};
+
+//! Guards the construction of activation tables
+static Mutex cs_activation_table;
+//! The currently published activation table, or nullptr, if it must be rebuilt
+static std::atomic<const ActivationTable*> pActivationTable(nullptr);
+//! All tables ever published
+//!
+//! Readers don't hold a lock, so tables are never freed. A new one is only built
+//! after the consensus parameters were changed, which is rare.
+static std::vector<std::unique_ptr<const ActivationTable> > vActivationTables GUARDED_BY(cs_activation_table);
+
+/**
+ * Builds and publishes an activation table for the currently active consensus parameters.
+ */
+static const ActivationTable* PublishActivationTable()
+{
+    LOCK(cs_activation_table);
+
+    const CConsensusParams& params = ConsensusParams();
+    vActivationTables.emplace_back(new ActivationTable(params));
+    const ActivationTable* pTable = vActivationTables.back().get();
+    pActivationTable.store(pTable, std::memory_order_release);
+
+    return pTable;
+}
+
+/**
+ * Returns the activation table for the currently active consensus parameters.
+ *
+ * A new table is built, if the parameters were changed, or if another network
+ * was selected.
+ */
+static const ActivationTable& GetActivationTable()
+{
+    const ActivationTable* pTable = pActivationTable.load(std::memory_order_acquire);
+
+    if (!pTable || pTable->pParams != &ConsensusParams()) {
+        pTable = PublishActivationTable();
+    }
+
+    return *pTable;
+}
+
 /**
  * Returns consensus parameters for the given network.
  */
-CConsensusParams& ConsensusParams(const std::string& network)
+static CConsensusParams& GetNetworkConsensusParams(const std::string& network)
 {
     if (network == "main") {
         return mainConsensusParams;
@@ -302,6 +470,19 @@ CConsensusParams& ConsensusParams(const std::string& network)
     return mainConsensusParams;
 }
 
+/**
+ * Returns consensus parameters for the given network.
+ *
+ * The parameters may be modified, so the activation table is rebuilt, once
+ * they are used again.
+ */
+CConsensusParams& ConsensusParams(const std::string& network)
+{
+    pActivationTable.store(nullptr, std::memory_order_release);
+
+    return GetNetworkConsensusParams(network);
+}
+
 /**
  * Returns currently active consensus parameter.
  */
@@ -309,7 +490,7 @@ const CConsensusParams& ConsensusParams()
 {
     const std::string& network = Params().NetworkIDString();
 
-    return ConsensusParams(network);
+    return GetNetworkConsensusParams(network);
 }
 
 /**
@@ -330,6 +511,8 @@ void ResetConsensusParams()
     mainConsensusParams = CMainConsensusParams();
     testNetConsensusParams = CTestNetConsensusParams();
     regTestConsensusParams = CRegTestConsensusParams();
+
+    PublishActivationTable();
 }
 
 /**
@@ -468,6 +651,8 @@ bool ActivateFeature(uint16_t featureId, int activationBlock, uint32_t minClient
         break;
     }
 
+    PublishActivationTable();
+
     PrintToLog("Feature activation of ID %d processed. %s will be enabled at block %d.\n", featureId, featureName, activationBlock);
     AddPendingActivation(featureId, activationBlock, minClientVersion, featureName);
 
@@ -548,6 +733,8 @@ bool DeactivateFeature(uint16_t featureId, int transactionBlock)
         break;
     }
 
+    PublishActivationTable();
+
     PrintToLog("Feature deactivation of ID %d processed. %s has been disabled.\n", featureId, featureName);
 
     std::string alertText = strprintf("An emergency deactivation of feature ID %d (%s) has occurred.", featureId, featureName);
@@ -588,60 +775,13 @@ std::string GetFeatureName(uint16_t featureId)
  */
 bool IsFeatureActivated(uint16_t featureId, int transactionBlock)
 {
-    const CConsensusParams& params = ConsensusParams();
-    int activationBlock = std::numeric_limits<int>::max();
+    const ActivationTable& table = GetActivationTable();
 
-    switch (featureId) {
-        case FEATURE_CLASS_C:
-            activationBlock = params.NULLDATA_BLOCK;
-            break;
-        case FEATURE_METADEX:
-            activationBlock = params.MSC_METADEX_BLOCK;
-            break;
-        case FEATURE_BETTING:
-            activationBlock = params.MSC_BET_BLOCK;
-            break;
-        case FEATURE_GRANTEFFECTS:
-            activationBlock = params.GRANTEFFECTS_FEATURE_BLOCK;
-            break;
-        case FEATURE_DEXMATH:
-            activationBlock = params.DEXMATH_FEATURE_BLOCK;
-            break;
-        case FEATURE_SENDALL:
-            activationBlock = params.MSC_SEND_ALL_BLOCK;
-            break;
-        case FEATURE_SPCROWDCROSSOVER:
-            activationBlock = params.SPCROWDCROSSOVER_FEATURE_BLOCK;
-            break;
-        case FEATURE_TRADEALLPAIRS:
-            activationBlock = params.TRADEALLPAIRS_FEATURE_BLOCK;
-            break;
-        case FEATURE_FEES:
-            activationBlock = params.FEES_FEATURE_BLOCK;
-            break;
-        case FEATURE_STOV1:
-            activationBlock = params.MSC_STOV1_BLOCK;
-            break;
-        case FEATURE_XEP_CROWDSALES:
-            activationBlock = params.FEES_FEATURE_BLOCK;
-            break;
-        case FEATURE_FREEZENOTICE:
-            activationBlock = params.FREEZENOTICE_FEATURE_BLOCK;
-        break;
-        case FEATURE_FREEDEX:
-            activationBlock = params.FREEDEX_FEATURE_BLOCK;
-        break;
-        case FEATURE_NONFUNGIBLE:
-            activationBlock = params.MSC_NONFUNGIBLE_BLOCK;
-        break;
-        case FEATURE_DELEGATEDISSUANCE:
-            activationBlock = params.MSC_DELEGATED_ISSUANCE_BLOCK;
-        break;
-        default:
-            return false;
+    if (featureId >= ActivationTable::MAX_FEATURES || !table.fFeatureKnown[featureId]) {
+        return false;
     }
 
-    return (transactionBlock >= activationBlock);
+    return (transactionBlock >= table.nFeatureBlock[featureId]);
 }
 
 /**
@@ -655,28 +795,22 @@ bool IsFeatureActivated(uint16_t featureId, int transactionBlock)
  */
 bool IsTransactionTypeAllowed(int txBlock, uint32_t txProperty, uint16_t txType, uint16_t version)
 {
-    const std::vector<TransactionRestriction>& vTxRestrictions = ConsensusParams().GetRestrictions();
+    const ActivationTable& table = GetActivationTable();
+    const TransactionRestriction* entry = table.GetRestriction(txType, version);
 
-    for (std::vector<TransactionRestriction>::const_iterator it = vTxRestrictions.begin(); it != vTxRestrictions.end(); ++it)
-    {
-        const TransactionRestriction& entry = *it;
-        if (entry.txType != txType || entry.txVersion != version) {
-            continue;
-        }
-        // a property identifier of 0 (= XEP) may be used as wildcard
-        if (OMNI_PROPERTY_XEP == txProperty && !entry.allowWildcard) {
-            continue;
-        }
-        // transactions are not restricted in the test ecosystem
-        if (isTestEcosystemProperty(txProperty)) {
-            return true;
-        }
-        if (txBlock >= entry.activationBlock) {
-            return true;
-        }
+    if (!entry) {
+        return false;
+    }
+    // a property identifier of 0 (= XEP) may be used as wildcard
+    if (OMNI_PROPERTY_XEP == txProperty && !entry->allowWildcard) {
+        return false;
+    }
+    // transactions are not restricted in the test ecosystem
+    if (isTestEcosystemProperty(txProperty)) {
+        return true;
     }
 
-    return false;
+    return (txBlock >= entry->activationBlock);
 }
 
 /**
@@ -3,19 +3,103 @@
 #include <omnicore/log.h>
 
 #include <chainparams.h>
-#include <util/time.h>
-
-#include <boost/algorithm/string.hpp>
-#include <boost/lexical_cast.hpp>
+#include <clientversion.h>
+#include <streams.h>
+#include <util/system.h>
 
 #include <stdint.h>
+#include <exception>
+#include <memory>
 #include <set>
 #include <string>
 #include <vector>
 
 const int MAX_SEED_BLOCK = 490000;
 
-static std::set<int> GetBlockList()
+//! Seed blocks of the current network, selected by InitSeedBlockFilter()
+static std::unique_ptr<const CSeedBlockFilter> pSeedBlockFilter;
+
+CSeedBlockFilter::CSeedBlockFilter()
+  : nFirstBlock(0), nLastBlock(-1)
+{
+}
+
+CSeedBlockFilter::CSeedBlockFilter(const std::string& network, int firstBlock, int lastBlock, const std::set<int>& seedBlocks)
+  : strNetwork(network), nFirstBlock(firstBlock), nLastBlock(lastBlock)
+{
+    if (nLastBlock < nFirstBlock) {
+        nLastBlock = nFirstBlock - 1;
+        return;
+    }
+
+    vBitmap.resize((nLastBlock - nFirstBlock) / 8 + 1);
+    for (std::set<int>::const_iterator it = seedBlocks.begin(); it != seedBlocks.end(); ++it) {
+        if (!Covers(*it)) continue;
+        const unsigned int nBit = *it - nFirstBlock;
+        vBitmap[nBit / 8] |= (1 << (nBit % 8));
+    }
+}
+
+int CSeedBlockFilter::getSeedBlockCount() const
+{
+    int nCount = 0;
+    for (std::vector<unsigned char>::const_iterator it = vBitmap.begin(); it != vBitmap.end(); ++it) {
+        for (unsigned char nByte = *it; nByte; nByte &= (nByte - 1)) {
+            ++nCount;
+        }
+    }
+
+    return nCount;
+}
+
+bool CSeedBlockFilter::WriteFile(const fs::path& path) const
+{
+    CAutoFile file(fsbridge::fopen(path, "wb"), SER_DISK, CLIENT_VERSION);
+    if (file.IsNull()) {
+        PrintToLog("%s(): failed to open %s\n", __func__, path.string());
+        return false;
+    }
+
+    try {
+        file << *this;
+    } catch (const std::exception& e) {
+        PrintToLog("%s(): failed to write %s: %s\n", __func__, path.string(), e.what());
+        return false;
+    }
+
+    return true;
+}
+
+bool CSeedBlockFilter::ReadFile(const fs::path& path)
+{
+    *this = CSeedBlockFilter();
+
+    CAutoFile file(fsbridge::fopen(path, "rb"), SER_DISK, CLIENT_VERSION);
+    if (file.IsNull()) {
+        PrintToLog("%s(): failed to open %s\n", __func__, path.string());
+        return false;
+    }
+
+    try {
+        file >> *this;
+    } catch (const std::exception& e) {
+        PrintToLog("%s(): failed to read %s: %s\n", __func__, path.string(), e.what());
+        *this = CSeedBlockFilter();
+        return false;
+    }
+
+    // the range must start at a valid block, and the bitmap must cover the whole range
+    if (nFirstBlock < 0 || nLastBlock < nFirstBlock || vBitmap.size() != static_cast<uint64_t>(int64_t(nLastBlock) - nFirstBlock) / 8 + 1) {
+        PrintToLog("%s(): invalid seed block range in %s\n", __func__, path.string());
+        *this = CSeedBlockFilter();
+        return false;
+    }
+
+    return true;
+}
+
+/** Returns the built-in seed blocks of mainnet. */
+static CSeedBlockFilter GetMainnetSeedBlocks()
 {
     int blocks[] = {249498, 249536, 249559, 249560, 249571, 249590, 249595, 249601, 249603, 249611, 249638, 249639, 249682, 249689, 249704,
                     249716, 249731, 249757, 249763, 249895, 249998, 250039, 250243, 250364, 250471, 250771, 250779, 250780, 250836, 250850,
@@ -5510,23 +5594,49 @@ static std::set<int> GetBlockList()
                     489970, 489971, 489972, 489974, 489975, 489976, 489977, 489978, 489980, 489981, 489982, 489983, 489984, 489985, 489986,
                     489987, 489988, 489990, 489991, 489992, 489993, 489994, 489995, 489996, 489997, 489998, 489999, 490000};
 
-    PrintToLog("Seed block filter active - %d blocks will be parsed during initial scan.\n", sizeof(blocks)/sizeof(blocks[0]));
-
-    return std::set<int>(blocks, blocks + sizeof(blocks)/sizeof(blocks[0]));
+    return CSeedBlockFilter("main", 0, MAX_SEED_BLOCK, std::set<int>(blocks, blocks + sizeof(blocks)/sizeof(blocks[0])));
 }
 
-bool SkipBlock(int nBlock)
+/**
+ * Selects the seed blocks of the current network.
+ *
+ * A filter exported with "omni_exportseedblocks" can be provided via startup
+ * option "--omniseedblockfile=/path/to/seedblocks.dat". Otherwise the built-in
+ * seed blocks are used on mainnet, and all blocks are scanned on other networks.
+ */
+void InitSeedBlockFilter()
 {
-    static std::set<int> blockList = GetBlockList();
+    const std::string& strNetwork = Params().NetworkIDString();
+    std::unique_ptr<CSeedBlockFilter> filter(new CSeedBlockFilter());
 
-    // Scan all non mainnet blocks:
-    if (Params().NetworkIDString() != "main") {
-        return false;
+    std::string strSeedBlockFile = gArgs.GetArg("-omniseedblockfile", "");
+    if (!strSeedBlockFile.empty()) {
+        fs::path pathSeedBlockFile = fs::absolute(strSeedBlockFile, GetDataDir());
+        if (!filter->ReadFile(pathSeedBlockFile)) {
+            PrintToLog("Failed to load seed blocks from %s\n", pathSeedBlockFile.string());
+        } else if (filter->getNetwork() != strNetwork) {
+            PrintToLog("Seed blocks in %s are for network %s, not for %s\n", pathSeedBlockFile.string(), filter->getNetwork(), strNetwork);
+            filter.reset(new CSeedBlockFilter());
+        }
+    }
+    if (filter->getNetwork().empty() && strNetwork == "main") {
+        filter.reset(new CSeedBlockFilter(GetMainnetSeedBlocks()));
+    }
+
+    if (!filter->getNetwork().empty()) {
+        PrintToLog("Seed block filter active - %d of blocks %d to %d will be parsed during initial scan.\n",
+                filter->getSeedBlockCount(), filter->getFirstBlock(), filter->getLastBlock());
     }
-    // Scan all blocks, which are not in the list:
-    if (nBlock > MAX_SEED_BLOCK) {
+
+    pSeedBlockFilter.reset(filter.release());
+}
+
+bool SkipBlock(int nBlock)
+{
+    // Scan all blocks, if there is no filter, or the block is not covered:
+    if (!pSeedBlockFilter || !pSeedBlockFilter->Covers(nBlock)) {
         return false;
     }
-    // Otherwise check, if the block is in the list:
-    return (blockList.find(nBlock) == blockList.end());
+    // Otherwise check, if the block is a seed block:
+    return !pSeedBlockFilter->IsSeedBlock(nBlock);
 }
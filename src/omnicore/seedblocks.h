@@ -1,6 +1,72 @@
 #ifndef XEP_OMNICORE_SEEDBLOCKS_H
 #define XEP_OMNICORE_SEEDBLOCKS_H
 
+#include <fs.h>
+#include <serialize.h>
+
+#include <set>
+#include <string>
+#include <vector>
+
+/** Bitmap of the blocks with Omni transactions within a range of blocks.
+ */
+class CSeedBlockFilter
+{
+private:
+    //! The network of the blocks
+    std::string strNetwork;
+    //! The first block covered by the filter
+    int nFirstBlock;
+    //! The last block covered by the filter
+    int nLastBlock;
+    //! One bit per covered block, set for seed blocks
+    std::vector<unsigned char> vBitmap;
+
+public:
+    CSeedBlockFilter();
+    CSeedBlockFilter(const std::string& network, int firstBlock, int lastBlock, const std::set<int>& seedBlocks);
+
+    const std::string& getNetwork() const { return strNetwork; }
+    int getFirstBlock() const { return nFirstBlock; }
+    int getLastBlock() const { return nLastBlock; }
+
+    /** Returns the number of seed blocks. */
+    int getSeedBlockCount() const;
+
+    /** Checks, whether the block is within the range of the filter. */
+    bool Covers(int nBlock) const
+    {
+        return nBlock >= nFirstBlock && nBlock <= nLastBlock;
+    }
+
+    /** Checks, whether the block is a seed block. */
+    bool IsSeedBlock(int nBlock) const
+    {
+        if (!Covers(nBlock)) return false;
+        const unsigned int nBit = nBlock - nFirstBlock;
+        return (vBitmap[nBit / 8] >> (nBit % 8)) & 1;
+    }
+
+    /** Writes the filter to a file. */
+    bool WriteFile(const fs::path& path) const;
+    /** Reads the filter from a file. */
+    bool ReadFile(const fs::path& path);
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action) {
+        READWRITE(strNetwork);
+        READWRITE(nFirstBlock);
+        READWRITE(nLastBlock);
+        READWRITE(vBitmap);
+    }
+};
+
+/** Selects the seed blocks of the current network, or of the file set by "-omniseedblockfile". */
+void InitSeedBlockFilter();
+
+/** Checks, whether the block can be skipped, because it has no Omni transactions. */
 bool SkipBlock(int nBlock);
 
 
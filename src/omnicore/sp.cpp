@@ -19,7 +19,9 @@
 
 #include <stdint.h>
 
+#include <algorithm>
 #include <map>
+#include <set>
 #include <string>
 #include <vector>
 #include <utility>
@@ -92,6 +94,41 @@ void CMPCrowd::saveCrowdSale(std::ofstream& file, const std::string& addr, CHash
     file << lineOut << std::endl;
 }
 
+std::pair<CrowdMap::iterator, bool> CrowdMap::insert(const std::pair<std::string, CMPCrowd>& entry)
+{
+    std::pair<iterator, bool> result = mapCrowds.insert(entry);
+    if (result.second) {
+        setDeadlines.insert(std::make_pair(entry.second.getDeadline(), entry.first));
+    }
+
+    return result;
+}
+
+void CrowdMap::erase(iterator it)
+{
+    setDeadlines.erase(std::make_pair(it->second.getDeadline(), it->first));
+    mapCrowds.erase(it);
+}
+
+void CrowdMap::clear()
+{
+    mapCrowds.clear();
+    setDeadlines.clear();
+}
+
+std::vector<std::string> CrowdMap::getExpired(int64_t blockTime) const
+{
+    std::vector<std::string> vAddresses;
+    for (std::set<std::pair<int64_t, std::string> >::const_iterator it = setDeadlines.begin(); it != setDeadlines.end(); ++it) {
+        if (it->first >= blockTime) break;
+        vAddresses.push_back(it->second);
+    }
+    // keep the order of the issuers, in which expired crowdsales were always processed
+    std::sort(vAddresses.begin(), vAddresses.end());
+
+    return vAddresses;
+}
+
 CMPCrowd* mastercore::getCrowd(const std::string& address)
 {
     CrowdMap::iterator my_it = my_crowds.find(address);
@@ -400,46 +437,47 @@ unsigned int mastercore::eraseExpiredCrowdsale(const CBlockIndex* pBlockIndex)
     const int64_t blockTime = pBlockIndex->GetBlockTime();
     const int blockHeight = pBlockIndex->nHeight;
     unsigned int how_many_erased = 0;
-    CrowdMap::iterator my_it = my_crowds.begin();
 
-    while (my_crowds.end() != my_it) {
+    // only the crowdsales with a deadline before this block are visited
+    const std::vector<std::string> vExpired = my_crowds.getExpired(blockTime);
+
+    for (std::vector<std::string>::const_iterator it = vExpired.begin(); it != vExpired.end(); ++it) {
+        CrowdMap::iterator my_it = my_crowds.find(*it);
+        assert(my_it != my_crowds.end());
         const std::string& address = my_it->first;
         const CMPCrowd& crowdsale = my_it->second;
 
-        if (blockTime > crowdsale.getDeadline()) {
-            PrintToLog("%s(): ERASING EXPIRED CROWDSALE from address=%s, at block %d (timestamp: %d), SP: %d (%s)\n",
-                __func__, address, blockHeight, blockTime, crowdsale.getPropertyId(), strMPProperty(crowdsale.getPropertyId()));
-
-            if (msc_debug_sp) {
-                PrintToLog("%s(): %s\n", __func__, FormatISO8601DateTime(blockTime));
-                PrintToLog("%s(): %s\n", __func__, crowdsale.toString(address));
-            }
+        PrintToLog("%s(): ERASING EXPIRED CROWDSALE from address=%s, at block %d (timestamp: %d), SP: %d (%s)\n",
+            __func__, address, blockHeight, blockTime, crowdsale.getPropertyId(), strMPProperty(crowdsale.getPropertyId()));
 
-            // get sp from data struct
-            CMPSPInfo::Entry sp;
-            assert(pDbSpInfo->getSP(crowdsale.getPropertyId(), sp));
+        if (msc_debug_sp) {
+            PrintToLog("%s(): %s\n", __func__, FormatISO8601DateTime(blockTime));
+            PrintToLog("%s(): %s\n", __func__, crowdsale.toString(address));
+        }
 
-            // find missing tokens
-            int64_t missedTokens = GetMissedIssuerBonus(sp, crowdsale);
+        // get sp from data struct
+        CMPSPInfo::Entry sp;
+        assert(pDbSpInfo->getSP(crowdsale.getPropertyId(), sp));
 
-            // get txdata
-            sp.historicalData = crowdsale.getDatabase();
-            sp.missedTokens = missedTokens;
+        // find missing tokens
+        int64_t missedTokens = GetMissedIssuerBonus(sp, crowdsale);
 
-            // update SP with this data
-            sp.update_block = pBlockIndex->GetBlockHash();
-            assert(pDbSpInfo->updateSP(crowdsale.getPropertyId(), sp));
+        // get txdata
+        sp.historicalData = crowdsale.getDatabase();
+        sp.missedTokens = missedTokens;
 
-            // update values
-            if (missedTokens > 0) {
-                assert(update_tally_map(sp.issuer, crowdsale.getPropertyId(), missedTokens, BALANCE));
-            }
+        // update SP with this data
+        sp.update_block = pBlockIndex->GetBlockHash();
+        assert(pDbSpInfo->updateSP(crowdsale.getPropertyId(), sp));
 
-            my_crowds.erase(my_it++);
+        // update values
+        if (missedTokens > 0) {
+            assert(update_tally_map(sp.issuer, crowdsale.getPropertyId(), missedTokens, BALANCE));
+        }
 
-            ++how_many_erased;
+        my_crowds.erase(my_it);
 
-        } else my_it++;
+        ++how_many_erased;
     }
 
     return how_many_erased;
@@ -14,6 +14,7 @@ class uint256;
 
 #include <fstream>
 #include <map>
+#include <set>
 #include <string>
 #include <utility>
 #include <vector>
@@ -66,7 +67,40 @@ public:
 
 namespace mastercore
 {
-typedef std::map<std::string, CMPCrowd> CrowdMap;
+/**
+ * In-memory collection of active crowdsales, keyed by issuer.
+ *
+ * Crowdsales are additionally indexed by their deadline, so that only the
+ * expired crowdsales need to be visited at the end of a block.
+ */
+class CrowdMap
+{
+public:
+    typedef std::map<std::string, CMPCrowd>::iterator iterator;
+    typedef std::map<std::string, CMPCrowd>::const_iterator const_iterator;
+
+private:
+    std::map<std::string, CMPCrowd> mapCrowds;
+    //! Issuers of the crowdsales, ordered by deadline
+    std::set<std::pair<int64_t, std::string> > setDeadlines;
+
+public:
+    iterator begin() { return mapCrowds.begin(); }
+    iterator end() { return mapCrowds.end(); }
+    const_iterator begin() const { return mapCrowds.begin(); }
+    const_iterator end() const { return mapCrowds.end(); }
+
+    iterator find(const std::string& address) { return mapCrowds.find(address); }
+    const_iterator find(const std::string& address) const { return mapCrowds.find(address); }
+    size_t size() const { return mapCrowds.size(); }
+
+    std::pair<iterator, bool> insert(const std::pair<std::string, CMPCrowd>& entry);
+    void erase(iterator it);
+    void clear();
+
+    /** Returns the issuers of all crowdsales with a deadline before the given time. */
+    std::vector<std::string> getExpired(int64_t blockTime) const;
+};
 
 //! LevelDB based storage for currencies, smart properties and tokens
 extern CMPSPInfo* pDbSpInfo;
@@ -40,29 +40,28 @@ OwnerAddrType STO_GetReceivers(const std::string& sender, uint32_t property, int
 
     {
         LOCK(cs_tally);
-        std::unordered_map<std::string, CMPTally>::iterator it;
-
-        for (it = mp_tally_map.begin(); it != mp_tally_map.end(); ++it) {
-            const std::string& address = it->first;
-            const CMPTally& tally = it->second;
-
-            int64_t tokens = 0;
-            tokens += tally.getMoney(property, BALANCE);
-            tokens += tally.getMoney(property, SELLOFFER_RESERVE);
-            tokens += tally.getMoney(property, ACCEPT_RESERVE);
-            tokens += tally.getMoney(property, METADEX_RESERVE);
-
-            // Do not include the sender
-            if (address == sender) {
-                senderTokens = tokens;
-                continue;
-            }
+        const CMPHolderIndex::HolderSet* holders = mp_holder_index.getHolders(property);
+
+        if (holders) {
+            for (CMPHolderIndex::HolderSet::const_iterator it = holders->begin(); it != holders->end(); ++it) {
+                const std::string& address = mp_address_table.resolve(*it);
+                std::unordered_map<uint32_t, CMPTally>::const_iterator tally_it = mp_tally_map.find(*it);
+                assert(tally_it != mp_tally_map.end());
+
+                int64_t tokens = tally_it->second.getMoneyOwned(property);
+
+                // Do not include the sender
+                if (address == sender) {
+                    senderTokens = tokens;
+                    continue;
+                }
 
-            totalTokens += tokens;
+                totalTokens += tokens;
 
-            // Only holders with balance are relevant
-            if (0 < tokens) {
-                ownerAddrSet.insert(std::make_pair(tokens, address));
+                // Only holders with balance are relevant
+                if (0 < tokens) {
+                    ownerAddrSet.insert(std::make_pair(tokens, address));
+                }
             }
         }
     }
@@ -3,15 +3,61 @@
 #include <omnicore/log.h>
 #include <omnicore/omnicore.h>
 
+#include <algorithm>
+#include <assert.h>
+#include <limits>
 #include <stdint.h>
-#include <map>
+#include <string>
+#include <utility>
 
 /**
  * Creates an empty tally.
  */
-CMPTally::CMPTally()
+CMPTally::CMPTally() : my_pos(0)
 {
-    my_it = mp_token.begin();
+}
+
+/** Orders balance records by property identifier. */
+static bool CompareRecordId(const CMPTally::BalanceRecord& record, uint32_t propertyId)
+{
+    return record.propertyId < propertyId;
+}
+
+/**
+ * Returns the balance record of a token.
+ *
+ * @param propertyId  The identifier of the token
+ * @return The balance record, or nullptr, if there is none
+ */
+const CMPTally::BalanceRecord* CMPTally::find(uint32_t propertyId) const
+{
+    TokenVector::const_iterator it = std::lower_bound(mp_token.begin(), mp_token.end(), propertyId, CompareRecordId);
+
+    if (it != mp_token.end() && it->propertyId == propertyId) {
+        return &(*it);
+    }
+
+    return nullptr;
+}
+
+/**
+ * Returns the balance record of a token, which is created with zero
+ * balances, if there is none.
+ *
+ * @param propertyId  The identifier of the token
+ * @return The balance record
+ */
+CMPTally::BalanceRecord& CMPTally::findOrInsert(uint32_t propertyId)
+{
+    TokenVector::iterator it = std::lower_bound(mp_token.begin(), mp_token.end(), propertyId, CompareRecordId);
+
+    if (it == mp_token.end() || it->propertyId != propertyId) {
+        BalanceRecord record = {};
+        record.propertyId = propertyId;
+        it = mp_token.insert(it, record);
+    }
+
+    return *it;
 }
 
 /**
@@ -22,9 +68,9 @@ CMPTally::CMPTally()
 uint32_t CMPTally::init()
 {
     uint32_t propertyId = 0;
-    my_it = mp_token.begin();
-    if (my_it != mp_token.end()) {
-        propertyId = my_it->first;
+    my_pos = 0;
+    if (my_pos < mp_token.size()) {
+        propertyId = mp_token[my_pos].propertyId;
     }
     return propertyId;
 }
@@ -37,9 +83,9 @@ uint32_t CMPTally::init()
 uint32_t CMPTally::next()
 {
     uint32_t ret = 0;
-    if (my_it != mp_token.end()) {
-        ret = my_it->first;
-        ++my_it;
+    if (my_pos < mp_token.size()) {
+        ret = mp_token[my_pos].propertyId;
+        ++my_pos;
     }
     return ret;
 }
@@ -73,7 +119,8 @@ bool CMPTally::updateMoney(uint32_t propertyId, int64_t amount, TallyType ttype)
         return false;
     }
     bool fUpdated = false;
-    int64_t now64 = mp_token[propertyId].balance[ttype];
+    BalanceRecord& record = findOrInsert(propertyId);
+    int64_t now64 = record.balance[ttype];
 
     if (isOverflow(now64, amount)) {
         PrintToLog("%s(): ERROR: arithmetic overflow [%d + %d]\n", __func__, now64, amount);
@@ -86,7 +133,7 @@ bool CMPTally::updateMoney(uint32_t propertyId, int64_t amount, TallyType ttype)
     } else {
 
         now64 += amount;
-        mp_token[propertyId].balance[ttype] = now64;
+        record.balance[ttype] = now64;
 
         fUpdated = true;
     }
@@ -107,11 +154,10 @@ int64_t CMPTally::getMoney(uint32_t propertyId, TallyType ttype) const
         return 0;
     }
     int64_t money = 0;
-    TokenMap::const_iterator it = mp_token.find(propertyId);
+    const BalanceRecord* record = find(propertyId);
 
-    if (it != mp_token.end()) {
-        const BalanceRecord& record = it->second;
-        money = record.balance[ttype];
+    if (record) {
+        money = record->balance[ttype];
     }
 
     return money;
@@ -128,14 +174,13 @@ int64_t CMPTally::getMoney(uint32_t propertyId, TallyType ttype) const
  */
 int64_t CMPTally::getMoneyAvailable(uint32_t propertyId) const
 {
-    TokenMap::const_iterator it = mp_token.find(propertyId);
+    const BalanceRecord* record = find(propertyId);
 
-    if (it != mp_token.end()) {
-        const BalanceRecord& record = it->second;
-        if (record.balance[PENDING] < 0) {
-            return record.balance[BALANCE] + record.balance[PENDING];
+    if (record) {
+        if (record->balance[PENDING] < 0) {
+            return record->balance[BALANCE] + record->balance[PENDING];
         } else {
-            return record.balance[BALANCE];
+            return record->balance[BALANCE];
         }
     }
 
@@ -154,13 +199,35 @@ int64_t CMPTally::getMoneyAvailable(uint32_t propertyId) const
 int64_t CMPTally::getMoneyReserved(uint32_t propertyId) const
 {
     int64_t money = 0;
-    TokenMap::const_iterator it = mp_token.find(propertyId);
+    const BalanceRecord* record = find(propertyId);
 
-    if (it != mp_token.end()) {
-        const BalanceRecord& record = it->second;
-        money += record.balance[SELLOFFER_RESERVE];
-        money += record.balance[ACCEPT_RESERVE];
-        money += record.balance[METADEX_RESERVE];
+    if (record) {
+        money += record->balance[SELLOFFER_RESERVE];
+        money += record->balance[ACCEPT_RESERVE];
+        money += record->balance[METADEX_RESERVE];
+    }
+
+    return money;
+}
+
+/**
+ * Returns the number of owned tokens, including reserved tokens.
+ *
+ * Pending amounts are not considered.
+ *
+ * @param propertyId  The identifier of the tally to lookup
+ * @return The owned balance
+ */
+int64_t CMPTally::getMoneyOwned(uint32_t propertyId) const
+{
+    int64_t money = 0;
+    const BalanceRecord* record = find(propertyId);
+
+    if (record) {
+        money += record->balance[BALANCE];
+        money += record->balance[SELLOFFER_RESERVE];
+        money += record->balance[ACCEPT_RESERVE];
+        money += record->balance[METADEX_RESERVE];
     }
 
     return money;
@@ -177,15 +244,15 @@ bool CMPTally::operator==(const CMPTally& rhs) const
     if (mp_token.size() != rhs.mp_token.size()) {
         return false;
     }
-    TokenMap::const_iterator pc1 = mp_token.begin();
-    TokenMap::const_iterator pc2 = rhs.mp_token.begin();
+    TokenVector::const_iterator pc1 = mp_token.begin();
+    TokenVector::const_iterator pc2 = rhs.mp_token.begin();
 
     for (unsigned int i = 0; i < mp_token.size(); ++i) {
-        if (pc1->first != pc2->first) {
+        if (pc1->propertyId != pc2->propertyId) {
             return false;
         }
-        const BalanceRecord& record1 = pc1->second;
-        const BalanceRecord& record2 = pc2->second;
+        const BalanceRecord& record1 = *pc1;
+        const BalanceRecord& record2 = *pc2;
 
         for (int ttype = 0; ttype < TALLY_TYPE_COUNT; ++ttype) {
             if (record1.balance[ttype] != record2.balance[ttype]) {
@@ -228,15 +295,14 @@ int64_t CMPTally::print(uint32_t propertyId, bool bDivisible) const
     int64_t pending = 0;
     int64_t metadex_reserve = 0;
 
-    TokenMap::const_iterator it = mp_token.find(propertyId);
+    const BalanceRecord* record = find(propertyId);
 
-    if (it != mp_token.end()) {
-        const BalanceRecord& record = it->second;
-        balance = record.balance[BALANCE];
-        selloffer_reserve = record.balance[SELLOFFER_RESERVE];
-        accept_reserve = record.balance[ACCEPT_RESERVE];
-        pending = record.balance[PENDING];
-        metadex_reserve = record.balance[METADEX_RESERVE];
+    if (record) {
+        balance = record->balance[BALANCE];
+        selloffer_reserve = record->balance[SELLOFFER_RESERVE];
+        accept_reserve = record->balance[ACCEPT_RESERVE];
+        pending = record->balance[PENDING];
+        metadex_reserve = record->balance[METADEX_RESERVE];
     }
 
     if (bDivisible) {
@@ -251,3 +317,138 @@ int64_t CMPTally::print(uint32_t propertyId, bool bDivisible) const
 
     return (balance + selloffer_reserve + accept_reserve + metadex_reserve);
 }
+
+/**
+ * Returns the handle of an address, which is added, if it's not yet known.
+ *
+ * @param address  The address to intern
+ * @return The handle of the address
+ */
+uint32_t CMPAddressTable::intern(const std::string& address)
+{
+    std::unordered_map<std::string, uint32_t>::iterator it = mp_handles.find(address);
+
+    if (it == mp_handles.end()) {
+        assert(vec_addresses.size() < std::numeric_limits<uint32_t>::max());
+        uint32_t handle = static_cast<uint32_t>(vec_addresses.size());
+        it = mp_handles.insert(std::make_pair(address, handle)).first;
+        vec_addresses.push_back(&(it->first));
+    }
+
+    return it->second;
+}
+
+/**
+ * Retrieves the handle of an address, without adding it.
+ *
+ * @param address  The address to look up
+ * @param handle   The handle of the address
+ * @return True, if the address is known
+ */
+bool CMPAddressTable::find(const std::string& address, uint32_t& handle) const
+{
+    std::unordered_map<std::string, uint32_t>::const_iterator it = mp_handles.find(address);
+
+    if (it != mp_handles.end()) {
+        handle = it->second;
+        return true;
+    }
+
+    return false;
+}
+
+/**
+ * Returns the address of a handle.
+ *
+ * @param handle  The handle, which must have been returned by intern()
+ * @return The address
+ */
+const std::string& CMPAddressTable::resolve(uint32_t handle) const
+{
+    assert(handle < vec_addresses.size());
+
+    return *(vec_addresses[handle]);
+}
+
+/**
+ * Updates the index, after the owned tokens of an address changed.
+ *
+ * @param addressHandle  The handle of the address of the tally that was updated
+ * @param propertyId     The identifier of the updated property
+ * @param ownedBefore    The number of owned tokens before the update
+ * @param ownedAfter     The number of owned tokens after the update
+ */
+void CMPHolderIndex::update(uint32_t addressHandle, uint32_t propertyId, int64_t ownedBefore, int64_t ownedAfter)
+{
+    if (ownedBefore == ownedAfter) {
+        return;
+    }
+
+    PropertyRecord& record = mp_property[propertyId];
+    record.total += (ownedAfter - ownedBefore);
+
+    if (0 == ownedAfter) {
+        record.holders.erase(addressHandle);
+    } else if (0 == ownedBefore) {
+        record.holders.insert(addressHandle);
+    }
+
+    if (record.holders.empty() && 0 == record.total) {
+        mp_property.erase(propertyId);
+    }
+}
+
+/**
+ * Returns the addresses holding tokens of a property.
+ *
+ * @param propertyId  The identifier of the property
+ * @return The holders, or nullptr, if there are none
+ */
+const CMPHolderIndex::HolderSet* CMPHolderIndex::getHolders(uint32_t propertyId) const
+{
+    std::unordered_map<uint32_t, PropertyRecord>::const_iterator it = mp_property.find(propertyId);
+
+    if (it != mp_property.end()) {
+        return &(it->second.holders);
+    }
+
+    return nullptr;
+}
+
+/**
+ * Returns the number of addresses holding tokens of a property.
+ *
+ * @param propertyId  The identifier of the property
+ * @return The number of holders
+ */
+size_t CMPHolderIndex::getHolderCount(uint32_t propertyId) const
+{
+    const HolderSet* holders = getHolders(propertyId);
+
+    return holders ? holders->size() : 0;
+}
+
+/**
+ * Returns the total number of tokens owned by all addresses.
+ *
+ * @param propertyId  The identifier of the property
+ * @return The sum of available and reserved tokens of all holders
+ */
+int64_t CMPHolderIndex::getTotal(uint32_t propertyId) const
+{
+    std::unordered_map<uint32_t, PropertyRecord>::const_iterator it = mp_property.find(propertyId);
+
+    if (it != mp_property.end()) {
+        return it->second.total;
+    }
+
+    return 0;
+}
+
+/**
+ * Removes all entries.
+ */
+void CMPHolderIndex::clear()
+{
+    mp_property.clear();
+}
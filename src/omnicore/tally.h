@@ -1,8 +1,13 @@
 #ifndef XEP_OMNICORE_TALLY_H
 #define XEP_OMNICORE_TALLY_H
 
+#include <prevector.h>
+
 #include <stdint.h>
-#include <map>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
 //! Balance record types
 enum TallyType {
@@ -18,22 +23,43 @@ enum TallyType {
  */
 class CMPTally
 {
-private:
-    typedef struct {
+public:
+    //! Balances of a single token
+    struct BalanceRecord {
+        uint32_t propertyId;
         int64_t balance[TALLY_TYPE_COUNT];
-    } BalanceRecord;
+    };
+
+    //! Balance records, ordered by property identifier
+    //! Most entities hold only a few tokens, which are stored inline.
+    typedef prevector<2, BalanceRecord> TokenVector;
+    typedef TokenVector::const_iterator const_iterator;
 
-    //! Map of balance records
-    typedef std::map<uint32_t, BalanceRecord> TokenMap;
+private:
     //! Balance records for different tokens
-    TokenMap mp_token;
-    //! Internal iterator pointing to a balance record
-    TokenMap::iterator my_it;
+    TokenVector mp_token;
+    //! Position of the internal iterator
+    TokenVector::size_type my_pos;
+
+    /** Returns the balance record of a token, or nullptr, if there is none. */
+    const BalanceRecord* find(uint32_t propertyId) const;
+
+    /** Returns the balance record of a token, which is created, if there is none. */
+    BalanceRecord& findOrInsert(uint32_t propertyId);
 
 public:
     /** Creates an empty tally. */
     CMPTally();
 
+    /** Returns an iterator to the first balance record. */
+    const_iterator begin() const { return mp_token.begin(); }
+
+    /** Returns an iterator past the last balance record. */
+    const_iterator end() const { return mp_token.end(); }
+
+    /** Returns the number of balance records. */
+    size_t size() const { return mp_token.size(); }
+
     /** Resets the internal iterator. */
     uint32_t init();
 
@@ -52,6 +78,9 @@ public:
     /** Returns the number of reserved tokens. */
     int64_t getMoneyReserved(uint32_t propertyId) const;
 
+    /** Returns the number of owned tokens, including reserved tokens. */
+    int64_t getMoneyOwned(uint32_t propertyId) const;
+
     /** Compares the tally with another tally and returns true, if they are equal. */
     bool operator==(const CMPTally& rhs) const;
 
@@ -62,5 +91,71 @@ public:
     int64_t print(uint32_t propertyId = 1, bool bDivisible = true) const;
 };
 
+/** Table of interned addresses.
+ *
+ * Each distinct address is mapped to a compact handle, so that in-memory
+ * state can refer to addresses without storing and hashing the encoded
+ * address again. Handles are assigned sequentially, starting at zero, and
+ * remain valid for the lifetime of the table.
+ */
+class CMPAddressTable
+{
+private:
+    //! Handles of the interned addresses
+    std::unordered_map<std::string, uint32_t> mp_handles;
+    //! Interned addresses, indexed by handle, pointing to the keys of mp_handles
+    std::vector<const std::string*> vec_addresses;
+
+public:
+    /** Returns the handle of an address, which is added, if it's not yet known. */
+    uint32_t intern(const std::string& address);
+
+    /** Retrieves the handle of an address, without adding it. */
+    bool find(const std::string& address, uint32_t& handle) const;
+
+    /** Returns the address of a handle. */
+    const std::string& resolve(uint32_t handle) const;
+
+    /** Returns the number of interned addresses. */
+    size_t size() const { return vec_addresses.size(); }
+};
+
+/** Index of holders and total number of tokens per property.
+ *
+ * An address is considered as holder of a property, if it owns tokens of
+ * that property, either available or reserved. Pending amounts are not
+ * considered.
+ */
+class CMPHolderIndex
+{
+public:
+    //! Handles of the addresses holding tokens of a property, ordered by handle, so they can be paged
+    typedef std::set<uint32_t> HolderSet;
+
+private:
+    typedef struct {
+        HolderSet holders;
+        int64_t total = 0;
+    } PropertyRecord;
+
+    //! Holders and totals per property
+    std::unordered_map<uint32_t, PropertyRecord> mp_property;
+
+public:
+    /** Updates the index, after the owned tokens of an address changed. */
+    void update(uint32_t addressHandle, uint32_t propertyId, int64_t ownedBefore, int64_t ownedAfter);
+
+    /** Returns the addresses holding tokens of a property, or nullptr, if there are none. */
+    const HolderSet* getHolders(uint32_t propertyId) const;
+
+    /** Returns the number of addresses holding tokens of a property. */
+    size_t getHolderCount(uint32_t propertyId) const;
+
+    /** Returns the total number of tokens owned by all addresses. */
+    int64_t getTotal(uint32_t propertyId) const;
+
+    /** Removes all entries. */
+    void clear();
+};
 
 #endif // XEP_OMNICORE_TALLY_H
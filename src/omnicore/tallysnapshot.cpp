@@ -0,0 +1,153 @@
+/**
+ * @file tallysnapshot.cpp
+ *
+ * Provides copy-on-write snapshots of the tally state, which are published
+ * after each block and can be read without holding cs_tally.
+ */
+
+#include <omnicore/tallysnapshot.h>
+
+#include <omnicore/omnicore.h>
+#include <omnicore/tally.h>
+
+#include <sync.h>
+#include <uint256.h>
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace mastercore
+{
+//! Guards the latest snapshot
+static Mutex cs_tally_snapshot;
+//! The latest published snapshot
+static std::shared_ptr<const CMPTallySnapshot> pTallySnapshot GUARDED_BY(cs_tally_snapshot);
+
+//! Addresses with updated tallies, since the last snapshot
+static std::unordered_set<uint32_t> setDirtyAddresses;
+//! Whether the frozen addresses were updated, since the last snapshot
+static bool fFrozenDirty = true;
+//! Whether the next snapshot copies the whole tally state
+static bool fFullUpdate = true;
+
+size_t CMPTallySnapshot::GetShardIndex(const std::string& address)
+{
+    return std::hash<std::string>()(address) % NUM_SHARDS;
+}
+
+const CMPTally* CMPTallySnapshot::getTally(const std::string& address) const
+{
+    const Shard& shard = *vShards[GetShardIndex(address)];
+    Shard::const_iterator it = shard.find(address);
+    if (it == shard.end()) return nullptr;
+
+    return &(it->second);
+}
+
+bool CMPTallySnapshot::isAddressFrozen(const std::string& address, uint32_t propertyId) const
+{
+    return frozenAddresses->count(std::make_pair(address, propertyId)) > 0;
+}
+
+std::shared_ptr<const CMPTallySnapshot> GetTallySnapshot()
+{
+    LOCK(cs_tally_snapshot);
+    return pTallySnapshot;
+}
+
+/**
+ * Marks the tally of an address as updated.
+ *
+ * Nothing is tracked, until the first snapshot was published.
+ */
+void TallySnapshotMarkDirty(uint32_t addressHandle)
+{
+    if (!fFullUpdate) {
+        setDirtyAddresses.insert(addressHandle);
+    }
+}
+
+void TallySnapshotMarkFrozenDirty()
+{
+    fFrozenDirty = true;
+}
+
+void TallySnapshotInvalidate()
+{
+    setDirtyAddresses.clear();
+    fFrozenDirty = true;
+    fFullUpdate = true;
+}
+
+/**
+ * Publishes a snapshot of the current tally state.
+ *
+ * The first snapshot, and the first snapshot after the tally state was cleared,
+ * copy all tallies. Afterwards only the shards of updated addresses are copied.
+ */
+void PublishTallySnapshot(int nBlock, const uint256& blockHash, const CMPTallySnapshot::FrozenSet& frozenAddresses)
+{
+    AssertLockHeld(cs_tally);
+
+    std::shared_ptr<const CMPTallySnapshot> pPrevious = GetTallySnapshot();
+    std::shared_ptr<CMPTallySnapshot> pSnapshot = std::make_shared<CMPTallySnapshot>();
+    pSnapshot->nBlock = nBlock;
+    pSnapshot->blockHash = blockHash;
+
+    if (fFullUpdate || !pPrevious) {
+        std::vector<std::shared_ptr<CMPTallySnapshot::Shard> > vShards;
+        vShards.reserve(CMPTallySnapshot::NUM_SHARDS);
+        for (size_t n = 0; n < CMPTallySnapshot::NUM_SHARDS; ++n) {
+            vShards.push_back(std::make_shared<CMPTallySnapshot::Shard>());
+        }
+        for (std::unordered_map<uint32_t, CMPTally>::const_iterator it = mp_tally_map.begin(); it != mp_tally_map.end(); ++it) {
+            const std::string& address = mp_address_table.resolve(it->first);
+            vShards[CMPTallySnapshot::GetShardIndex(address)]->insert(std::make_pair(address, it->second));
+        }
+        pSnapshot->vShards.assign(vShards.begin(), vShards.end());
+        fFullUpdate = false;
+    } else {
+        pSnapshot->vShards = pPrevious->vShards;
+
+        // copy each updated shard once, and then apply the updated tallies
+        std::map<size_t, std::shared_ptr<CMPTallySnapshot::Shard> > mapCopies;
+        for (std::unordered_set<uint32_t>::const_iterator it = setDirtyAddresses.begin(); it != setDirtyAddresses.end(); ++it) {
+            const std::string& address = mp_address_table.resolve(*it);
+            const size_t nShard = CMPTallySnapshot::GetShardIndex(address);
+            std::shared_ptr<CMPTallySnapshot::Shard>& pShard = mapCopies[nShard];
+            if (!pShard) {
+                pShard = std::make_shared<CMPTallySnapshot::Shard>(*pPrevious->vShards[nShard]);
+            }
+            std::unordered_map<uint32_t, CMPTally>::const_iterator my_it = mp_tally_map.find(*it);
+            if (my_it != mp_tally_map.end()) {
+                (*pShard)[address] = my_it->second;
+            } else {
+                pShard->erase(address);
+            }
+        }
+        for (const auto& entry : mapCopies) {
+            pSnapshot->vShards[entry.first] = entry.second;
+        }
+    }
+    setDirtyAddresses.clear();
+
+    if (fFrozenDirty || !pPrevious) {
+        pSnapshot->frozenAddresses = std::make_shared<const CMPTallySnapshot::FrozenSet>(frozenAddresses);
+        fFrozenDirty = false;
+    } else {
+        pSnapshot->frozenAddresses = pPrevious->frozenAddresses;
+    }
+
+    LOCK(cs_tally_snapshot);
+    pTallySnapshot = pSnapshot;
+}
+} // namespace mastercore
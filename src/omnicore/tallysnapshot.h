@@ -0,0 +1,72 @@
+#ifndef XEP_OMNICORE_TALLYSNAPSHOT_H
+#define XEP_OMNICORE_TALLYSNAPSHOT_H
+
+#include <omnicore/tally.h>
+
+#include <uint256.h>
+
+#include <stddef.h>
+#include <stdint.h>
+#include <memory>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace mastercore
+{
+/** Immutable copy of the tally state after a block.
+ *
+ * The tallies are split into shards by address. A new snapshot only copies the
+ * shards with updated tallies, and shares all other shards with the previous
+ * snapshot, so balances can be read without holding cs_tally.
+ *
+ * Pending amounts are not part of the snapshot.
+ */
+class CMPTallySnapshot
+{
+public:
+    //! Tallies of a shard, keyed by address
+    typedef std::unordered_map<std::string, CMPTally> Shard;
+    //! Frozen addresses and properties
+    typedef std::set<std::pair<std::string, uint32_t> > FrozenSet;
+
+    //! Number of shards
+    static const size_t NUM_SHARDS = 16384;
+
+    //! Height of the block
+    int nBlock;
+    //! Hash of the block
+    uint256 blockHash;
+    //! Shards of the tally state
+    std::vector<std::shared_ptr<const Shard> > vShards;
+    //! Frozen addresses
+    std::shared_ptr<const FrozenSet> frozenAddresses;
+
+    /** Returns the shard of an address. */
+    static size_t GetShardIndex(const std::string& address);
+
+    /** Returns the tally of an address, or nullptr, if there is none. */
+    const CMPTally* getTally(const std::string& address) const;
+    /** Returns whether an address is frozen for a property. */
+    bool isAddressFrozen(const std::string& address, uint32_t propertyId) const;
+};
+
+/** Returns the latest published snapshot, or nullptr, if there is none. */
+std::shared_ptr<const CMPTallySnapshot> GetTallySnapshot();
+
+/** Marks the tally of an address as updated, so it's copied into the next snapshot. */
+void TallySnapshotMarkDirty(uint32_t addressHandle);
+
+/** Marks the frozen addresses as updated, so they are copied into the next snapshot. */
+void TallySnapshotMarkFrozenDirty();
+
+/** Forces the next snapshot to copy the whole tally state. */
+void TallySnapshotInvalidate();
+
+/** Publishes a snapshot of the current tally state. cs_tally must be locked! */
+void PublishTallySnapshot(int nBlock, const uint256& blockHash, const CMPTallySnapshot::FrozenSet& frozenAddresses);
+}
+
+#endif // XEP_OMNICORE_TALLYSNAPSHOT_H
@@ -64,7 +64,8 @@ BOOST_AUTO_TEST_CASE(consensus_string_offer)
 
 BOOST_AUTO_TEST_CASE(consensus_string_accept)
 {
-    CMPAccept accept(1234, 1000, 350000, 10, 2, 2000, 4000, uint256S("2c9a055899147b03b2c5240a020c1f94d243a834ecc06ab8cfa504ee29d07b7b"));
+    CMPAccept accept(1234, 1000, 350000, 10, 2, 2000, 4000, uint256S("2c9a055899147b03b2c5240a020c1f94d243a834ecc06ab8cfa504ee29d07b7b"),
+            "1HG3s4Ext3sTqBTHrgftyUzG3cvx5ZbPCj", "3CwZ7FiQ4MqBenRdCkjjc41M5bnoKQGC2b");
     BOOST_CHECK_EQUAL("2c9a055899147b03b2c5240a020c1f94d243a834ecc06ab8cfa504ee29d07b7b|3CwZ7FiQ4MqBenRdCkjjc41M5bnoKQGC2b|1234|1000|350000",
             GenerateConsensusString(accept, "3CwZ7FiQ4MqBenRdCkjjc41M5bnoKQGC2b"));
 }
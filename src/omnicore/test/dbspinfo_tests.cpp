@@ -0,0 +1,93 @@
+#include <omnicore/dbspinfo.h>
+#include <omnicore/omnicore.h>
+
+#include <arith_uint256.h>
+#include <test/util/setup_common.h>
+#include <tinyformat.h>
+#include <util/system.h>
+
+#include <stdint.h>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+using namespace mastercore;
+
+BOOST_FIXTURE_TEST_SUITE(omnicore_dbspinfo_tests, BasicTestingSetup)
+
+static CMPSPInfo::Entry TestEntry(const std::string& name, int block)
+{
+    CMPSPInfo::Entry info;
+    info.issuer = "issuer";
+    info.prop_type = MSC_PROPERTY_TYPE_INDIVISIBLE;
+    info.name = name;
+    info.update_block = ArithToUint256(arith_uint256(block));
+    return info;
+}
+
+BOOST_AUTO_TEST_CASE(cached_entry_updated)
+{
+    CMPSPInfo* pSpInfo = new CMPSPInfo(GetDataDir() / "MP_spinfo_test", true);
+
+    uint32_t propertyId = pSpInfo->putSP(OMNI_PROPERTY_MSC, TestEntry("first", 1));
+    CMPSPInfo::Entry info;
+    BOOST_REQUIRE(pSpInfo->getSP(propertyId, info));
+    BOOST_CHECK_EQUAL(info.name, "first");
+
+    // the cached entry is replaced by the update
+    BOOST_REQUIRE(pSpInfo->updateSP(propertyId, TestEntry("second", 2)));
+    BOOST_REQUIRE(pSpInfo->getSP(propertyId, info));
+    BOOST_CHECK_EQUAL(info.name, "second");
+
+    delete pSpInfo;
+}
+
+BOOST_AUTO_TEST_CASE(cached_entry_concurrent_update)
+{
+    CMPSPInfo* pSpInfo = new CMPSPInfo(GetDataDir() / "MP_spinfo_test", true);
+
+    const int nUpdates = 500;
+    uint32_t propertyId = pSpInfo->putSP(OMNI_PROPERTY_MSC, TestEntry("update 0", 0));
+
+    // readers load the entry into the cache, while it's updated
+    const int nReaders = 4;
+    std::atomic<bool> fDone(false);
+    std::atomic<uint64_t> nReads[nReaders];
+    std::vector<std::thread> readers;
+    for (int i = 0; i < nReaders; ++i) {
+        nReads[i] = 0;
+        readers.emplace_back([&, i] {
+            CMPSPInfo::Entry info;
+            while (!fDone) {
+                pSpInfo->getSP(propertyId, info);
+                ++nReads[i];
+            }
+        });
+    }
+
+    // an entry read before an update must not be cached after the update
+    int nStale = 0;
+    for (int n = 1; n <= nUpdates; ++n) {
+        const std::string name = strprintf("update %d", n);
+        pSpInfo->updateSP(propertyId, TestEntry(name, n));
+        // wait until the reads, which started before the update, are finished
+        for (int i = 0; i < nReaders; ++i) {
+            const uint64_t nRead = nReads[i];
+            while (nReads[i] < nRead + 2) std::this_thread::yield();
+        }
+        CMPSPInfo::Entry info;
+        if (!pSpInfo->getSP(propertyId, info) || info.name != name) ++nStale;
+    }
+    fDone = true;
+    for (std::thread& reader : readers) {
+        reader.join();
+    }
+    BOOST_CHECK_EQUAL(nStale, 0);
+
+    delete pSpInfo;
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,75 @@
+#include <omnicore/dex.h>
+#include <omnicore/sp.h>
+
+#include <test/util/setup_common.h>
+#include <uint256.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <stdint.h>
+#include <string>
+#include <utility>
+#include <vector>
+
+using mastercore::AcceptMap;
+using mastercore::CrowdMap;
+
+BOOST_FIXTURE_TEST_SUITE(omnicore_expiry_tests, BasicTestingSetup)
+
+static std::pair<std::string, CMPAccept> TestAccept(const std::string& seller, const std::string& buyer, int block, uint8_t paymentWindow)
+{
+    CMPAccept accept(100, block, paymentWindow, 1, 1000, 50000, uint256(), seller, buyer);
+    return std::make_pair(STR_ACCEPT_ADDR_PROP_ADDR_COMBO(seller, buyer, 1), accept);
+}
+
+BOOST_AUTO_TEST_CASE(accepts_expire_by_block)
+{
+    AcceptMap accepts;
+    BOOST_CHECK(accepts.insert(TestAccept("Carol", "Dave", 100, 10)).second);
+    BOOST_CHECK(accepts.insert(TestAccept("Alice", "Bob", 100, 15)).second);
+    BOOST_CHECK(accepts.insert(TestAccept("Alice", "Carol", 105, 5)).second);
+    BOOST_CHECK(!accepts.insert(TestAccept("Alice", "Bob", 101, 1)).second);
+    BOOST_CHECK_EQUAL(accepts.size(), 3U);
+
+    // the decomposed key is available without parsing
+    AcceptMap::const_iterator it = accepts.find(STR_ACCEPT_ADDR_PROP_ADDR_COMBO("Alice", "Bob", 1));
+    BOOST_REQUIRE(it != accepts.end());
+    BOOST_CHECK_EQUAL(it->second.getSeller(), "Alice");
+    BOOST_CHECK_EQUAL(it->second.getBuyer(), "Bob");
+    BOOST_CHECK_EQUAL(it->second.getExpiryBlock(), 115);
+
+    BOOST_CHECK(accepts.getExpired(109).empty());
+    std::vector<std::string> vExpired = accepts.getExpired(110);
+    BOOST_REQUIRE_EQUAL(vExpired.size(), 2U);
+    BOOST_CHECK_EQUAL(vExpired[0], STR_ACCEPT_ADDR_PROP_ADDR_COMBO("Alice", "Carol", 1));
+    BOOST_CHECK_EQUAL(vExpired[1], STR_ACCEPT_ADDR_PROP_ADDR_COMBO("Carol", "Dave", 1));
+
+    // erased accepts are no longer indexed
+    accepts.erase(accepts.find(vExpired[0]));
+    BOOST_CHECK_EQUAL(accepts.getExpired(110).size(), 1U);
+    BOOST_CHECK_EQUAL(accepts.getExpired(200).size(), 2U);
+
+    accepts.clear();
+    BOOST_CHECK(accepts.getExpired(200).empty());
+}
+
+BOOST_AUTO_TEST_CASE(crowdsales_expire_by_deadline)
+{
+    CrowdMap crowds;
+    BOOST_CHECK(crowds.insert(std::make_pair("Bob", CMPCrowd(3, 100, 1, 1500000000, 0, 0, 0, 0))).second);
+    BOOST_CHECK(crowds.insert(std::make_pair("Alice", CMPCrowd(4, 100, 1, 1600000000, 0, 0, 0, 0))).second);
+    BOOST_CHECK(!crowds.insert(std::make_pair("Bob", CMPCrowd(5, 100, 1, 1400000000, 0, 0, 0, 0))).second);
+
+    // a crowdsale is active until the block time passes the deadline
+    BOOST_CHECK(crowds.getExpired(1500000000).empty());
+    std::vector<std::string> vExpired = crowds.getExpired(1500000001);
+    BOOST_REQUIRE_EQUAL(vExpired.size(), 1U);
+    BOOST_CHECK_EQUAL(vExpired[0], "Bob");
+
+    crowds.erase(crowds.find("Bob"));
+    BOOST_CHECK(crowds.getExpired(1500000001).empty());
+    BOOST_CHECK_EQUAL(crowds.getExpired(1600000001).size(), 1U);
+    BOOST_CHECK_EQUAL(crowds.size(), 1U);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
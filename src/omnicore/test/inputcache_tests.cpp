@@ -0,0 +1,95 @@
+#include <omnicore/inputcache.h>
+
+#include <arith_uint256.h>
+#include <coins.h>
+#include <primitives/transaction.h>
+#include <script/script.h>
+#include <test/util/setup_common.h>
+#include <uint256.h>
+
+#include <stdint.h>
+
+#include <boost/test/unit_test.hpp>
+
+using namespace mastercore;
+
+static COutPoint TestOutPoint(uint32_t n)
+{
+    return COutPoint(ArithToUint256(arith_uint256(n)), n);
+}
+
+static Coin TestCoin(int64_t nValue)
+{
+    Coin coin;
+    coin.out.nValue = nValue;
+    coin.out.scriptPubKey << OP_TRUE;
+    coin.nHeight = 1;
+    return coin;
+}
+
+BOOST_FIXTURE_TEST_SUITE(omnicore_inputcache_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(inputcache_evicts_least_recently_used)
+{
+    CMPInputCache cache(3);
+    cache.AddCoin(TestOutPoint(1), TestCoin(1));
+    cache.AddCoin(TestOutPoint(2), TestCoin(2));
+    cache.AddCoin(TestOutPoint(3), TestCoin(3));
+    BOOST_CHECK_EQUAL(cache.size(), 3U);
+
+    // using the first coin makes the second one the oldest
+    Coin coin;
+    BOOST_CHECK(cache.GetCoin(TestOutPoint(1), coin));
+    BOOST_CHECK_EQUAL(coin.out.nValue, 1);
+
+    cache.AddCoin(TestOutPoint(4), TestCoin(4));
+    BOOST_CHECK_EQUAL(cache.size(), 3U);
+    BOOST_CHECK_EQUAL(cache.evictions(), 1U);
+    BOOST_CHECK(cache.HaveCoin(TestOutPoint(1)));
+    BOOST_CHECK(!cache.HaveCoin(TestOutPoint(2)));
+    BOOST_CHECK(cache.HaveCoin(TestOutPoint(3)));
+    BOOST_CHECK(cache.HaveCoin(TestOutPoint(4)));
+    BOOST_CHECK(!cache.GetCoin(TestOutPoint(2), coin));
+
+    cache.SetMaxSize(1);
+    BOOST_CHECK_EQUAL(cache.size(), 1U);
+    BOOST_CHECK(cache.HaveCoin(TestOutPoint(4)));
+
+    cache.Clear();
+    BOOST_CHECK_EQUAL(cache.size(), 0U);
+}
+
+BOOST_AUTO_TEST_CASE(inputcache_keeps_one_coin)
+{
+    CMPInputCache cache(0);
+    BOOST_CHECK_EQUAL(cache.maxSize(), 1U);
+
+    // an added coin is not evicted right away
+    cache.AddCoin(TestOutPoint(1), TestCoin(1));
+    BOOST_CHECK(cache.HaveCoin(TestOutPoint(1)));
+    cache.AddCoin(TestOutPoint(2), TestCoin(2));
+    BOOST_CHECK(!cache.HaveCoin(TestOutPoint(1)));
+    BOOST_CHECK(cache.HaveCoin(TestOutPoint(2)));
+
+    cache.SetMaxSize(0);
+    BOOST_CHECK_EQUAL(cache.maxSize(), 1U);
+    BOOST_CHECK_EQUAL(cache.size(), 1U);
+}
+
+BOOST_AUTO_TEST_CASE(inputcache_backs_coins_view)
+{
+    CMPInputCache cache(10);
+    CCoinsViewCache view(&cache);
+    BOOST_CHECK(view.AccessCoin(TestOutPoint(1)).IsSpent());
+
+    cache.AddCoin(TestOutPoint(1), TestCoin(50));
+    BOOST_CHECK_EQUAL(view.AccessCoin(TestOutPoint(1)).out.nValue, 50);
+    BOOST_CHECK_EQUAL(view.GetCacheSize(), 1U);
+
+    // coins fetched from the input cache can be removed from the view
+    view.Uncache(TestOutPoint(1));
+    BOOST_CHECK_EQUAL(view.GetCacheSize(), 0U);
+    BOOST_CHECK(view.HaveCoin(TestOutPoint(1)));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,83 @@
+#include <omnicore/mdex.h>
+
+#include <test/util/setup_common.h>
+#include <uint256.h>
+
+#include <stdint.h>
+#include <limits>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+using namespace mastercore;
+
+BOOST_FIXTURE_TEST_SUITE(omnicore_mdex_price_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(price_reduced)
+{
+    CMPMetaDExPrice price(1000, 2500);
+    BOOST_CHECK_EQUAL(price.getNumerator(), 2);
+    BOOST_CHECK_EQUAL(price.getDenominator(), 5);
+    BOOST_CHECK(price == CMPMetaDExPrice(2, 5));
+    BOOST_CHECK(price != CMPMetaDExPrice(2, 3));
+    BOOST_CHECK(price.toRational() == rational_t(2, 5));
+}
+
+BOOST_AUTO_TEST_CASE(price_order_matches_rational)
+{
+    const int64_t nMax = std::numeric_limits<int64_t>::max();
+    std::vector<CMPMetaDExPrice> vecPrices;
+    vecPrices.push_back(CMPMetaDExPrice(1, 1));
+    vecPrices.push_back(CMPMetaDExPrice(1, 3));
+    vecPrices.push_back(CMPMetaDExPrice(2, 6));
+    vecPrices.push_back(CMPMetaDExPrice(100000000, 3));
+    vecPrices.push_back(CMPMetaDExPrice(nMax, 1));
+    vecPrices.push_back(CMPMetaDExPrice(1, nMax));
+    vecPrices.push_back(CMPMetaDExPrice(nMax, nMax - 1));
+    vecPrices.push_back(CMPMetaDExPrice(nMax - 1, nMax));
+    vecPrices.push_back(CMPMetaDExPrice(nMax - 1, nMax - 2));
+
+    for (size_t i = 0; i < vecPrices.size(); ++i) {
+        for (size_t j = 0; j < vecPrices.size(); ++j) {
+            const CMPMetaDExPrice& a = vecPrices[i];
+            const CMPMetaDExPrice& b = vecPrices[j];
+            BOOST_CHECK_EQUAL(a < b, a.toRational() < b.toRational());
+            BOOST_CHECK_EQUAL(a > b, a.toRational() > b.toRational());
+            BOOST_CHECK_EQUAL(a == b, a.toRational() == b.toRational());
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(order_book_levels)
+{
+    metadex.clear();
+
+    // property 3 for property 1 at prices 2, 1/2 and 2 again, and property 3 for property 4
+    BOOST_CHECK(MetaDEx_INSERT(CMPMetaDEx("1", 100, 3, 50, 1, 100, uint256S("01"), 1, CMPTransaction::ADD)));
+    BOOST_CHECK(MetaDEx_INSERT(CMPMetaDEx("2", 100, 3, 100, 1, 50, uint256S("02"), 2, CMPTransaction::ADD)));
+    BOOST_CHECK(MetaDEx_INSERT(CMPMetaDEx("3", 101, 3, 10, 1, 20, uint256S("03"), 1, CMPTransaction::ADD)));
+    BOOST_CHECK(MetaDEx_INSERT(CMPMetaDEx("4", 101, 3, 10, 4, 20, uint256S("04"), 2, CMPTransaction::ADD)));
+    // already exists
+    BOOST_CHECK(!MetaDEx_INSERT(CMPMetaDEx("1", 100, 3, 50, 1, 100, uint256S("01"), 1, CMPTransaction::ADD)));
+
+    BOOST_CHECK_EQUAL(metadex.size(), 2U);
+    BOOST_CHECK(get_Prices(1, 3) == nullptr);
+    BOOST_CHECK(get_Prices(3, 4) != nullptr);
+
+    md_PricesMap* prices = get_Prices(3, 1);
+    BOOST_REQUIRE(prices != nullptr);
+    BOOST_REQUIRE_EQUAL(prices->size(), 2U);
+    BOOST_CHECK((*prices)[0].first == CMPMetaDExPrice(1, 2));
+    BOOST_CHECK((*prices)[1].first == CMPMetaDExPrice(2, 1));
+    BOOST_CHECK_EQUAL((*prices)[0].second.size(), 1U);
+    BOOST_CHECK_EQUAL((*prices)[1].second.size(), 2U);
+
+    md_Set* indexes = get_Indexes(prices, CMPMetaDExPrice(4, 2));
+    BOOST_REQUIRE(indexes != nullptr);
+    BOOST_CHECK_EQUAL(indexes->begin()->getAddr(), "1");
+    BOOST_CHECK(get_Indexes(prices, CMPMetaDExPrice(1, 1)) == nullptr);
+
+    metadex.clear();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
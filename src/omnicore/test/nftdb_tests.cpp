@@ -126,4 +126,80 @@ BOOST_AUTO_TEST_CASE(nftdb_test_sequence)
     delete UITDb;
 }
 
+BOOST_AUTO_TEST_CASE(nftdb_owner_index)
+{
+    LOCK(cs_tally);
+    auto UITDb = new CMPNonFungibleTokensDB(GetDataDir() / "OMNI_nftdb", true);
+
+    UITDb->CreateNonFungibleTokens(7, 100, "Alice", "");
+    UITDb->CreateNonFungibleTokens(300, 10, "Alice", "");
+    UITDb->CreateNonFungibleTokens(50, 1000, "Alice", "");
+    BOOST_CHECK(UITDb->MoveNonFungibleTokens(50, 200, 299, "Alice", "Bob"));
+    BOOST_CHECK_EQUAL(UITDb->GetHighestRangeEnd(50), 1000);
+    BOOST_CHECK_EQUAL(UITDb->GetHighestRangeEnd(51), 0);
+
+    // ranges of a property, ordered by range start
+    auto ranges = UITDb->GetNonFungibleTokenRanges(50);
+    BOOST_REQUIRE_EQUAL(ranges.size(), 3U);
+    BOOST_CHECK_EQUAL(ranges[0].first, "Alice");
+    BOOST_CHECK_EQUAL(ranges[0].second.second, 199);
+    BOOST_CHECK_EQUAL(ranges[1].first, "Bob");
+    BOOST_CHECK_EQUAL(ranges[2].second.first, 300);
+
+    // ranges of an owner, grouped by property
+    auto owned = UITDb->GetAddressNonFungibleTokens(0, "Alice");
+    BOOST_REQUIRE_EQUAL(owned.size(), 3U);
+    BOOST_REQUIRE_EQUAL(owned[50].size(), 2U);
+    BOOST_CHECK(owned[50][0] == std::make_pair(int64_t{1}, int64_t{199}));
+    BOOST_CHECK(owned[50][1] == std::make_pair(int64_t{300}, int64_t{1000}));
+    BOOST_CHECK(owned[300][0] == std::make_pair(int64_t{1}, int64_t{10}));
+
+    owned = UITDb->GetAddressNonFungibleTokens(50, "Bob");
+    BOOST_REQUIRE_EQUAL(owned.size(), 1U);
+    BOOST_CHECK(owned[50][0] == std::make_pair(int64_t{200}, int64_t{299}));
+
+    // moved ranges are removed from the index
+    BOOST_CHECK(UITDb->MoveNonFungibleTokens(50, 200, 299, "Bob", "Alice"));
+    BOOST_CHECK(UITDb->GetAddressNonFungibleTokens(0, "Bob").empty());
+    owned = UITDb->GetAddressNonFungibleTokens(50, "Alice");
+    BOOST_REQUIRE_EQUAL(owned[50].size(), 1U);
+    BOOST_CHECK(owned[50][0] == std::make_pair(int64_t{1}, int64_t{1000}));
+
+    delete UITDb;
+}
+
+BOOST_AUTO_TEST_CASE(nftdb_issued_tokens)
+{
+    LOCK(cs_tally);
+    auto UITDb = new CMPNonFungibleTokensDB(GetDataDir() / "OMNI_nftdb", true);
+
+    UITDb->CreateNonFungibleTokens(50, 1000, "Alice", "");
+    UITDb->CreateNonFungibleTokens(51, 10, "Alice", "");
+    UITDb->CreateNonFungibleTokens(50, 500, "Bob", "");
+    BOOST_CHECK_EQUAL(UITDb->GetHighestRangeEnd(50), 1500);
+    BOOST_CHECK_EQUAL(UITDb->GetHighestRangeEnd(51), 10);
+    BOOST_CHECK_EQUAL(UITDb->GetHighestRangeEnd(52), 0);
+
+    // moves don't change the number of issued tokens
+    BOOST_CHECK(UITDb->MoveNonFungibleTokens(50, 1001, 1500, "Bob", "Alice"));
+    BOOST_CHECK_EQUAL(UITDb->GetHighestRangeEnd(50), 1500);
+
+    // the counts are loaded from the database, when it's reopened
+    delete UITDb;
+    UITDb = new CMPNonFungibleTokensDB(GetDataDir() / "OMNI_nftdb", false);
+    BOOST_CHECK_EQUAL(UITDb->GetHighestRangeEnd(50), 1500);
+    std::pair<int64_t, int64_t> range = UITDb->CreateNonFungibleTokens(52, 5, "Bob", "");
+    BOOST_CHECK_EQUAL(range.first, 1);
+    BOOST_CHECK_EQUAL(UITDb->GetHighestRangeEnd(52), 5);
+
+    // and reset, when it's cleared
+    UITDb->Clear();
+    BOOST_CHECK_EQUAL(UITDb->GetHighestRangeEnd(50), 0);
+    range = UITDb->CreateNonFungibleTokens(50, 5, "Bob", "");
+    BOOST_CHECK_EQUAL(range.first, 1);
+    BOOST_CHECK_EQUAL(range.second, 5);
+
+    delete UITDb;
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -89,5 +89,30 @@ BOOST_AUTO_TEST_CASE(update_feature)
     BOOST_CHECK_EQUAL(oldActivationBlock, ConsensusParams().MSC_BET_BLOCK);
 }
 
+BOOST_AUTO_TEST_CASE(unknown_restrictions)
+{
+    BOOST_CHECK(!IsTransactionTypeAllowed(999999, OMNI_PROPERTY_MSC, MSC_TYPE_SIMPLE_SEND, 3));
+    BOOST_CHECK(!IsTransactionTypeAllowed(999999, OMNI_PROPERTY_MSC, 1000, MP_TX_PKT_V0));
+    BOOST_CHECK(!IsTransactionTypeAllowed(999999, OMNI_PROPERTY_XEP, MSC_TYPE_SIMPLE_SEND, MP_TX_PKT_V0));
+    BOOST_CHECK(IsTransactionTypeAllowed(999999, OMNI_PROPERTY_XEP, OMNICORE_MESSAGE_TYPE_ALERT, 0xFFFF));
+    BOOST_CHECK(!IsTransactionTypeAllowed(999999, OMNI_PROPERTY_XEP, OMNICORE_MESSAGE_TYPE_ALERT, MP_TX_PKT_V0));
+    BOOST_CHECK(!IsFeatureActivated(1000, 999999));
+}
+
+BOOST_AUTO_TEST_CASE(update_feature_selected_network)
+{
+    // Unit tests and mainnet use the same params
+    BOOST_CHECK(!IsFeatureActivated(FEATURE_BETTING, 999999));
+    BOOST_CHECK(!IsTransactionTypeAllowed(999999, OMNI_PROPERTY_MSC, MSC_TYPE_OFFER_ACCEPT_A_BET, MP_TX_PKT_V0));
+
+    SelectParams(CBaseChainParams::REGTEST);
+    BOOST_CHECK(IsFeatureActivated(FEATURE_BETTING, 999999));
+    BOOST_CHECK(IsTransactionTypeAllowed(999999, OMNI_PROPERTY_MSC, MSC_TYPE_OFFER_ACCEPT_A_BET, MP_TX_PKT_V0));
+
+    // Restore original
+    SelectParams(CBaseChainParams::MAIN);
+    BOOST_CHECK(!IsFeatureActivated(FEATURE_BETTING, 999999));
+    BOOST_CHECK(!IsTransactionTypeAllowed(999999, OMNI_PROPERTY_MSC, MSC_TYPE_OFFER_ACCEPT_A_BET, MP_TX_PKT_V0));
+}
 
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,109 @@
+#include <omnicore/omnicore.h>
+#include <omnicore/pending.h>
+#include <omnicore/tally.h>
+
+#include <primitives/transaction.h>
+#include <random.h>
+#include <sync.h>
+#include <test/util/setup_common.h>
+#include <txmempool.h>
+#include <uint256.h>
+#include <validation.h>
+#include <validationinterface.h>
+
+#include <stdint.h>
+#include <string>
+
+#include <boost/test/unit_test.hpp>
+
+using namespace mastercore;
+
+BOOST_FIXTURE_TEST_SUITE(omnicore_pending_tests, TestingSetup)
+
+static const std::string SENDER = "xKQVdYJfSpdMkKpPzPxRiEjfU65kLq5aHT";
+
+/** Adds a transaction, spending a random outpoint, to the mempool. */
+static CTransactionRef AddToMempool()
+{
+    CMutableTransaction mtx;
+    mtx.vin.resize(1);
+    mtx.vin[0].prevout = COutPoint(InsecureRand256(), 0);
+    mtx.vout.resize(1);
+    mtx.vout[0].nValue = 10000;
+    CTransactionRef tx = MakeTransactionRef(mtx);
+
+    LOCK2(cs_main, mempool.cs);
+    mempool.addUnchecked(TestMemPoolEntryHelper().FromTx(tx));
+    return tx;
+}
+
+/** Removes a transaction from the mempool, and waits until the listeners were notified. */
+static void RemoveFromMempool(const CTransactionRef& tx, MemPoolRemovalReason reason)
+{
+    {
+        LOCK(mempool.cs);
+        mempool.removeRecursive(*tx, reason);
+    }
+    SyncWithValidationInterfaceQueue();
+}
+
+static bool IsPending(const uint256& txid)
+{
+    LOCK(cs_pending);
+    return my_pending.count(txid) > 0;
+}
+
+BOOST_AUTO_TEST_CASE(pending_removed_from_mempool)
+{
+    RegisterPendingListener();
+
+    CTransactionRef txConfirmed = AddToMempool();
+    CTransactionRef txConflicted = AddToMempool();
+    CTransactionRef txExpired = AddToMempool();
+    PendingAdd(txConfirmed->GetHash(), SENDER, 0, 3, 100);
+    PendingAdd(txConflicted->GetHash(), SENDER, 0, 3, 20);
+    PendingAdd(txExpired->GetHash(), SENDER, 0, 3, 3);
+    BOOST_CHECK(IsPending(txConfirmed->GetHash()));
+    BOOST_CHECK(IsPending(txConflicted->GetHash()));
+    BOOST_CHECK(IsPending(txExpired->GetHash()));
+    BOOST_CHECK_EQUAL(GetTokenBalance(SENDER, 3, PENDING), -123);
+
+    // confirmed transactions are deleted by the transaction handler, not the listener
+    RemoveFromMempool(txConfirmed, MemPoolRemovalReason::BLOCK);
+    BOOST_CHECK(IsPending(txConfirmed->GetHash()));
+    BOOST_CHECK_EQUAL(GetTokenBalance(SENDER, 3, PENDING), -123);
+
+    RemoveFromMempool(txConflicted, MemPoolRemovalReason::CONFLICT);
+    BOOST_CHECK(!IsPending(txConflicted->GetHash()));
+    BOOST_CHECK_EQUAL(GetTokenBalance(SENDER, 3, PENDING), -103);
+
+    RemoveFromMempool(txExpired, MemPoolRemovalReason::EXPIRY);
+    BOOST_CHECK(!IsPending(txExpired->GetHash()));
+    BOOST_CHECK_EQUAL(GetTokenBalance(SENDER, 3, PENDING), -100);
+
+    UnregisterPendingListener();
+    {
+        LOCK2(cs_tally, cs_pending);
+        my_pending.clear();
+        ClearTallyMap();
+    }
+}
+
+BOOST_AUTO_TEST_CASE(pending_not_in_mempool)
+{
+    RegisterPendingListener();
+
+    // a transaction, which already left the mempool, is discarded right away
+    const uint256 txid = InsecureRand256();
+    PendingAdd(txid, SENDER, 0, 3, 50);
+    BOOST_CHECK(!IsPending(txid));
+    BOOST_CHECK_EQUAL(GetTokenBalance(SENDER, 3, PENDING), 0);
+
+    UnregisterPendingListener();
+    {
+        LOCK2(cs_tally, cs_pending);
+        ClearTallyMap();
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,162 @@
+#include <omnicore/omnicore.h>
+#include <omnicore/persistence.h>
+#include <omnicore/tally.h>
+
+#include <chain.h>
+#include <fs.h>
+#include <hash.h>
+#include <sync.h>
+#include <test/util/setup_common.h>
+#include <tinyformat.h>
+#include <uint256.h>
+#include <validation.h>
+
+#include <stdint.h>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+using namespace mastercore;
+
+//! Path for file based persistence
+extern fs::path pathStateFiles;
+
+static const std::string ADDRESS_A = "xKQVdYJfSpdMkKpPzPxRiEjfU65kLq5aHT";
+static const std::string ADDRESS_B = "xQEpSbhgjrCjUwMBUHLpbDAHCSkPuCZkZS";
+
+/** Persists the state as of the given block, and returns the path of the balances file. */
+static fs::path PersistBalances(const CBlockIndex* pBlockIndex)
+{
+    TryCreateDirectories(pathStateFiles);
+    BOOST_CHECK_EQUAL(PersistInMemoryState(pBlockIndex), 0);
+
+    return pathStateFiles / strprintf("balances-%s.dat", pBlockIndex->GetBlockHash().ToString());
+}
+
+static std::vector<char> ReadStateFile(const fs::path& path)
+{
+    std::ifstream file(path.string().c_str(), std::ios::binary);
+    return std::vector<char>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+static void WriteStateFile(const fs::path& path, const std::vector<char>& vData)
+{
+    std::ofstream file(path.string().c_str(), std::ios::binary | std::ios::trunc);
+    file.write(vData.data(), vData.size());
+}
+
+/** Replaces the hash at the end of a binary state file, so it matches the modified content. */
+static void UpdateStateFileHash(std::vector<char>& vData)
+{
+    const size_t nPayloadSize = vData.size() - sizeof(uint256);
+    uint256 hash;
+    CHash256().Write((const unsigned char*)vData.data(), nPayloadSize).Finalize(hash.begin());
+    std::copy(hash.begin(), hash.end(), vData.begin() + nPayloadSize);
+}
+
+BOOST_FIXTURE_TEST_SUITE(omnicore_persistence_tests, TestingSetup)
+
+BOOST_AUTO_TEST_CASE(balances_binary_roundtrip)
+{
+    // the state is persisted with cs_main held, like after connecting a block
+    LOCK2(cs_main, cs_tally);
+    const CBlockIndex* pBlockIndex = ::ChainActive().Tip();
+    ClearTallyMap();
+    BOOST_CHECK(update_tally_map(ADDRESS_A, 3, 1000, BALANCE));
+    BOOST_CHECK(update_tally_map(ADDRESS_A, 3, 200, SELLOFFER_RESERVE));
+    BOOST_CHECK(update_tally_map(ADDRESS_A, 3, 30, ACCEPT_RESERVE));
+    BOOST_CHECK(update_tally_map(ADDRESS_A, 3, 4, METADEX_RESERVE));
+    BOOST_CHECK(update_tally_map(ADDRESS_A, 2147483651U, int64_t(9223372036854775807LL), BALANCE));
+    BOOST_CHECK(update_tally_map(ADDRESS_B, 1, 5, METADEX_RESERVE));
+    // the pending tally is not persisted
+    BOOST_CHECK(update_tally_map(ADDRESS_B, 1, -7, PENDING));
+
+    const fs::path path = PersistBalances(pBlockIndex);
+    ClearTallyMap();
+    BOOST_CHECK_EQUAL(RestoreInMemoryState(path.string(), FILETYPE_BALANCES, true), 0);
+
+    BOOST_CHECK_EQUAL(GetTokenBalance(ADDRESS_A, 3, BALANCE), 1000);
+    BOOST_CHECK_EQUAL(GetTokenBalance(ADDRESS_A, 3, SELLOFFER_RESERVE), 200);
+    BOOST_CHECK_EQUAL(GetTokenBalance(ADDRESS_A, 3, ACCEPT_RESERVE), 30);
+    BOOST_CHECK_EQUAL(GetTokenBalance(ADDRESS_A, 3, METADEX_RESERVE), 4);
+    BOOST_CHECK_EQUAL(GetTokenBalance(ADDRESS_A, 2147483651U, BALANCE), int64_t(9223372036854775807LL));
+    BOOST_CHECK_EQUAL(GetTokenBalance(ADDRESS_B, 1, BALANCE), 0);
+    BOOST_CHECK_EQUAL(GetTokenBalance(ADDRESS_B, 1, METADEX_RESERVE), 5);
+    BOOST_CHECK_EQUAL(GetTokenBalance(ADDRESS_B, 1, PENDING), 0);
+
+    ClearTallyMap();
+}
+
+BOOST_AUTO_TEST_CASE(balances_text_fallback)
+{
+    const std::string strLine = strprintf("%s=3:1000,200,30,4;1:0,0,0,5;", ADDRESS_A);
+    uint256 hash;
+    CHash256().Write((const unsigned char*)strLine.c_str(), strLine.length()).Finalize(hash.begin());
+
+    const fs::path path = GetDataDir() / "balances-text.dat";
+    {
+        std::ofstream file(path.string().c_str());
+        file << strLine << std::endl;
+        file << "!" << hash.ToString() << std::endl;
+    }
+
+    LOCK(cs_tally);
+    ClearTallyMap();
+    BOOST_CHECK_EQUAL(RestoreInMemoryState(path.string(), FILETYPE_BALANCES, true), 0);
+
+    BOOST_CHECK_EQUAL(GetTokenBalance(ADDRESS_A, 3, BALANCE), 1000);
+    BOOST_CHECK_EQUAL(GetTokenBalance(ADDRESS_A, 3, SELLOFFER_RESERVE), 200);
+    BOOST_CHECK_EQUAL(GetTokenBalance(ADDRESS_A, 3, ACCEPT_RESERVE), 30);
+    BOOST_CHECK_EQUAL(GetTokenBalance(ADDRESS_A, 3, METADEX_RESERVE), 4);
+    BOOST_CHECK_EQUAL(GetTokenBalance(ADDRESS_A, 1, METADEX_RESERVE), 5);
+
+    ClearTallyMap();
+}
+
+BOOST_AUTO_TEST_CASE(balances_binary_corrupted)
+{
+    // the state is persisted with cs_main held, like after connecting a block
+    LOCK2(cs_main, cs_tally);
+    const CBlockIndex* pBlockIndex = ::ChainActive().Tip();
+    ClearTallyMap();
+    BOOST_CHECK(update_tally_map(ADDRESS_A, 3, 1000, BALANCE));
+    BOOST_CHECK(update_tally_map(ADDRESS_B, 1, 5, BALANCE));
+
+    const fs::path path = PersistBalances(pBlockIndex);
+    const std::vector<char> vData = ReadStateFile(path);
+    BOOST_REQUIRE(vData.size() > 8 + sizeof(uint256));
+
+    // a single flipped byte fails the hash validation
+    std::vector<char> vFlipped = vData;
+    vFlipped[vFlipped.size() / 2] ^= 0x01;
+    WriteStateFile(path, vFlipped);
+    BOOST_CHECK_EQUAL(RestoreInMemoryState(path.string(), FILETYPE_BALANCES, true), -1);
+
+    // unknown versions are rejected, even with a valid hash
+    std::vector<char> vVersion = vData;
+    vVersion[4] = 2;
+    UpdateStateFileHash(vVersion);
+    WriteStateFile(path, vVersion);
+    BOOST_CHECK_EQUAL(RestoreInMemoryState(path.string(), FILETYPE_BALANCES, true), -1);
+
+    // binary files with other magic bytes are rejected
+    std::vector<char> vMagic = vData;
+    vMagic[3] = 'X';
+    UpdateStateFileHash(vMagic);
+    WriteStateFile(path, vMagic);
+    BOOST_CHECK_EQUAL(RestoreInMemoryState(path.string(), FILETYPE_BALANCES, true), -1);
+    BOOST_CHECK_EQUAL(RestoreInMemoryState(path.string(), FILETYPE_BALANCES, false), -1);
+
+    // the unmodified file is still accepted
+    WriteStateFile(path, vData);
+    BOOST_CHECK_EQUAL(RestoreInMemoryState(path.string(), FILETYPE_BALANCES, true), 0);
+    BOOST_CHECK_EQUAL(GetTokenBalance(ADDRESS_A, 3, BALANCE), 1000);
+    BOOST_CHECK_EQUAL(GetTokenBalance(ADDRESS_B, 1, BALANCE), 5);
+
+    ClearTallyMap();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,93 @@
+#include <omnicore/seedblocks.h>
+
+#include <chainparams.h>
+#include <chainparamsbase.h>
+#include <test/util/setup_common.h>
+#include <util/system.h>
+
+#include <set>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(omnicore_seedblocks_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(seedblock_filter_range)
+{
+    std::set<int> seedBlocks = {99, 100, 107, 108, 200, 201};
+    CSeedBlockFilter filter("regtest", 100, 200, seedBlocks);
+
+    BOOST_CHECK_EQUAL(filter.getSeedBlockCount(), 4);
+    BOOST_CHECK(!filter.Covers(99));
+    BOOST_CHECK(!filter.IsSeedBlock(99));
+    BOOST_CHECK(filter.IsSeedBlock(100));
+    BOOST_CHECK(!filter.IsSeedBlock(101));
+    BOOST_CHECK(filter.IsSeedBlock(107));
+    BOOST_CHECK(filter.IsSeedBlock(108));
+    BOOST_CHECK(filter.IsSeedBlock(200));
+    BOOST_CHECK(!filter.Covers(201));
+
+    CSeedBlockFilter empty;
+    BOOST_CHECK(!empty.Covers(0));
+    BOOST_CHECK_EQUAL(empty.getSeedBlockCount(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(seedblock_filter_file)
+{
+    std::set<int> seedBlocks = {5, 17, 1000};
+    CSeedBlockFilter filter("regtest", 0, 1000, seedBlocks);
+    BOOST_CHECK(filter.WriteFile(GetDataDir() / "seedblocks.dat"));
+
+    CSeedBlockFilter loaded;
+    BOOST_CHECK(loaded.ReadFile(GetDataDir() / "seedblocks.dat"));
+    BOOST_CHECK_EQUAL(loaded.getNetwork(), "regtest");
+    BOOST_CHECK_EQUAL(loaded.getFirstBlock(), 0);
+    BOOST_CHECK_EQUAL(loaded.getLastBlock(), 1000);
+    BOOST_CHECK_EQUAL(loaded.getSeedBlockCount(), 3);
+    BOOST_CHECK(loaded.IsSeedBlock(17));
+    BOOST_CHECK(!loaded.IsSeedBlock(18));
+
+    BOOST_CHECK(!loaded.ReadFile(GetDataDir() / "missing.dat"));
+    BOOST_CHECK(!loaded.Covers(17));
+
+    // ranges starting before the first block are rejected
+    CSeedBlockFilter negative("regtest", -8, 10, seedBlocks);
+    BOOST_CHECK(negative.WriteFile(GetDataDir() / "seedblocks_negative.dat"));
+    BOOST_CHECK(!loaded.ReadFile(GetDataDir() / "seedblocks_negative.dat"));
+    BOOST_CHECK(!loaded.Covers(5));
+}
+
+BOOST_AUTO_TEST_CASE(seedblock_filter_network)
+{
+    std::set<int> seedBlocks = {5};
+    CSeedBlockFilter filter("regtest", 0, 10, seedBlocks);
+    BOOST_CHECK(filter.WriteFile(GetDataDir() / "seedblocks_regtest.dat"));
+
+    // the file is used on its own network
+    SelectParams(CBaseChainParams::REGTEST);
+    gArgs.ForceSetArg("-omniseedblockfile", "seedblocks_regtest.dat");
+    InitSeedBlockFilter();
+    BOOST_CHECK(!SkipBlock(5));
+    BOOST_CHECK(SkipBlock(6));
+    BOOST_CHECK(!SkipBlock(11));
+
+    // but ignored on other networks
+    SelectParams(CBaseChainParams::TESTNET);
+    InitSeedBlockFilter();
+    BOOST_CHECK(!SkipBlock(6));
+
+    // where the built-in seed blocks are used on mainnet
+    SelectParams(CBaseChainParams::MAIN);
+    gArgs.ForceSetArg("-omniseedblockfile", "");
+    InitSeedBlockFilter();
+    BOOST_CHECK(SkipBlock(249497));
+    BOOST_CHECK(!SkipBlock(249498));
+    BOOST_CHECK(!SkipBlock(490001));
+
+    // only skip blocks, when the filter is active, which is left inactive for other tests
+    SelectParams(CBaseChainParams::REGTEST);
+    InitSeedBlockFilter();
+    BOOST_CHECK(!SkipBlock(6));
+    SelectParams(CBaseChainParams::MAIN);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,69 @@
+#include <omnicore/dbstolist.h>
+
+#include <arith_uint256.h>
+#include <test/util/setup_common.h>
+#include <uint256.h>
+#include <util/system.h>
+
+#include <stdint.h>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(omnicore_stolist_tests, BasicTestingSetup)
+
+static uint256 TestTxid(uint64_t n)
+{
+    return ArithToUint256(arith_uint256(n));
+}
+
+BOOST_AUTO_TEST_CASE(stolist_receipts_by_address)
+{
+    CMPSTOList* pStoList = new CMPSTOList(GetDataDir() / "MP_stolist_test", true);
+
+    pStoList->recordSTOReceive("Alice", TestTxid(1), 120, 3, 50);
+    pStoList->recordSTOReceive("Bob", TestTxid(1), 120, 3, 25);
+    pStoList->recordSTOReceive("Alice", TestTxid(2), 100, 4, 10);
+    pStoList->recordSTOReceive("Bob", TestTxid(3), 110, 3, 5);
+    pStoList->recordSTOReceive("Alicia", TestTxid(4), 90, 3, 1);
+
+    BOOST_CHECK(pStoList->exists("Alice"));
+    BOOST_CHECK(!pStoList->exists("Ali"));
+
+    std::vector<std::string> vAddresses = pStoList->getRecipientAddresses();
+    BOOST_REQUIRE_EQUAL(vAddresses.size(), 3U);
+    BOOST_CHECK_EQUAL(vAddresses[0], "Alice");
+    BOOST_CHECK_EQUAL(vAddresses[1], "Alicia");
+    BOOST_CHECK_EQUAL(vAddresses[2], "Bob");
+
+    // ordered by block, and each transaction only once
+    std::set<std::string> setAddresses = {"Alice", "Bob"};
+    std::vector<CMPSTOList::Receipt> vReceipts = pStoList->getReceipts(setAddresses);
+    BOOST_REQUIRE_EQUAL(vReceipts.size(), 3U);
+    BOOST_CHECK(vReceipts[0].txid == TestTxid(2));
+    BOOST_CHECK_EQUAL(vReceipts[0].block, 100);
+    BOOST_CHECK_EQUAL(vReceipts[0].propertyId, 4U);
+    BOOST_CHECK_EQUAL(vReceipts[0].amount, 10U);
+    BOOST_CHECK(vReceipts[1].txid == TestTxid(3));
+    BOOST_CHECK(vReceipts[2].txid == TestTxid(1));
+    BOOST_CHECK_EQUAL(vReceipts[2].address, "Alice");
+
+    // limited to the block range
+    vReceipts = pStoList->getReceipts(setAddresses, 105, 115);
+    BOOST_REQUIRE_EQUAL(vReceipts.size(), 1U);
+    BOOST_CHECK(vReceipts[0].txid == TestTxid(3));
+
+    // all entries of the removed blocks are deleted
+    BOOST_CHECK_EQUAL(pStoList->deleteAboveBlock(110), 3);
+    vReceipts = pStoList->getReceipts(setAddresses);
+    BOOST_REQUIRE_EQUAL(vReceipts.size(), 1U);
+    BOOST_CHECK(vReceipts[0].txid == TestTxid(2));
+    BOOST_CHECK(!pStoList->exists("Bob"));
+    BOOST_CHECK_EQUAL(pStoList->getRecipientAddresses().size(), 2U);
+
+    delete pStoList;
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -1,8 +1,11 @@
 #include <omnicore/tally.h>
 
 #include <test/util/setup_common.h>
+#include <tinyformat.h>
 
 #include <stdint.h>
+#include <string>
+#include <vector>
 
 #include <boost/test/unit_test.hpp>
 
@@ -174,6 +177,45 @@ BOOST_AUTO_TEST_CASE(tally_entry_order)
     BOOST_CHECK_EQUAL(tally.getMoneyReserved(70), 0);
 }
 
+BOOST_AUTO_TEST_CASE(tally_const_iteration)
+{
+    CMPTally tally;
+    BOOST_CHECK(tally.begin() == tally.end());
+    BOOST_CHECK_EQUAL(0U, tally.size());
+
+    BOOST_CHECK(tally.updateMoney(7, 1, BALANCE));
+    BOOST_CHECK(tally.updateMoney(3, 2, SELLOFFER_RESERVE));
+    BOOST_CHECK(tally.updateMoney(12, 3, METADEX_RESERVE));
+    BOOST_CHECK(tally.updateMoney(1, -4, PENDING));
+    BOOST_CHECK(tally.updateMoney(3, 5, BALANCE));
+    BOOST_CHECK_EQUAL(4U, tally.size());
+
+    const CMPTally& constTally = tally;
+    std::vector<uint32_t> vPropertyIds;
+    for (const CMPTally::BalanceRecord& record : constTally) {
+        vPropertyIds.push_back(record.propertyId);
+        BOOST_CHECK_EQUAL(record.balance[BALANCE], constTally.getMoney(record.propertyId, BALANCE));
+        BOOST_CHECK_EQUAL(record.balance[PENDING], constTally.getMoney(record.propertyId, PENDING));
+    }
+    BOOST_CHECK_EQUAL(4U, vPropertyIds.size());
+    BOOST_CHECK_EQUAL(1U, vPropertyIds[0]);
+    BOOST_CHECK_EQUAL(3U, vPropertyIds[1]);
+    BOOST_CHECK_EQUAL(7U, vPropertyIds[2]);
+    BOOST_CHECK_EQUAL(12U, vPropertyIds[3]);
+
+    BOOST_CHECK_EQUAL(5, tally.getMoney(3, BALANCE));
+    BOOST_CHECK_EQUAL(2, tally.getMoney(3, SELLOFFER_RESERVE));
+    BOOST_CHECK_EQUAL(-4, tally.getMoney(1, PENDING));
+    BOOST_CHECK_EQUAL(0, tally.getMoney(2, BALANCE));
+
+    // copies hold their own records
+    CMPTally copy = tally;
+    BOOST_CHECK(copy.updateMoney(2, 1, BALANCE));
+    BOOST_CHECK_EQUAL(5U, copy.size());
+    BOOST_CHECK_EQUAL(4U, tally.size());
+    BOOST_CHECK(copy != tally);
+}
+
 BOOST_AUTO_TEST_CASE(tally_equality)
 {
     CMPTally tally1;
@@ -318,5 +360,92 @@ BOOST_AUTO_TEST_CASE(tally_overflow)
     BOOST_CHECK_EQUAL(tally.getMoneyReserved(3), int64_t(9223372036854775807LL));
 }
 
+BOOST_AUTO_TEST_CASE(address_table)
+{
+    CMPAddressTable table;
+    uint32_t handle = 0;
+    BOOST_CHECK_EQUAL(table.size(), 0U);
+    BOOST_CHECK(!table.find("alice", handle));
+
+    uint32_t alice = table.intern("alice");
+    uint32_t bob = table.intern("bob");
+    BOOST_CHECK(alice != bob);
+    BOOST_CHECK_EQUAL(table.intern("alice"), alice);
+    BOOST_CHECK_EQUAL(table.size(), 2U);
+
+    BOOST_CHECK(table.find("bob", handle));
+    BOOST_CHECK_EQUAL(handle, bob);
+    BOOST_CHECK(!table.find("carol", handle));
+    BOOST_CHECK_EQUAL(table.size(), 2U);
+
+    // resolved addresses remain valid, when more addresses are added
+    const std::string& resolved = table.resolve(alice);
+    for (int i = 0; i < 1000; ++i) {
+        table.intern(strprintf("address-%d", i));
+    }
+    BOOST_CHECK_EQUAL(resolved, "alice");
+    BOOST_CHECK_EQUAL(table.resolve(bob), "bob");
+    BOOST_CHECK_EQUAL(table.size(), 1002U);
+}
+
+BOOST_AUTO_TEST_CASE(holder_index)
+{
+    CMPAddressTable table;
+    const uint32_t alice = table.intern("alice");
+    const uint32_t bob = table.intern("bob");
+    const uint32_t carol = table.intern("carol");
+
+    CMPHolderIndex index;
+    BOOST_CHECK(index.getHolders(3) == nullptr);
+    BOOST_CHECK_EQUAL(index.getHolderCount(3), 0U);
+    BOOST_CHECK_EQUAL(index.getTotal(3), 0);
+
+    index.update(alice, 3, 0, 100);
+    index.update(bob, 3, 0, 50);
+    index.update(bob, 4, 0, 7);
+    BOOST_CHECK_EQUAL(index.getHolderCount(3), 2U);
+    BOOST_CHECK_EQUAL(index.getTotal(3), 150);
+    // holders are ordered by handle, and can be resumed after a handle
+    BOOST_CHECK_EQUAL(*index.getHolders(3)->begin(), alice);
+    BOOST_CHECK_EQUAL(*index.getHolders(3)->upper_bound(alice), bob);
+    BOOST_CHECK_EQUAL(index.getHolderCount(4), 1U);
+    BOOST_CHECK_EQUAL(index.getTotal(4), 7);
+
+    // unchanged amounts are ignored
+    index.update(carol, 3, 0, 0);
+    BOOST_CHECK_EQUAL(index.getHolderCount(3), 2U);
+
+    index.update(alice, 3, 100, 40);
+    BOOST_CHECK_EQUAL(index.getHolderCount(3), 2U);
+    BOOST_CHECK_EQUAL(index.getTotal(3), 90);
+
+    index.update(bob, 3, 50, 0);
+    BOOST_CHECK_EQUAL(index.getHolderCount(3), 1U);
+    BOOST_CHECK_EQUAL(index.getTotal(3), 40);
+    BOOST_CHECK(index.getHolders(3)->count(alice));
+    BOOST_CHECK(!index.getHolders(3)->count(bob));
+
+    index.update(alice, 3, 40, 0);
+    BOOST_CHECK(index.getHolders(3) == nullptr);
+    BOOST_CHECK_EQUAL(index.getTotal(3), 0);
+
+    index.clear();
+    BOOST_CHECK(index.getHolders(4) == nullptr);
+    BOOST_CHECK_EQUAL(index.getTotal(4), 0);
+}
+
+BOOST_AUTO_TEST_CASE(owned_tally)
+{
+    CMPTally tally;
+    BOOST_CHECK_EQUAL(tally.getMoneyOwned(1), 0);
+    BOOST_CHECK(tally.updateMoney(1, 5, BALANCE));
+    BOOST_CHECK(tally.updateMoney(1, 7, SELLOFFER_RESERVE));
+    BOOST_CHECK(tally.updateMoney(1, 11, ACCEPT_RESERVE));
+    BOOST_CHECK(tally.updateMoney(1, 13, METADEX_RESERVE));
+    BOOST_CHECK(tally.updateMoney(1, -3, PENDING));
+    BOOST_CHECK_EQUAL(tally.getMoneyOwned(1), 36);
+    BOOST_CHECK_EQUAL(tally.getMoneyOwned(2), 0);
+}
+
 
 BOOST_AUTO_TEST_SUITE_END()
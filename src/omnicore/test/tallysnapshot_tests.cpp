@@ -0,0 +1,68 @@
+#include <omnicore/omnicore.h>
+#include <omnicore/tally.h>
+#include <omnicore/tallysnapshot.h>
+
+#include <arith_uint256.h>
+#include <sync.h>
+#include <test/util/setup_common.h>
+#include <uint256.h>
+
+#include <stdint.h>
+#include <memory>
+#include <string>
+
+#include <boost/test/unit_test.hpp>
+
+using namespace mastercore;
+
+BOOST_FIXTURE_TEST_SUITE(omnicore_tallysnapshot_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(tallysnapshot_copy_on_write)
+{
+    LOCK(cs_tally);
+    ClearTallyMap();
+
+    const CMPTallySnapshot::FrozenSet frozen;
+    BOOST_CHECK(update_tally_map("Alice", 3, 100, BALANCE));
+    BOOST_CHECK(update_tally_map("Bob", 3, 50, BALANCE));
+    BOOST_CHECK(update_tally_map("Bob", 3, 20, METADEX_RESERVE));
+    PublishTallySnapshot(10, ArithToUint256(arith_uint256(10)), frozen);
+
+    std::shared_ptr<const CMPTallySnapshot> first = GetTallySnapshot();
+    BOOST_REQUIRE(first);
+    BOOST_CHECK_EQUAL(first->nBlock, 10);
+    BOOST_REQUIRE(first->getTally("Bob") != nullptr);
+    BOOST_CHECK_EQUAL(first->getTally("Bob")->getMoney(3, BALANCE), 50);
+    BOOST_CHECK_EQUAL(first->getTally("Bob")->getMoneyReserved(3), 20);
+    BOOST_CHECK(first->getTally("Carol") == nullptr);
+
+    // pending amounts don't trigger a new copy
+    BOOST_CHECK(update_tally_map("Alice", 3, 30, BALANCE));
+    BOOST_CHECK(update_tally_map("Bob", 3, -5, PENDING));
+    CMPTallySnapshot::FrozenSet frozenBob;
+    frozenBob.insert(std::make_pair(std::string("Bob"), 3U));
+    TallySnapshotMarkFrozenDirty();
+    PublishTallySnapshot(11, ArithToUint256(arith_uint256(11)), frozenBob);
+
+    std::shared_ptr<const CMPTallySnapshot> second = GetTallySnapshot();
+    BOOST_CHECK_EQUAL(second->nBlock, 11);
+    BOOST_CHECK_EQUAL(second->getTally("Alice")->getMoney(3, BALANCE), 130);
+    BOOST_CHECK(second->isAddressFrozen("Bob", 3));
+
+    // the previous snapshot is unchanged, and untouched shards are shared
+    BOOST_CHECK_EQUAL(first->getTally("Alice")->getMoney(3, BALANCE), 100);
+    BOOST_CHECK(!first->isAddressFrozen("Bob", 3));
+    const size_t nShardBob = CMPTallySnapshot::GetShardIndex("Bob");
+    if (nShardBob != CMPTallySnapshot::GetShardIndex("Alice")) {
+        BOOST_CHECK(first->vShards[nShardBob] == second->vShards[nShardBob]);
+    }
+    BOOST_CHECK(first->vShards[CMPTallySnapshot::GetShardIndex("Alice")] != second->vShards[CMPTallySnapshot::GetShardIndex("Alice")]);
+
+    // clearing the state copies everything again
+    ClearTallyMap();
+    PublishTallySnapshot(12, ArithToUint256(arith_uint256(12)), frozen);
+    BOOST_CHECK(GetTallySnapshot()->getTally("Alice") == nullptr);
+    BOOST_CHECK(second->getTally("Alice") != nullptr);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
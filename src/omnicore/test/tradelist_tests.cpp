@@ -0,0 +1,67 @@
+#include <omnicore/dbtradelist.h>
+
+#include <arith_uint256.h>
+#include <test/util/setup_common.h>
+#include <uint256.h>
+#include <util/system.h>
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(omnicore_tradelist_tests, BasicTestingSetup)
+
+static uint256 TestTxid(uint64_t n)
+{
+    return ArithToUint256(arith_uint256(n));
+}
+
+BOOST_AUTO_TEST_CASE(tradelist_address_history)
+{
+    CMPTradeList* pTradeList = new CMPTradeList(GetDataDir() / "MP_tradelist_test", true);
+
+    pTradeList->recordNewTrade(TestTxid(1), "Alice", 3, 1, 100, 2);
+    pTradeList->recordNewTrade(TestTxid(2), "Bob", 1, 3, 100, 3);
+    pTradeList->recordNewTrade(TestTxid(3), "Alice", 4, 1, 100, 10);
+    pTradeList->recordNewTrade(TestTxid(4), "Alice", 3, 1, 101, 1);
+    pTradeList->recordNewTrade(TestTxid(5), "Alicia", 3, 1, 102, 1);
+    pTradeList->recordMatchedTrade(TestTxid(1), TestTxid(2), "Alice", "Bob", 1, 3, 50, 50, 100, 3, 0);
+    BOOST_CHECK_EQUAL(pTradeList->getMPTradeCountTotal(), 6);
+
+    // most recent first, ordered by block and position in block
+    std::vector<uint256> vecTransactions;
+    pTradeList->getTradesForAddress("Alice", vecTransactions, 0, 10);
+    BOOST_REQUIRE_EQUAL(vecTransactions.size(), 3U);
+    BOOST_CHECK(vecTransactions[0] == TestTxid(4));
+    BOOST_CHECK(vecTransactions[1] == TestTxid(3));
+    BOOST_CHECK(vecTransactions[2] == TestTxid(1));
+
+    // limited by count
+    vecTransactions.clear();
+    pTradeList->getTradesForAddress("Alice", vecTransactions, 0, 2);
+    BOOST_REQUIRE_EQUAL(vecTransactions.size(), 2U);
+    BOOST_CHECK(vecTransactions[1] == TestTxid(3));
+
+    // filtered by property
+    vecTransactions.clear();
+    pTradeList->getTradesForAddress("Alice", vecTransactions, 4, 10);
+    BOOST_REQUIRE_EQUAL(vecTransactions.size(), 1U);
+    BOOST_CHECK(vecTransactions[0] == TestTxid(3));
+
+    // index entries are removed with the trades
+    BOOST_CHECK_EQUAL(pTradeList->deleteAboveBlock(101), 2);
+    BOOST_CHECK_EQUAL(pTradeList->getMPTradeCountTotal(), 4);
+    vecTransactions.clear();
+    pTradeList->getTradesForAddress("Alice", vecTransactions, 0, 10);
+    BOOST_REQUIRE_EQUAL(vecTransactions.size(), 2U);
+    BOOST_CHECK(vecTransactions[0] == TestTxid(3));
+    vecTransactions.clear();
+    pTradeList->getTradesForAddress("Alicia", vecTransactions, 0, 10);
+    BOOST_CHECK(vecTransactions.empty());
+
+    delete pTradeList;
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,101 @@
+#include <omnicore/dbtxlist.h>
+#include <omnicore/omnicore.h>
+
+#include <arith_uint256.h>
+#include <test/util/setup_common.h>
+#include <uint256.h>
+#include <util/system.h>
+
+#include <stdint.h>
+#include <set>
+#include <string>
+#include <utility>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(omnicore_txlist_tests, BasicTestingSetup)
+
+static uint256 TestTxid(uint64_t n)
+{
+    return ArithToUint256(arith_uint256(n));
+}
+
+BOOST_AUTO_TEST_CASE(txlist_records)
+{
+    CMPTxList* pTxList = new CMPTxList(GetDataDir() / "MP_txlist_test", true);
+
+    BOOST_CHECK_EQUAL(pTxList->setDBVersion(), DB_VERSION);
+
+    pTxList->recordTX(TestTxid(1), true, 100, 0, 5000);
+    pTxList->recordTX(TestTxid(2), false, 110, 4, 0);
+    pTxList->recordSendAllSubRecord(TestTxid(1), 1, 3, 250);
+    pTxList->RecordNonFungibleGrant(TestTxid(1), 11, 20);
+
+    BOOST_CHECK(pTxList->exists(TestTxid(1)));
+    BOOST_CHECK(!pTxList->exists(TestTxid(3)));
+    BOOST_CHECK_EQUAL(pTxList->getMPTransactionCountTotal(), 2);
+
+    int block = 0;
+    unsigned int type = 0;
+    uint64_t nValue = 0;
+    BOOST_CHECK(pTxList->getValidMPTX(TestTxid(1), &block, &type, &nValue));
+    BOOST_CHECK_EQUAL(block, 100);
+    BOOST_CHECK_EQUAL(type, 0U);
+    BOOST_CHECK_EQUAL(nValue, 5000U);
+    BOOST_CHECK(!pTxList->getValidMPTX(TestTxid(2), &block, &type));
+    BOOST_CHECK_EQUAL(block, 110);
+    BOOST_CHECK_EQUAL(type, 4U);
+
+    uint32_t propertyId = 0;
+    int64_t amount = 0;
+    BOOST_CHECK(pTxList->getSendAllDetails(TestTxid(1), 1, propertyId, amount));
+    BOOST_CHECK_EQUAL(propertyId, 3U);
+    BOOST_CHECK_EQUAL(amount, 250);
+    BOOST_CHECK(!pTxList->getSendAllDetails(TestTxid(1), 2, propertyId, amount));
+    BOOST_CHECK(pTxList->GetNonFungibleGrant(TestTxid(1)) == std::make_pair(int64_t(11), int64_t(20)));
+
+    // payments are counted per transaction
+    pTxList->recordPaymentTX(TestTxid(3), true, 120, 1, 3, 70, "buyer", "seller");
+    pTxList->recordPaymentTX(TestTxid(3), true, 120, 2, 3, 30, "buyer", "seller2");
+    BOOST_CHECK_EQUAL(pTxList->getNumberOfSubRecords(TestTxid(3)), 2);
+    std::string buyer, seller;
+    uint64_t vout = 0, paymentPropertyId = 0, paymentAmount = 0;
+    BOOST_CHECK(pTxList->getPurchaseDetails(TestTxid(3), 2, &buyer, &seller, &vout, &paymentPropertyId, &paymentAmount));
+    BOOST_CHECK_EQUAL(buyer, "buyer");
+    BOOST_CHECK_EQUAL(seller, "seller2");
+    BOOST_CHECK_EQUAL(vout, 2U);
+    BOOST_CHECK_EQUAL(paymentPropertyId, 3U);
+    BOOST_CHECK_EQUAL(paymentAmount, 30U);
+
+    // cancels refer to the cancelled orders
+    pTxList->recordMetaDExCancelTX(TestTxid(4), TestTxid(10), true, 130, 3, 40);
+    pTxList->recordMetaDExCancelTX(TestTxid(4), TestTxid(11), true, 130, 5, 60);
+    BOOST_CHECK_EQUAL(pTxList->getNumberOfMetaDExCancels(TestTxid(4)), 2);
+    uint256 cancelledTxid;
+    BOOST_CHECK(pTxList->getMetaDExCancelDetails(TestTxid(4), 2, cancelledTxid, propertyId, amount));
+    BOOST_CHECK(cancelledTxid == TestTxid(11));
+    BOOST_CHECK_EQUAL(propertyId, 5U);
+    BOOST_CHECK_EQUAL(amount, 60);
+    BOOST_CHECK(pTxList->findMetaDExCancel(TestTxid(10)) == TestTxid(4));
+    BOOST_CHECK(pTxList->findMetaDExCancel(TestTxid(12)).IsNull());
+
+    std::set<uint256> setTxs;
+    BOOST_CHECK_EQUAL(pTxList->GetOmniTxsInBlockRange(105, 130, setTxs), 3);
+    BOOST_CHECK((pTxList->GetSeedBlocks(0, 125) == std::set<int>{100, 110, 120}));
+
+    // all records of the rolled back transactions are deleted
+    BOOST_CHECK(pTxList->isMPinBlockRange(110, 999999, true));
+    BOOST_CHECK(!pTxList->isMPinBlockRange(110, 999999, false));
+    BOOST_CHECK(pTxList->exists(TestTxid(1)));
+    BOOST_CHECK(!pTxList->exists(TestTxid(2)));
+    BOOST_CHECK(!pTxList->exists(TestTxid(3)));
+    BOOST_CHECK(!pTxList->getPurchaseDetails(TestTxid(3), 1, &buyer, &seller, &vout, &paymentPropertyId, &paymentAmount));
+    BOOST_CHECK_EQUAL(pTxList->getNumberOfMetaDExCancels(TestTxid(4)), 0);
+    BOOST_CHECK(pTxList->findMetaDExCancel(TestTxid(10)).IsNull());
+    BOOST_CHECK_EQUAL(pTxList->getMPTransactionCountTotal(), 1);
+    BOOST_CHECK_EQUAL(pTxList->getDBVersion(), DB_VERSION);
+
+    delete pTxList;
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -21,6 +21,7 @@
 #include <omnicore/nftdb.h>
 #include <omnicore/utilsxep.h>
 #include <omnicore/version.h>
+#include <omnicore/walletfetchtxs.h>
 
 #include <amount.h>
 #include <base58.h>
@@ -1373,6 +1374,7 @@ int CMPTransaction::logicMath_SendToOwners()
 
         // add to stodb
         pDbStoList->recordSTOReceive(address, txid, block, property, will_really_receive);
+        WalletTxIndexStoReceived(address);
 
         if (sent_so_far != (int64_t)nValue) {
             PrintToLog("sent_so_far= %14d, nValue= %14d, n_owners= %d\n", sent_so_far, nValue, numberOfReceivers);
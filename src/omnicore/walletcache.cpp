@@ -21,76 +21,172 @@
 
 #include <stdint.h>
 #include <algorithm>
-#include <list>
-#include <map>
-#include <set>
+#include <atomic>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
 #include <utility>
 #include <vector>
 
 namespace mastercore
 {
-//! Map of wallet balances
-static std::map<std::string, CMPTally> walletBalancesCache;
+//! Map of wallet balances, keyed by address handle
+static std::unordered_map<uint32_t, CMPTally> walletBalancesCache;
+//! Addresses with updated balances, since the last update
+static std::unordered_set<uint32_t> setDirtyAddresses;
+//! Addresses, which belong to a wallet, keyed by address handle
+static std::unordered_map<uint32_t, int> mapAddressIsMine;
+#ifdef ENABLE_WALLET
+//! Number of wallets, when the ownership of addresses was cached
+static size_t nCachedWallets = 0;
+#endif
+//! Whether the next update examines all addresses
+static bool fFullUpdate = true;
+//! Whether cached balances were dropped, which the next update reports as change
+static bool fBalancesDropped = false;
+//! Whether keys or scripts were added to a wallet since the last update
+static std::atomic<bool> fWalletKeysChanged(false);
+
+/**
+ * Marks the balances of an address as updated.
+ *
+ * Nothing is tracked, until the cache was populated for the first time.
+ */
+void WalletCacheMarkDirty(uint32_t addressHandle)
+{
+    if (!fFullUpdate) {
+        setDirtyAddresses.insert(addressHandle);
+    }
+}
+
+/**
+ * Forces the next update to examine all addresses and to query the wallets
+ * again, whether they own an address.
+ *
+ * The cached balances are dropped as well, so addresses, which are no longer
+ * in the tally map, are not kept with their old balances.
+ */
+void WalletCacheInvalidate()
+{
+    fBalancesDropped |= !walletBalancesCache.empty();
+    walletBalancesCache.clear();
+    setDirtyAddresses.clear();
+    mapAddressIsMine.clear();
+    fFullUpdate = true;
+}
+
+/**
+ * Marks the ownership of addresses as changed, so the next update examines all
+ * addresses and queries the wallets again.
+ *
+ * This is called by the wallet notifications, which may hold the wallet lock, so
+ * only a flag is set, and cs_tally is not acquired.
+ */
+void WalletCacheKeysChanged()
+{
+    fWalletKeysChanged = true;
+}
+
+/**
+ * Returns whether an address belongs to any wallet (including watch only).
+ *
+ * Addresses, which belong to a wallet, are cached, until the number of loaded
+ * wallets changes, or the cache is invalidated. Other addresses are not cached,
+ * because they may be imported into a wallet at any time.
+ */
+static int IsMyAddressCached(uint32_t addressHandle)
+{
+#ifdef ENABLE_WALLET
+    size_t nWallets = GetWallets().size();
+    if (nWallets != nCachedWallets) {
+        mapAddressIsMine.clear();
+        nCachedWallets = nWallets;
+    }
+#endif
+
+    std::unordered_map<uint32_t, int>::const_iterator it = mapAddressIsMine.find(addressHandle);
+    if (it != mapAddressIsMine.end()) {
+        return it->second;
+    }
+
+    int addressIsMine = IsMyAddressAllWallets(mp_address_table.resolve(addressHandle), true);
+    if (addressIsMine) {
+        mapAddressIsMine.insert(std::make_pair(addressHandle, addressIsMine));
+    }
+
+    return addressIsMine;
+}
+
+/**
+ * Compares the balances of an address with the cache, and updates the cache,
+ * if they differ.
+ *
+ * @return True, if the address belongs to the wallet and the balances changed
+ */
+static bool UpdateCachedBalances(uint32_t addressHandle, const CMPTally& tally)
+{
+    const std::string& address = mp_address_table.resolve(addressHandle);
+
+    // determine if this address is in the wallet
+    if (!IsMyAddressCached(addressHandle)) {
+        if (msc_debug_walletcache) PrintToLog("WALLETCACHE: Ignoring non-wallet address %s\n", address);
+        return false; // ignore this address, not in wallet
+    }
+
+    // check cache for miss on address
+    std::unordered_map<uint32_t, CMPTally>::iterator search_it = walletBalancesCache.find(addressHandle);
+    if (search_it == walletBalancesCache.end()) { // cache miss, new address
+        walletBalancesCache.insert(std::make_pair(addressHandle, tally));
+        if (msc_debug_walletcache) PrintToLog("WALLETCACHE: *CACHE MISS* - %s not in cache\n", address);
+        return true;
+    }
+
+    // check cache for miss on balance
+    if (search_it->second != tally) {
+        search_it->second = tally;
+        if (msc_debug_walletcache) PrintToLog("WALLETCACHE: *CACHE MISS* - %s balance differs\n", address);
+        return true;
+    }
+
+    return false;
+}
 
 /**
  * Updates the cache with the latest state, returning true if changes were made to wallet addresses (including watch only).
  *
- * Also prepares a list of addresses that were changed (for future usage).
+ * The first update, and the first update after the cache was invalidated, or keys
+ * were added to a wallet, examine all addresses. Afterwards only addresses, whose
+ * balances were updated, are examined.
  */
 int WalletCacheUpdate()
 {
     if (msc_debug_walletcache) PrintToLog("WALLETCACHE: Update requested\n");
     int numChanges = 0;
-    std::set<std::string> changedAddresses;
 
     LOCK(cs_tally);
 
-    for (std::unordered_map<std::string, CMPTally>::iterator my_it = mp_tally_map.begin(); my_it != mp_tally_map.end(); ++my_it) {
-        const std::string& address = my_it->first;
-
-        // determine if this address is in the wallet
-        int addressIsMine = IsMyAddressAllWallets(address, true);
-        if (!addressIsMine) {
-            if (msc_debug_walletcache) PrintToLog("WALLETCACHE: Ignoring non-wallet address %s\n", address);
-            continue; // ignore this address, not in wallet
-        }
+    if (fWalletKeysChanged.exchange(false)) {
+        WalletCacheInvalidate();
+    }
 
-        // obtain & init the tally
-        CMPTally& tally = my_it->second;
-        tally.init();
-
-        // check cache for miss on address
-        std::map<std::string, CMPTally>::iterator search_it = walletBalancesCache.find(address);
-        if (search_it == walletBalancesCache.end()) { // cache miss, new address
-            ++numChanges;
-            changedAddresses.insert(address);
-            walletBalancesCache.insert(std::make_pair(address,tally));
-            if (msc_debug_walletcache) PrintToLog("WALLETCACHE: *CACHE MISS* - %s not in cache\n", address);
-            continue;
+    if (fFullUpdate) {
+        for (std::unordered_map<uint32_t, CMPTally>::const_iterator my_it = mp_tally_map.begin(); my_it != mp_tally_map.end(); ++my_it) {
+            if (UpdateCachedBalances(my_it->first, my_it->second)) ++numChanges;
         }
-
-        // check cache for miss on balance - TODO TRY AND OPTIMIZE THIS
-        CMPTally &cacheTally = search_it->second;
-        uint32_t propertyId;
-        while (0 != (propertyId = (tally.next()))) {
-            if (tally.getMoney(propertyId, BALANCE) != cacheTally.getMoney(propertyId, BALANCE) ||
-                    tally.getMoney(propertyId, PENDING) != cacheTally.getMoney(propertyId, PENDING) ||
-                    tally.getMoney(propertyId, SELLOFFER_RESERVE) != cacheTally.getMoney(propertyId, SELLOFFER_RESERVE) ||
-                    tally.getMoney(propertyId, ACCEPT_RESERVE) != cacheTally.getMoney(propertyId, ACCEPT_RESERVE) ||
-                    tally.getMoney(propertyId, METADEX_RESERVE) != cacheTally.getMoney(propertyId, METADEX_RESERVE)) { // cache miss, balance
-                ++numChanges;
-                changedAddresses.insert(address);
-                walletBalancesCache.erase(search_it);
-                walletBalancesCache.insert(std::make_pair(address,tally));
-                if (msc_debug_walletcache) PrintToLog("WALLETCACHE: *CACHE MISS* - %s balance for property %d differs\n", address, propertyId);
-                break;
-            }
+        if (fBalancesDropped && numChanges == 0) ++numChanges;
+        fBalancesDropped = false;
+        fFullUpdate = false;
+    } else {
+        for (std::unordered_set<uint32_t>::const_iterator it = setDirtyAddresses.begin(); it != setDirtyAddresses.end(); ++it) {
+            std::unordered_map<uint32_t, CMPTally>::const_iterator my_it = mp_tally_map.find(*it);
+            if (my_it == mp_tally_map.end()) continue;
+            if (UpdateCachedBalances(my_it->first, my_it->second)) ++numChanges;
         }
     }
+    setDirtyAddresses.clear();
+
     if (msc_debug_walletcache) PrintToLog("WALLETCACHE: Update finished - there were %d changes\n", numChanges);
     return numChanges;
 }
 
-
 } // namespace mastercore
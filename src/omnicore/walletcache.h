@@ -3,12 +3,22 @@
 
 class uint256;
 
+#include <stdint.h>
 #include <vector>
 
 namespace mastercore
 {
 /** Updates the cache and returns whether any wallet addresses were changed */
 int WalletCacheUpdate();
+
+/** Marks the balances of an address as updated, so they are examined by the next update */
+void WalletCacheMarkDirty(uint32_t addressHandle);
+
+/** Forces the next update to examine all addresses and to query the wallets again */
+void WalletCacheInvalidate();
+
+/** Marks the ownership of addresses as changed, after keys or scripts were added to a wallet */
+void WalletCacheKeysChanged();
 }
 
 #endif // XEP_OMNICORE_WALLETCACHE_H
@@ -8,132 +8,295 @@
 #include <omnicore/walletfetchtxs.h>
 
 #include <omnicore/dbstolist.h>
+#include <omnicore/dbtransaction.h>
 #include <omnicore/dbtxlist.h>
 #include <omnicore/log.h>
 #include <omnicore/omnicore.h>
 #include <omnicore/pending.h>
 #include <omnicore/utilsxep.h>
+#include <omnicore/walletutils.h>
 
+#include <chain.h>
 #include <init.h>
 #include <interfaces/wallet.h>
 #include <validation.h>
 #include <sync.h>
 #include <tinyformat.h>
-#include <index/txindex.h>
+#include <uint256.h>
 #ifdef ENABLE_WALLET
 #include <wallet/wallet.h>
 #endif
 
-#include <boost/algorithm/string.hpp>
-
 #include <stdint.h>
-#include <list>
 #include <map>
+#include <memory>
 #include <set>
 #include <string>
+#include <tuple>
 #include <utility>
 #include <vector>
 
 namespace mastercore
 {
+//! Omni transactions of a wallet, ordered by block height, position in block and hash
+typedef std::set<std::tuple<int, uint32_t, uint256> > WalletTxIndex;
+
+//! Guards the wallet transaction indexes
+static Mutex cs_wallet_txindex;
+//! Omni transaction indexes, keyed by wallet name; a wallet is only tracked, once it was queried
+static std::map<std::string, WalletTxIndex> mapWalletTxIndexes GUARDED_BY(cs_wallet_txindex);
+//! Transactions of the tracked wallets, which were added or changed since the last query
+static std::map<std::string, std::set<uint256> > mapChangedWalletTxs GUARDED_BY(cs_wallet_txindex);
+//! Addresses of the tracked wallets, which received STOs; a wallet without entry examines all STO recipients, when queried
+static std::map<std::string, std::set<std::string> > mapWalletStoRecipients GUARDED_BY(cs_wallet_txindex);
+//! Addresses, which received STOs since the last query, keyed by wallet name
+static std::map<std::string, std::set<std::string> > mapNewStoRecipients GUARDED_BY(cs_wallet_txindex);
+
+/**
+ * Records a changed transaction of a tracked wallet, which is indexed, when the wallet is queried again.
+ *
+ * This is called while the wallet is locked, so no other lock than the index mutex is acquired.
+ */
+void WalletTxIndexTransactionChanged(const std::string& walletName, const uint256& txid)
+{
+    LOCK(cs_wallet_txindex);
+    if (mapWalletTxIndexes.count(walletName)) {
+        mapChangedWalletTxs[walletName].insert(txid);
+    }
+}
+
+/**
+ * Records an address, which received an STO, so the tracked wallets examine it, when queried again.
+ */
+void WalletTxIndexStoReceived(const std::string& address)
+{
+    LOCK(cs_wallet_txindex);
+    for (const auto& entry : mapWalletStoRecipients) {
+        mapNewStoRecipients[entry.first].insert(address);
+    }
+}
+
+/**
+ * Records that keys or scripts were added to a wallet, so all STO recipients are examined again.
+ *
+ * This is called while the wallet is locked, so no other lock than the index mutex is acquired.
+ */
+void WalletTxIndexKeysChanged(const std::string& walletName)
+{
+    LOCK(cs_wallet_txindex);
+    mapWalletStoRecipients.erase(walletName);
+    mapNewStoRecipients.erase(walletName);
+}
+
+/**
+ * Removes the transactions of blocks above/equal to a specific block from all indexes.
+ *
+ * The STO recipients are kept, because receipts are looked up in the STO list.
+ */
+void WalletTxIndexRemoveAbove(int nBlock)
+{
+    LOCK(cs_wallet_txindex);
+    for (auto& entry : mapWalletTxIndexes) {
+        WalletTxIndex& index = entry.second;
+        index.erase(index.lower_bound(std::make_tuple(nBlock, 0U, uint256())), index.end());
+    }
+}
+
+/**
+ * Drops all indexes, so they are rebuilt from the wallets when queried again.
+ */
+void WalletTxIndexInvalidate()
+{
+    LOCK(cs_wallet_txindex);
+    mapWalletTxIndexes.clear();
+    mapChangedWalletTxs.clear();
+    mapWalletStoRecipients.clear();
+    mapNewStoRecipients.clear();
+}
+
+#ifdef ENABLE_WALLET
+/** Returns the sort key of a transaction, which is unique, even if positions collide. */
+static std::string GetSortKey(int blockHeight, int64_t blockPosition, const uint256& txid)
+{
+    return strprintf("%06d%010d%s", blockHeight, blockPosition, txid.GetHex());
+}
+
+/**
+ * Adds a wallet transaction to the index, if it's an Omni transaction, which is confirmed in the active chain.
+ *
+ * The same rule is applied, when the index is built, and when transactions of the wallet changed.
+ */
+static void AddToWalletTxIndex(const interfaces::WalletTx& wtx, WalletTxIndex& index)
+{
+    AssertLockHeld(cs_main);
+    AssertLockHeld(cs_tally);
+
+    if (!wtx.tx || wtx.hash_block.IsNull()) return;
+    const uint256& txHash = wtx.tx->GetHash();
+    if (!pDbTransactionList->exists(txHash)) return;
+    const CBlockIndex* pBlockIndex = LookupBlockIndex(wtx.hash_block);
+    if (pBlockIndex == nullptr || !::ChainActive().Contains(pBlockIndex)) return;
+    uint32_t blockPosition = pDbTransaction->FetchTransactionPosition(txHash);
+    index.insert(std::make_tuple(pBlockIndex->nHeight, blockPosition, txHash));
+}
+
+/**
+ * Builds or updates the index of a wallet.
+ *
+ * The index is built from all wallet transactions, when the wallet is queried the first
+ * time. Afterwards only the transactions, which were added or changed in the meantime,
+ * for example by a new block, an import or a rescan, are added. Disconnected blocks are
+ * removed by WalletTxIndexRemoveAbove(). cs_main is held, so no block is connected meanwhile.
+ */
+static void UpdateWalletTxIndex(interfaces::Wallet& iWallet)
+{
+    AssertLockHeld(cs_main);
+
+    const std::string walletName = iWallet.getWalletName();
+    bool fTracked;
+    std::set<uint256> setChanged;
+    {
+        LOCK(cs_wallet_txindex);
+        fTracked = mapWalletTxIndexes.count(walletName);
+        // changes are recorded from now on, so none is lost while the index is built
+        mapWalletTxIndexes[walletName];
+        mapChangedWalletTxs[walletName].swap(setChanged);
+    }
+
+    // the wallet is locked by these calls, so the index mutex isn't held
+    std::vector<interfaces::WalletTx> transactions;
+    if (!fTracked) {
+        transactions = iWallet.getWalletTxs();
+    } else {
+        for (const uint256& txid : setChanged) {
+            transactions.push_back(iWallet.getWalletTx(txid));
+        }
+    }
+    if (transactions.empty()) return;
+
+    WalletTxIndex added;
+    {
+        LOCK(cs_tally);
+        for (const interfaces::WalletTx& wtx : transactions) {
+            AddToWalletTxIndex(wtx, added);
+        }
+    }
+
+    LOCK(cs_wallet_txindex);
+    mapWalletTxIndexes[walletName].insert(added.begin(), added.end());
+}
+
 /**
- * Gets the byte offset of a transaction from the transaction index.
+ * Updates the addresses of a wallet, which received STOs.
+ *
+ * All STO recipients are examined, when the wallet is queried the first time, or after
+ * keys were added. Afterwards only addresses, which received STOs in the meantime, are
+ * examined. cs_main is held, so no STO is recorded meanwhile.
  */
-static unsigned int GetTransactionByteOffset(const uint256& txid)
+static void UpdateWalletStoRecipients(interfaces::Wallet& iWallet)
 {
-    LOCK(cs_main);
+    AssertLockHeld(cs_main);
+
+    const std::string walletName = iWallet.getWalletName();
+    bool fTracked;
+    std::set<std::string> setNew;
+    {
+        LOCK(cs_wallet_txindex);
+        fTracked = mapWalletStoRecipients.count(walletName);
+        // recipients are recorded from now on
+        mapWalletStoRecipients[walletName];
+        mapNewStoRecipients[walletName].swap(setNew);
+    }
+
+    std::vector<std::string> vCandidates;
+    if (!fTracked) {
+        LOCK(cs_tally);
+        vCandidates = pDbStoList->getRecipientAddresses();
+    } else {
+        vCandidates.assign(setNew.begin(), setNew.end());
+    }
 
-    if (g_txindex) {
-        return g_txindex->ReadTxPos(txid);
+    // the wallet is locked by these calls, so the index mutex isn't held
+    std::set<std::string> setMine;
+    for (const std::string& address : vCandidates) {
+        if (IsMyAddress(address, &iWallet)) setMine.insert(address);
     }
+    if (setMine.empty()) return;
 
-    return 0;
+    LOCK(cs_wallet_txindex);
+    // keys may have changed meanwhile, in which case all recipients are examined again
+    auto it = mapWalletStoRecipients.find(walletName);
+    if (it != mapWalletStoRecipients.end()) {
+        it->second.insert(setMine.begin(), setMine.end());
+    }
 }
+#endif
 
 /**
  * Returns an ordered list of Omni transactions including STO receipts that are relevant to the wallet.
  *
  * Ignores order in the wallet (which can be skewed by watch addresses) and utilizes block height and position within block.
+ * Only the count most recent transactions within the block range are returned.
  */
 std::map<std::string, uint256> FetchWalletOmniTransactions(interfaces::Wallet& iWallet, unsigned int count, int startBlock, int endBlock)
 {
     std::map<std::string, uint256> mapResponse;
 #ifdef ENABLE_WALLET
-    if (!HasWallets()) {
+    if (!HasWallets() || count == 0) {
         return mapResponse;
     }
+    {
+        LOCK(cs_main);
+        UpdateWalletTxIndex(iWallet);
+        UpdateWalletStoRecipients(iWallet);
+    }
+
+    // Walk backwards from the end of the block range until we have count items to return:
     std::set<uint256> seenHashes;
-    std::multimap<int64_t, const interfaces::WalletTx*> txOrdered;
-    const std::vector<interfaces::WalletTx>& transactions = iWallet.getWalletTxs();
-    for (const auto& transaction : transactions)
-        txOrdered.insert(std::make_pair(transaction.order_pos, &transaction));
-
-    // Iterate backwards through wallet transactions until we have count items to return:
-    for (std::multimap<int64_t, const interfaces::WalletTx*>::reverse_iterator it = txOrdered.rbegin(); it != txOrdered.rend(); ++it) {
-        const interfaces::WalletTx* pwtx = it->second;
-        const uint256& txHash = pwtx->tx->GetHash();
-        {
-            LOCK(cs_tally);
-            if (!pDbTransactionList->exists(txHash)) continue;
+    std::set<std::string> setStoRecipients;
+    {
+        LOCK(cs_wallet_txindex);
+        setStoRecipients = mapWalletStoRecipients[iWallet.getWalletName()];
+        const WalletTxIndex& index = mapWalletTxIndexes[iWallet.getWalletName()];
+        auto it = index.lower_bound(std::make_tuple(endBlock + 1, 0U, uint256()));
+        while (it != index.begin() && mapResponse.size() < count) {
+            --it;
+            const int blockHeight = std::get<0>(*it);
+            const uint256& txHash = std::get<2>(*it);
+            if (blockHeight < startBlock) break;
+            mapResponse.insert(std::make_pair(GetSortKey(blockHeight, std::get<1>(*it), txHash), txHash));
+            seenHashes.insert(txHash);
         }
-        const uint256& blockHash = pwtx->hash_block;
-        if (blockHash.IsNull()) continue;
-        const CBlockIndex* pBlockIndex = GetBlockIndex(blockHash);
-        if (pBlockIndex == nullptr) continue;
-        int blockHeight = pBlockIndex->nHeight;
-        if (blockHeight < startBlock || blockHeight > endBlock) continue;
-        int blockPosition = GetTransactionByteOffset(txHash);
-        std::string sortKey = strprintf("%06d%010d", blockHeight, blockPosition);
-        mapResponse.insert(std::make_pair(sortKey, txHash));
-        seenHashes.insert(txHash);
-        if (mapResponse.size() >= count) break;
     }
 
     // Insert STO receipts - receiving an STO has no inbound transaction to the wallet, so we will insert these manually into the response
-    std::string mySTOReceipts;
-    {
+    if (!setStoRecipients.empty()) {
         LOCK(cs_tally);
-        mySTOReceipts = pDbStoList->getMySTOReceipts("", iWallet);
-    }
-    std::vector<std::string> vecReceipts;
-    if (!mySTOReceipts.empty()) {
-        boost::split(vecReceipts, mySTOReceipts, boost::is_any_of(","), boost::token_compress_on);
-    }
-    for (size_t i = 0; i < vecReceipts.size(); i++) {
-        std::vector<std::string> svstr;
-        boost::split(svstr, vecReceipts[i], boost::is_any_of(":"), boost::token_compress_on);
-        if (svstr.size() != 4) {
-            PrintToLog("STODB Error - number of tokens is not as expected (%s)\n", vecReceipts[i]);
-            continue;
+        for (const CMPSTOList::Receipt& receipt : pDbStoList->getReceipts(setStoRecipients, startBlock, endBlock)) {
+            if (seenHashes.find(receipt.txid) != seenHashes.end()) continue; // an STO may already be in the wallet if we sent it
+            uint32_t blockPosition = pDbTransaction->FetchTransactionPosition(receipt.txid);
+            mapResponse.insert(std::make_pair(GetSortKey(receipt.block, blockPosition, receipt.txid), receipt.txid));
         }
-        int blockHeight = atoi(svstr[1]);
-        if (blockHeight < startBlock || blockHeight > endBlock) continue;
-        uint256 txHash = uint256S(svstr[0]);
-        if (seenHashes.find(txHash) != seenHashes.end()) continue; // an STO may already be in the wallet if we sent it
-        int blockPosition = GetTransactionByteOffset(txHash);
-        std::string sortKey = strprintf("%06d%010d", blockHeight, blockPosition);
-        mapResponse.insert(std::make_pair(sortKey, txHash));
     }
 
     // Insert pending transactions (sets block as 999999 and position as wallet position)
     // TODO: resolve potential deadlock caused by cs_wallet, cs_pending
     // LOCK(cs_pending);
-    for (PendingMap::const_iterator it = my_pending.begin(); it != my_pending.end(); ++it) {
-        const uint256& txHash = it->first;
-        int blockHeight = 999999;
-        if (blockHeight < startBlock || blockHeight > endBlock) continue;
-        int blockPosition = 0;
-        {
-            for (const auto& transaction : transactions)
-                if (transaction.tx->GetHash() == txHash)
-                    blockPosition = transaction.order_pos;
+    if (999999 >= startBlock && 999999 <= endBlock) {
+        for (PendingMap::const_iterator it = my_pending.begin(); it != my_pending.end(); ++it) {
+            const uint256& txHash = it->first;
+            const interfaces::WalletTx wtx = iWallet.getWalletTx(txHash);
+            int64_t blockPosition = wtx.tx ? wtx.order_pos : 0;
+            mapResponse.insert(std::make_pair(GetSortKey(999999, blockPosition, txHash), txHash));
         }
-        std::string sortKey = strprintf("%06d%010d", blockHeight, blockPosition);
-        mapResponse.insert(std::make_pair(sortKey, txHash));
+    }
+
+    // Drop the oldest entries, if there are more than requested
+    while (mapResponse.size() > count) {
+        mapResponse.erase(mapResponse.begin());
     }
 #endif
     return mapResponse;
 }
 
-
 } // namespace mastercore
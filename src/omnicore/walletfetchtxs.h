@@ -8,11 +8,27 @@ namespace interfaces {
 class Wallet;
 } // namespace interfaces
 
+#include <stdint.h>
 #include <map>
 #include <string>
 
 namespace mastercore
 {
+/** Records an added or changed wallet transaction, so it's indexed when the wallet is queried again */
+void WalletTxIndexTransactionChanged(const std::string& walletName, const uint256& txid);
+
+/** Records an address, which received an STO, so it's examined when the wallets are queried again */
+void WalletTxIndexStoReceived(const std::string& address);
+
+/** Records that keys or scripts were added to a wallet, so all STO recipients are examined again */
+void WalletTxIndexKeysChanged(const std::string& walletName);
+
+/** Removes the transactions of blocks above/equal to a specific block from the wallet transaction indexes */
+void WalletTxIndexRemoveAbove(int nBlock);
+
+/** Drops the wallet transaction indexes, so they are rebuilt when queried again */
+void WalletTxIndexInvalidate();
+
 /** Returns an ordered list of Omni transactions that are relevant to the wallet. */
 std::map<std::string, uint256> FetchWalletOmniTransactions(interfaces::Wallet& iWallet, unsigned int count, int startBlock = 0, int endBlock = 999999);
 }
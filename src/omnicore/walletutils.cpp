@@ -5,10 +5,13 @@
 #include <omnicore/rules.h>
 #include <omnicore/script.h>
 #include <omnicore/utilsxep.h>
+#include <omnicore/walletcache.h>
+#include <omnicore/walletfetchtxs.h>
 
 #include <amount.h>
 #include <base58.h>
 #include <init.h>
+#include <interfaces/handler.h>
 #include <interfaces/wallet.h>
 #include <key_io.h>
 #include <validation.h>
@@ -28,10 +31,92 @@
 #include <stdint.h>
 #include <algorithm>
 #include <map>
+#include <memory>
 #include <string>
+#include <utility>
+#include <vector>
 
 namespace mastercore
 {
+#ifdef ENABLE_WALLET
+//! Guards the handlers of the wallet notifications
+static Mutex cs_wallet_handlers;
+//! Handlers of the wallet notifications, keyed by wallet name
+static std::map<std::string, std::vector<std::unique_ptr<interfaces::Handler> > > mapWalletHandlers GUARDED_BY(cs_wallet_handlers);
+//! Handler, which connects to wallets, when they are loaded
+static std::unique_ptr<interfaces::Handler> handlerLoadWallet GUARDED_BY(cs_wallet_handlers);
+
+/**
+ * Connects to the notifications of a wallet, which affect the wallet caches and
+ * the wallet transaction index.
+ *
+ * The notifications are sent while the wallet is locked, so the handlers only
+ * mark the caches as outdated, or record the changed transaction, and don't
+ * acquire any other locks.
+ */
+static void ConnectWalletNotifications(interfaces::Wallet& iWallet)
+{
+    const std::string walletName = iWallet.getWalletName();
+    std::vector<std::unique_ptr<interfaces::Handler> > handlers;
+    // transactions were added or confirmed, also by imports and rescans
+    handlers.push_back(iWallet.handleTransactionChanged([walletName](const uint256& txid, ChangeType status) {
+        WalletTxIndexTransactionChanged(walletName, txid);
+    }));
+    // scripts were imported as watch-only, or keys were imported with a label
+    handlers.push_back(iWallet.handleWatchOnlyChanged([walletName](bool have_watch_only) {
+        WalletCacheKeysChanged();
+        WalletTxIndexKeysChanged(walletName);
+    }));
+    handlers.push_back(iWallet.handleAddressBookChanged([walletName](const CTxDestination& address, const std::string& label, bool is_mine, const std::string& purpose, ChangeType status) {
+        if (status == CT_NEW) {
+            WalletCacheKeysChanged();
+            WalletTxIndexKeysChanged(walletName);
+        }
+    }));
+
+    LOCK(cs_wallet_handlers);
+    mapWalletHandlers[walletName].swap(handlers);
+}
+#endif
+
+/**
+ * Connects to the notifications of the loaded wallets, and of wallets, which
+ * are loaded later.
+ */
+void RegisterWalletNotifications()
+{
+#ifdef ENABLE_WALLET
+    // the handler is called while the wallets are locked, so it's created and destroyed without holding cs_wallet_handlers
+    std::unique_ptr<interfaces::Handler> handler = HandleLoadWallet([](std::unique_ptr<interfaces::Wallet> wallet) {
+        ConnectWalletNotifications(*wallet);
+        WalletCacheKeysChanged();
+    });
+    {
+        LOCK(cs_wallet_handlers);
+        handlerLoadWallet.swap(handler);
+    }
+    for (const std::shared_ptr<CWallet>& wallet : GetWallets()) {
+        ConnectWalletNotifications(*interfaces::MakeWallet(wallet));
+    }
+#endif
+}
+
+/**
+ * Disconnects from the wallet notifications.
+ */
+void UnregisterWalletNotifications()
+{
+#ifdef ENABLE_WALLET
+    std::unique_ptr<interfaces::Handler> handler;
+    {
+        LOCK(cs_wallet_handlers);
+        handler.swap(handlerLoadWallet);
+        mapWalletHandlers.clear();
+    }
+    handler.reset();
+#endif
+}
+
 /**
  * Retrieves a public key from the wallet, or converts a hex-string to a public key.
  */
@@ -39,6 +39,12 @@ CAmount GetEstimatedFeePerKb(interfaces::Wallet& iWallet);
 * require more fees to pay than the output is worth. */
 int64_t GetEconomicThreshold(interfaces::Wallet& iWallet, const CTxOut& txOut);
 
+/** Connects to the notifications of loaded wallets, and wallets loaded later, which affect the wallet caches. */
+void RegisterWalletNotifications();
+
+/** Disconnects from the wallet notifications. */
+void UnregisterWalletNotifications();
+
 #ifdef ENABLE_WALLET
 /** Selects spendable outputs to create a transaction. */
 int64_t SelectCoins(interfaces::Wallet& iWallet, const std::string& fromAddress, CCoinControl& coinControl, int64_t amountRequired = 0);
@@ -137,15 +137,15 @@ void MetaDExDialog::PopulateAddresses()
         uint32_t propertyId = GetPropForSale();
         QString currentSetAddress = ui->comboAddress->currentText();
         ui->comboAddress->clear();
-        for (std::unordered_map<std::string, CMPTally>::iterator my_it = mp_tally_map.begin(); my_it != mp_tally_map.end(); ++my_it) {
-            std::string address = (my_it->first).c_str();
+        for (std::unordered_map<uint32_t, CMPTally>::iterator my_it = mp_tally_map.begin(); my_it != mp_tally_map.end(); ++my_it) {
+            std::string address = mp_address_table.resolve(my_it->first);
             int isMyAddress = IsMyAddress(address, &walletModel->wallet());
             uint32_t id;
             (my_it->second).init();
             while (0 != (id = (my_it->second).next())) {
                 if (id == propertyId) {
                     if (!GetAvailableTokenBalance(address, propertyId)) continue; // ignore this address, has no available balance to spend
-                    if (isMyAddress) ui->comboAddress->addItem((my_it->first).c_str()); // only include wallet addresses
+                    if (isMyAddress) ui->comboAddress->addItem(address.c_str()); // only include wallet addresses
                 }
             }
         }
@@ -164,8 +164,11 @@ void MetaDExDialog::UpdateProperties()
     ui->comboPairTokenA->clear();
     ui->comboPairTokenB->clear();
 
+    uint32_t lastPropertyId = 0;
     for (md_PropertiesMap::iterator my_it = metadex.begin(); my_it != metadex.end(); ++my_it) {
-        uint32_t propertyId = my_it->first;
+        uint32_t propertyId = my_it->first.first;
+        if (propertyId == lastPropertyId) continue; // order books are sorted by property for sale, list each property once
+        lastPropertyId = propertyId;
         if ((testEco && !isTestEcosystemProperty(propertyId)) || (!testEco && isTestEcosystemProperty(propertyId))) continue;
         std::string spName;
         spName = getPropertyName(propertyId).c_str();
@@ -349,7 +352,7 @@ void MetaDExDialog::UpdateOffers()
     bool divisDes = isPropertyDivisible(GetPropDesired());
 
     for (md_PropertiesMap::iterator my_it = metadex.begin(); my_it != metadex.end(); ++my_it) {
-        if ((my_it->first != GetPropForSale())) continue; // not the property we're looking for, don't waste any more work
+        if ((my_it->first.first != GetPropForSale())) continue; // not the property we're looking for, don't waste any more work
         md_PricesMap & prices = my_it->second;
         for (md_PricesMap::iterator it = prices.begin(); it != prices.end(); ++it) { // loop through the sell prices for the property
             std::string unitPriceStr;
@@ -193,8 +193,8 @@ void SendMPDialog::updateProperty()
     QString spId = ui->propertyComboBox->itemData(ui->propertyComboBox->currentIndex()).toString();
     uint32_t propertyId = spId.toUInt();
     LOCK(cs_tally);
-    for (std::unordered_map<std::string, CMPTally>::iterator my_it = mp_tally_map.begin(); my_it != mp_tally_map.end(); ++my_it) {
-        std::string address = (my_it->first).c_str();
+    for (std::unordered_map<uint32_t, CMPTally>::iterator my_it = mp_tally_map.begin(); my_it != mp_tally_map.end(); ++my_it) {
+        std::string address = mp_address_table.resolve(my_it->first);
         uint32_t id = 0;
         bool includeAddress=false;
         (my_it->second).init();
@@ -194,12 +194,16 @@ static const CRPCConvertParam vRPCConvertParams[] =
     { "omni_getcrowdsale", 1, "verbose" },
     { "omni_getgrants", 0, "propertyid" },
     { "omni_getbalance", 1, "propertyid" },
+    { "omni_getbalances", 0, "addresses" },
+    { "omni_getbalances", 1, "propertyids" },
     { "omni_getproperty", 0, "propertyid" },
     { "omni_listtransactions", 1, "count" },
     { "omni_listtransactions", 2, "skip" },
     { "omni_listtransactions", 3, "startblock" },
     { "omni_listtransactions", 4, "endblock" },
     { "omni_getallbalancesforid", 0, "propertyid" },
+    { "omni_listbalancesforid", 0, "propertyid" },
+    { "omni_listbalancesforid", 1, "count" },
     { "omni_listblocktransactions", 0, "index" },
     { "omni_listblockstransactions", 0, "firstblock" },
     { "omni_listblockstransactions", 1, "lastblock" },
@@ -207,6 +211,8 @@ static const CRPCConvertParam vRPCConvertParams[] =
     { "omni_getorderbook", 1, "propertyid" },
     { "omni_getseedblocks", 0, "startblock" },
     { "omni_getseedblocks", 1, "endblock" },
+    { "omni_exportseedblocks", 0, "startblock" },
+    { "omni_exportseedblocks", 1, "endblock" },
     { "omni_getmetadexhash", 0, "propertyid" },
     { "omni_getfeecache", 0, "propertyid" },
     { "omni_getfeeshare", 1, "ecosystem" },